@@ -1065,7 +1065,75 @@ enum CXTranslationUnit_Flags {
    * included into the set of code completions returned from this translation
    * unit.
    */
-  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80
+  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80,
+
+  /**
+   * \brief Used to indicate that function bodies should not be parsed up
+   * front, but only when a client first needs them, e.g. by visiting the
+   * children of the function or asking for a cursor within it.
+   *
+   * This gives most of the speed of \c CXTranslationUnit_SkipFunctionBodies
+   * to clients that only occasionally need the contents of a body.
+   *
+   * A body is still parsed during the parse, before the first declaration
+   * that follows it and declares a name it mentions, so it means the same as
+   * if it had been parsed up front. Some declarations, e.g. using-directives,
+   * operators and definitions of classes declared before, have all pending
+   * bodies parsed. In C, bodies with a call whose callee names no declaration
+   * in scope are parsed up front, as are bodies within the scope of a
+   * \#pragma pack, ms_struct or GCC visibility.
+   *
+   * The diagnostics of a body that is never parsed are missing, including
+   * those that are only reported at the end of the translation unit, such as
+   * uses of undefined internal functions. The declarations such a body
+   * mentions by name are not reported as unused.
+   *
+   * A function that reads the translation unit parses the bodies in the
+   * region it reads before it starts, e.g. the children of the parent cursor
+   * of \c clang_visitChildren(). Calls made from within a visitor callback
+   * don't parse any body, and only see those their enclosing call parsed.
+   */
+  CXTranslationUnit_LazyFunctionBodies = 0x100,
+
+  /**
+   * \brief Used to indicate that reparsing the translation unit should only
+   * parse the function bodies of the main file that changed.
+   *
+   * As long as nothing outside the function bodies of the main file changes,
+   * the bodies whose text is unchanged are parsed only when a client visits
+   * them, and keep the diagnostics reported the last time they were parsed.
+   * Any other change results in a full reparse. This implies
+   * \c CXTranslationUnit_LazyFunctionBodies.
+   */
+  CXTranslationUnit_IncrementalFunctionBodies = 0x200,
+
+  /**
+   * \brief Used to indicate that the translation unit will be queried from
+   * several threads at once.
+   *
+   * Normally a translation unit must only be used by one thread at a time.
+   * With this flag, the following functions may run concurrently on the
+   * same translation unit, including from within visitor callbacks:
+   * \c clang_getCursor(), \c clang_getLocation(), \c clang_visitChildren(),
+   * \c clang_tokenize(), \c clang_annotateTokens(),
+   * \c clang_findReferencesInFile(), \c clang_getCursorType(),
+   * \c clang_getCursorUSR() and the functions that only inspect a cursor,
+   * type, or source location. Any other function on the translation unit,
+   * such as \c clang_reparseTranslationUnit(), waits until those calls have
+   * returned, and must therefore not be called from a visitor callback.
+   * The exception is \c clang_disposeTranslationUnit(): the client must make
+   * sure that no other call on the translation unit is running or starts
+   * while it is being disposed.
+   *
+   * To make this possible, everything these queries would otherwise load or
+   * build on first use is loaded or built after each parse, so parsing takes
+   * longer and uses more memory. This overrides
+   * \c CXTranslationUnit_LazyFunctionBodies and
+   * \c CXTranslationUnit_IncrementalFunctionBodies. Setting the
+   * \c LIBCLANG_TIMING environment variable reports how often the queries
+   * had to wait for each other when the translation unit is disposed.
+   */
+  CXTranslationUnit_ConcurrentQueries = 0x400
 };
 
 /**
@@ -1221,6 +1289,9 @@ CINDEX_LINKAGE int clang_saveTranslationUnit(CXTranslationUnit TU,
 
 /**
  * \brief Destroy the specified CXTranslationUnit object.
+ *
+ * No other call on the translation unit may run concurrently with this one,
+ * even if it was created with \c CXTranslationUnit_ConcurrentQueries.
  */
 CINDEX_LINKAGE void clang_disposeTranslationUnit(CXTranslationUnit);
 
@@ -4622,6 +4693,45 @@ CINDEX_LINKAGE
 void clang_sortCodeCompletionResults(CXCompletionResult *Results,
                                      unsigned NumResults);
   
+/**
+ * \brief Flags that can be passed to \c clang_codeCompleteFilterResults() to
+ * modify its behavior.
+ */
+enum CXCodeCompleteFilter_Flags {
+  /**
+   * \brief Whether to also match results whose typed text contains the
+   * characters of the filter in order, starting with the first, rather than
+   * only results whose typed text starts with the filter.
+   */
+  CXCodeCompleteFilter_Fuzzy = 0x01
+};
+
+/**
+ * \brief Narrow code-completion results down to those whose typed text
+ * matches the text typed since code completion was performed.
+ *
+ * This allows a client to perform code completion once, at the start of an
+ * identifier, and then update the results as the user keeps typing that
+ * identifier without running code completion again. The first call
+ * remembers the complete set of results and reorders it by priority, with
+ * results of the same priority keeping their relative order. Each call then
+ * replaces the contents of \c Results->Results with the matching results, in
+ * that order. Matching is case-insensitive. When \p filter extends the
+ * previous filter, only the previous matches are considered.
+ *
+ * \param Results The code-completion results to filter.
+ *
+ * \param filter The text typed since code completion was performed. An
+ * empty filter restores all of the results.
+ *
+ * \param options A bitwise OR of the enumerators of the
+ * CXCodeCompleteFilter_Flags enumeration.
+ */
+CINDEX_LINKAGE
+void clang_codeCompleteFilterResults(CXCodeCompleteResults *Results,
+                                     const char *filter,
+                                     unsigned options);
+
 /**
  * \brief Free the given set of code-completion results.
  */
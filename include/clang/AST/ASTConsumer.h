@@ -25,6 +25,7 @@ namespace clang {
   class TagDecl;
   class VarDecl;
   class FunctionDecl;
+  class SourceRange;
 
 /// ASTConsumer - This is an abstract interface that should be implemented by
 /// clients that read ASTs.  This abstraction layer allows the client to be
@@ -94,6 +95,12 @@ public:
   // variable has been instantiated.
   virtual void HandleCXXStaticMemberVarInstantiation(VarDecl *D) {}
 
+  /// \brief In lazy-body mode, the parser has cached the tokens of the body
+  /// of \p FD, which spans \p BodyRange, and asks whether to leave it for
+  /// parsing on demand. Returning false has the body parsed right away.
+  virtual bool shouldParseFunctionBodyLazily(FunctionDecl *FD,
+                                             SourceRange BodyRange);
+
   /// \brief Callback involved at the end of a translation unit to
   /// notify the consumer that a vtable for the given C++ class is
   /// required.
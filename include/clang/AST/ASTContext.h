@@ -69,6 +69,7 @@ namespace clang {
   class ObjCPropertyDecl;
   class ParmVarDecl;
   class RecordDecl;
+  class RedeclarableTemplateDecl;
   class StoredDeclsMap;
   class TagDecl;
   class TemplateTemplateParmDecl;
@@ -406,10 +407,55 @@ public:
     return BumpAlloc;
   }
 
-  void *Allocate(unsigned Size, unsigned Align = 8) const {
+  /// \brief The kinds of AST node whose memory is accounted separately.
+  enum AllocationCategory {
+    AC_Other,
+    AC_Type,
+    AC_Decl,
+    AC_Stmt,
+    NumAllocationCategories
+  };
+
+  /// \brief The subsystems on whose behalf AST memory is allocated.
+  enum AllocationOwner {
+    AO_Other,
+    AO_Parse,
+    AO_Sema,
+    AO_TemplateInstantiation,
+    AO_Serialization,
+    NumAllocationOwners
+  };
+
+  void *Allocate(unsigned Size, unsigned Align = 8,
+                 AllocationCategory Category = AC_Other) const {
+    if (AllocationStatisticsEnabled)
+      noteAllocation(Size, Category);
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
+
+  /// \brief Make \p Owner the subsystem that subsequent allocations are
+  /// attributed to.
+  ///
+  /// \returns the previous owner, which the caller is expected to restore.
+  AllocationOwner setAllocationOwner(AllocationOwner Owner) const {
+    AllocationOwner Old = CurrentAllocationOwner;
+    CurrentAllocationOwner = Owner;
+    return Old;
+  }
+
+  /// \brief RAII object that attributes the AST allocations made during its
+  /// lifetime to a given subsystem.
+  class AllocationOwnerRAII {
+    const ASTContext &Context;
+    AllocationOwner OldOwner;
+
+  public:
+    AllocationOwnerRAII(const ASTContext &Context, AllocationOwner Owner)
+      : Context(Context), OldOwner(Context.setAllocationOwner(Owner)) { }
+
+    ~AllocationOwnerRAII() { Context.setAllocationOwner(OldOwner); }
+  };
   
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
@@ -737,6 +783,10 @@ public:
   void PrintStats() const;
   const std::vector<Type*>& getTypes() const { return Types; }
 
+  /// \brief Start collecting per-subsystem allocation statistics for all
+  /// AST contexts, which are reported by PrintStats().
+  static void EnableAllocationStatistics();
+
   /// \brief Retrieve the declaration for the 128-bit signed integer type.
   TypedefDecl *getInt128Decl() const;
 
@@ -2025,8 +2075,58 @@ public:
   /// \brief The number of implicitly-declared destructors for which 
   /// declarations were built.
   static unsigned NumImplicitDestructorsDeclared;
-  
+
+  /// \brief The number of lookups in the specialization tables of
+  /// function and class templates.
+  static unsigned NumTemplateSpecializationLookups;
+
+  /// \brief The number of lookups in the specialization tables of
+  /// function and class templates that found an existing specialization.
+  static unsigned NumTemplateSpecializationLookupHits;
+
+  /// \brief Note that the given template has allocated its specialization
+  /// tables, so that it can be reported by PrintStats().
+  void addSpecializableTemplate(RedeclarableTemplateDecl *Template) {
+    SpecializableTemplates.push_back(Template);
+  }
+
 private:
+  /// \brief The function and class templates that have specialization
+  /// tables, in the order those tables were created.
+  SmallVector<RedeclarableTemplateDecl *, 16> SpecializableTemplates;
+
+  /// \brief Print the templates with the most specializations.
+  void PrintTemplateSpecializationStats() const;
+
+  /// \brief The subsystem that allocations are currently attributed to.
+  mutable AllocationOwner CurrentAllocationOwner;
+
+  /// \brief The number of allocations and bytes requested from \c BumpAlloc,
+  /// broken down by owning subsystem and category.
+  ///
+  /// Only maintained when \c AllocationStatisticsEnabled is set.
+  struct AllocationCounts {
+    AllocationCounts() : NumAllocations(0), NumBytes(0) { }
+
+    uint64_t NumAllocations;
+    uint64_t NumBytes;
+  };
+  mutable AllocationCounts
+    AllocationStats[NumAllocationOwners][NumAllocationCategories];
+
+  /// \brief Whether per-subsystem allocation statistics are collected.
+  static bool AllocationStatisticsEnabled;
+
+  void noteAllocation(unsigned Size, AllocationCategory Category) const {
+    AllocationCounts &Counts
+      = AllocationStats[CurrentAllocationOwner][Category];
+    ++Counts.NumAllocations;
+    Counts.NumBytes += Size;
+  }
+
+  /// \brief Print the per-subsystem allocation statistics.
+  void PrintAllocationStats() const;
+
   ASTContext(const ASTContext &) LLVM_DELETED_FUNCTION;
   void operator=(const ASTContext &) LLVM_DELETED_FUNCTION;
 
@@ -2099,6 +2199,21 @@ static inline Selector GetUnarySelector(StringRef name, ASTContext& Ctx) {
   return Ctx.Selectors.getSelector(1, &II);
 }
 
+inline void *AllocateTypeNode(const ASTContext &C, size_t Bytes,
+                              unsigned Alignment) {
+  return C.Allocate(Bytes, Alignment, ASTContext::AC_Type);
+}
+
+inline void *AllocateDeclNode(const ASTContext &C, size_t Bytes,
+                              unsigned Alignment) {
+  return C.Allocate(Bytes, Alignment, ASTContext::AC_Decl);
+}
+
+inline void *AllocateStmtNode(const ASTContext &C, size_t Bytes,
+                              unsigned Alignment) {
+  return C.Allocate(Bytes, Alignment, ASTContext::AC_Stmt);
+}
+
 }  // end namespace clang
 
 // operator new and delete aren't allowed inside namespaces.
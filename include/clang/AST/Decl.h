@@ -1478,6 +1478,7 @@ private:
   bool HasImplicitReturnZero : 1;
   bool IsLateTemplateParsed : 1;
   bool IsConstexpr : 1;
+  bool HasUnparsedCachedBody : 1;
 
   /// \brief End part of this FunctionDecl's source range.
   ///
@@ -1562,7 +1563,8 @@ protected:
       HasWrittenPrototype(true), IsDeleted(false), IsTrivial(false),
       IsDefaulted(false), IsExplicitlyDefaulted(false),
       HasImplicitReturnZero(false), IsLateTemplateParsed(false),
-      IsConstexpr(isConstexprSpecified), EndRangeLoc(NameInfo.getEndLoc()),
+      IsConstexpr(isConstexprSpecified), HasUnparsedCachedBody(false),
+      EndRangeLoc(NameInfo.getEndLoc()),
       TemplateOrSpecialization(),
       DNLoc(NameInfo.getInfo()) {}
 
@@ -1669,14 +1671,14 @@ public:
   /// that this returns false for a defaulted function unless that function
   /// has been implicitly defined (possibly as deleted).
   bool isThisDeclarationADefinition() const {
-    return IsDeleted || Body || IsLateTemplateParsed;
+    return IsDeleted || Body || IsLateTemplateParsed || HasUnparsedCachedBody;
   }
 
   /// doesThisDeclarationHaveABody - Returns whether this specific
   /// declaration of the function has a body - that is, if it is a non-
   /// deleted definition.
   bool doesThisDeclarationHaveABody() const {
-    return Body || IsLateTemplateParsed;
+    return Body || IsLateTemplateParsed || HasUnparsedCachedBody;
   }
 
   void setBody(Stmt *B);
@@ -1698,6 +1700,15 @@ public:
   bool isLateTemplateParsed() const { return IsLateTemplateParsed; }
   void setLateTemplateParsed(bool ILT = true) { IsLateTemplateParsed = ILT; }
 
+  /// Whether the parser cached the tokens of this function's body without
+  /// parsing them, to parse them only when a client asks for the body (see
+  /// Sema::ParseLazyFunctionBody). Unrelated to the bodies deserialized
+  /// on demand through setLazyBody().
+  bool hasUnparsedCachedBody() const { return HasUnparsedCachedBody; }
+  void setHasUnparsedCachedBody(bool HUCB = true) {
+    HasUnparsedCachedBody = HUCB;
+  }
+
   /// Whether this function is "trivial" in some specialized C++ senses.
   /// Can only be true for default constructors, copy constructors,
   /// copy assignment operators, and destructors.  Not meaningful until
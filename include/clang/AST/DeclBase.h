@@ -335,8 +335,28 @@ protected:
   static void *AllocateDeserializedDecl(const ASTContext &Context,
                                         unsigned ID,
                                         unsigned Size);
-  
+
+  // The placement forms of operator delete hide the global one, which the
+  // virtual destructor needs. Declarations are never deleted, though; their
+  // memory is owned by the ASTContext.
+  void operator delete(void *) throw() {
+    llvm_unreachable("Decls cannot be released with regular 'delete'.");
+  }
+
 public:
+  // Only allow allocation of Decls using the allocator in ASTContext
+  // or by doing a placement new.
+  void *operator new(size_t Bytes, const ASTContext &C,
+                     unsigned Alignment = 8) {
+    return AllocateDeclNode(C, Bytes, Alignment);
+  }
+
+  void *operator new(size_t Bytes, void *Mem) throw() {
+    return Mem;
+  }
+
+  void operator delete(void *, const ASTContext &, unsigned) throw() { }
+  void operator delete(void *, void *) throw() { }
 
   /// \brief Source range that this declaration covers.
   virtual SourceRange getSourceRange() const LLVM_READONLY {
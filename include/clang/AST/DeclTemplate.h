@@ -18,6 +18,7 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/Redeclarable.h"
 #include "clang/AST/TemplateBase.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/Support/Compiler.h"
 #include <limits>
@@ -147,14 +148,25 @@ class TemplateArgumentList {
 
   /// \brief The number of template arguments in this template
   /// argument list.
-  unsigned NumArguments;
+  unsigned NumArguments : 31;
+
+  /// \brief Whether \c ProfileHash has been computed.
+  mutable unsigned HasProfileHash : 1;
+
+  /// \brief The cached hash of the profile of this template argument list,
+  /// as computed by \c Profile(). Valid only when \c HasProfileHash is set.
+  ///
+  /// This occupies what would otherwise be tail padding, so it does not
+  /// increase the size of the list on 64-bit hosts.
+  mutable unsigned ProfileHash;
 
   TemplateArgumentList(const TemplateArgumentList &Other) LLVM_DELETED_FUNCTION;
   void operator=(const TemplateArgumentList &Other) LLVM_DELETED_FUNCTION;
 
   TemplateArgumentList(const TemplateArgument *Args, unsigned NumArgs,
                        bool Owned)
-    : Arguments(Args, Owned), NumArguments(NumArgs) { }
+    : Arguments(Args, Owned), NumArguments(NumArgs), HasProfileHash(false),
+      ProfileHash(0) { }
 
 public:
   /// \brief Type used to indicate that the template argument list itself is a
@@ -173,7 +185,8 @@ public:
   /// provided.
   explicit TemplateArgumentList(OnStackType,
                                 const TemplateArgument *Args, unsigned NumArgs)
-    : Arguments(Args, false), NumArguments(NumArgs) { }
+    : Arguments(Args, false), NumArguments(NumArgs), HasProfileHash(false),
+      ProfileHash(0) { }
 
   /// \brief Produces a shallow copy of the given template argument list.
   ///
@@ -182,7 +195,8 @@ public:
   /// constructor, since this really really isn't safe to use that
   /// way.
   explicit TemplateArgumentList(const TemplateArgumentList *Other)
-    : Arguments(Other->data(), false), NumArguments(Other->size()) { }
+    : Arguments(Other->data(), false), NumArguments(Other->size()),
+      HasProfileHash(Other->HasProfileHash), ProfileHash(Other->ProfileHash) { }
 
   /// \brief Retrieve the template argument at a given index.
   const TemplateArgument &get(unsigned Idx) const {
@@ -201,6 +215,40 @@ public:
   const TemplateArgument *data() const {
     return Arguments.getPointer();
   }
+
+  /// \brief Retrieve the hash of the profile of this template argument list.
+  ///
+  /// The hash is computed on first use and cached, so that searching and
+  /// rehashing the specialization tables of a template does not need to
+  /// re-profile the (possibly deeply nested) arguments of every
+  /// specialization it compares against.
+  unsigned getProfileHash(const ASTContext &Context) const;
+
+  /// \brief Profile the given template arguments in the form used to unique
+  /// template specializations.
+  static void Profile(llvm::FoldingSetNodeID &ID, const TemplateArgument *Args,
+                      unsigned NumArgs, const ASTContext &Context);
+};
+
+/// \brief FoldingSet traits for the specialization tables of templates.
+///
+/// Specializations hash to the cached profile hash of their template
+/// argument list, and a specialization is only re-profiled for a full
+/// comparison when that hash matches the hash of the lookup key.
+template<typename SpecT>
+struct TemplateSpecializationFoldingSetTrait
+  : llvm::DefaultFoldingSetTrait<SpecT> {
+  static bool Equals(SpecT &X, const llvm::FoldingSetNodeID &ID,
+                     unsigned IDHash, llvm::FoldingSetNodeID &TempID) {
+    if (X.getProfileHash() != IDHash)
+      return false;
+    X.Profile(TempID);
+    return TempID == ID;
+  }
+
+  static unsigned ComputeHash(SpecT &X, llvm::FoldingSetNodeID &TempID) {
+    return X.getProfileHash();
+  }
 };
 
 //===----------------------------------------------------------------------===//
@@ -358,15 +406,29 @@ public:
             Function->getASTContext());
   }
 
+  /// \brief Retrieve the (cached) hash of this specialization's profile.
+  unsigned getProfileHash() const {
+    return TemplateArguments->getProfileHash(Function->getASTContext());
+  }
+
   static void
   Profile(llvm::FoldingSetNodeID &ID, const TemplateArgument *TemplateArgs,
           unsigned NumTemplateArgs, ASTContext &Context) {
-    ID.AddInteger(NumTemplateArgs);
-    for (unsigned Arg = 0; Arg != NumTemplateArgs; ++Arg)
-      TemplateArgs[Arg].Profile(ID, Context);
+    TemplateArgumentList::Profile(ID, TemplateArgs, NumTemplateArgs, Context);
   }
 };
 
+} // end namespace clang
+
+namespace llvm {
+template<>
+struct FoldingSetTrait<clang::FunctionTemplateSpecializationInfo>
+  : clang::TemplateSpecializationFoldingSetTrait<
+      clang::FunctionTemplateSpecializationInfo> { };
+} // end namespace llvm
+
+namespace clang {
+
 /// \brief Provides information a specialization of a member of a class
 /// template, which may be a member function, static data member,
 /// member class or member enumeration.
@@ -825,6 +887,12 @@ public:
   /// template.
   std::pair<const TemplateArgument *, unsigned> getInjectedTemplateArgs();
 
+  /// \brief Retrieve the number of specializations of this function template
+  /// that have been created so far.
+  unsigned getNumSpecializations() {
+    return getSpecializations().size();
+  }
+
   /// \brief Create a function template node.
   static FunctionTemplateDecl *Create(ASTContext &C, DeclContext *DC,
                                       SourceLocation L,
@@ -1577,12 +1645,15 @@ public:
     Profile(ID, TemplateArgs->data(), TemplateArgs->size(), getASTContext());
   }
 
+  /// \brief Retrieve the (cached) hash of this specialization's profile.
+  unsigned getProfileHash() const {
+    return TemplateArgs->getProfileHash(getASTContext());
+  }
+
   static void
   Profile(llvm::FoldingSetNodeID &ID, const TemplateArgument *TemplateArgs,
           unsigned NumTemplateArgs, ASTContext &Context) {
-    ID.AddInteger(NumTemplateArgs);
-    for (unsigned Arg = 0; Arg != NumTemplateArgs; ++Arg)
-      TemplateArgs[Arg].Profile(ID, Context);
+    TemplateArgumentList::Profile(ID, TemplateArgs, NumTemplateArgs, Context);
   }
 
   static bool classof(const Decl *D) { return classofKind(D->getKind()); }
@@ -1775,6 +1846,22 @@ public:
   friend class ASTDeclWriter;
 };
 
+} // end namespace clang
+
+namespace llvm {
+template<>
+struct FoldingSetTrait<clang::ClassTemplateSpecializationDecl>
+  : clang::TemplateSpecializationFoldingSetTrait<
+      clang::ClassTemplateSpecializationDecl> { };
+
+template<>
+struct FoldingSetTrait<clang::ClassTemplatePartialSpecializationDecl>
+  : clang::TemplateSpecializationFoldingSetTrait<
+      clang::ClassTemplatePartialSpecializationDecl> { };
+} // end namespace llvm
+
+namespace clang {
+
 /// Declaration of a class template.
 class ClassTemplateDecl : public RedeclarableTemplateDecl {
   static void DeallocateCommon(void *Ptr);
@@ -1949,6 +2036,15 @@ public:
   /// \endcode
   QualType getInjectedClassNameSpecialization();
 
+  /// \brief Retrieve the number of specializations of this class template
+  /// that have been created or loaded so far.
+  ///
+  /// Unlike spec_begin()/spec_end(), this does not load lazily-deserialized
+  /// specializations.
+  unsigned getNumLoadedSpecializations() {
+    return getCommonPtr()->Specializations.size();
+  }
+
   typedef SpecIterator<ClassTemplateSpecializationDecl> spec_iterator;
 
   spec_iterator spec_begin() {
@@ -2032,6 +2032,10 @@ public:
 /// "str1 + str2" to resolve to a function call.
 class CallExpr : public Expr {
   enum { FN=0, PREARGS_START=1 };
+  /// \brief The callee, pre-arguments and arguments. This is a separate
+  /// allocation rather than trailing storage because Sema grows it through
+  /// setNumArgs() when default arguments are filled in, and because the
+  /// derived classes lay out their own members after CallExpr's.
   Stmt **SubExprs;
   unsigned NumArgs;
   SourceLocation RParenLoc;
@@ -49,8 +49,6 @@ class TemplateArgumentListInfo;
 /// function templates that were found by name lookup at template
 /// definition time.
 class CXXOperatorCallExpr : public CallExpr {
-  /// \brief The overloaded operator.
-  OverloadedOperatorKind Operator;
   SourceRange Range;
 
   SourceRange getSourceRangeImpl() const LLVM_READONLY;
@@ -59,17 +57,24 @@ public:
                       ArrayRef<Expr*> args, QualType t, ExprValueKind VK,
                       SourceLocation operatorloc)
     : CallExpr(C, CXXOperatorCallExprClass, fn, 0, args, t, VK,
-               operatorloc),
-      Operator(Op) {
+               operatorloc) {
+    setOperator(Op);
     Range = getSourceRangeImpl();
   }
   explicit CXXOperatorCallExpr(ASTContext& C, EmptyShell Empty) :
-    CallExpr(C, CXXOperatorCallExprClass, Empty) { }
-
+    CallExpr(C, CXXOperatorCallExprClass, Empty) {
+    setOperator(OO_None);
+  }
 
   /// getOperator - Returns the kind of overloaded operator that this
   /// expression refers to.
-  OverloadedOperatorKind getOperator() const { return Operator; }
+  OverloadedOperatorKind getOperator() const {
+    return static_cast<OverloadedOperatorKind>(CallExprBits.Operator);
+  }
+  void setOperator(OverloadedOperatorKind Op) {
+    CallExprBits.Operator = Op;
+    assert(CallExprBits.Operator == Op && "operator kind doesn't fit in bits!");
+  }
 
   /// getOperatorLoc - Returns the location of the operator symbol in
   /// the expression. When @c getOperator()==OO_Call, this is the
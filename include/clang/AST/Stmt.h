@@ -210,9 +210,14 @@ protected:
 
   class CallExprBitfields {
     friend class CallExpr;
+    friend class CXXOperatorCallExpr;
     unsigned : NumExprBits;
 
     unsigned NumPreArgs : 1;
+
+    /// \brief The overloaded operator of a CXXOperatorCallExpr. Kept here
+    /// rather than in the derived class to avoid padding out the node.
+    unsigned Operator : 6;
   };
 
   class ExprWithCleanupsBitfields {
@@ -303,12 +308,12 @@ public:
   // or by doing a placement new.
   void* operator new(size_t bytes, ASTContext& C,
                      unsigned alignment = 8) throw() {
-    return ::operator new(bytes, C, alignment);
+    return AllocateStmtNode(C, bytes, alignment);
   }
 
   void* operator new(size_t bytes, ASTContext* C,
                      unsigned alignment = 8) throw() {
-    return ::operator new(bytes, *C, alignment);
+    return operator new(bytes, *C, alignment);
   }
 
   void* operator new(size_t bytes, void* mem) throw() {
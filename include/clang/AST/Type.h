@@ -100,6 +100,15 @@ namespace clang {
   template <typename> class CanQual;
   typedef CanQual<Type> CanQualType;
 
+  // Allocate the memory of a type, declaration or statement node from the
+  // context, accounted to its category. Defined in ASTContext.h.
+  inline void *AllocateTypeNode(const ASTContext &C, size_t Bytes,
+                                unsigned Alignment);
+  inline void *AllocateDeclNode(const ASTContext &C, size_t Bytes,
+                                unsigned Alignment);
+  inline void *AllocateStmtNode(const ASTContext &C, size_t Bytes,
+                                unsigned Alignment);
+
   // Provide forward declarations for all of the *Type classes
 #define TYPE(Class, Base) class Class##Type;
 #include "clang/AST/TypeNodes.def"
@@ -1061,6 +1070,21 @@ class ExtQualsTypeCommonBase {
   friend class QualType;
   friend class Type;
   friend class ExtQuals;
+
+public:
+  // Only allow allocation of types using the allocator in ASTContext
+  // or by doing a placement new.
+  void *operator new(size_t Bytes, const ASTContext &C,
+                     unsigned Alignment = TypeAlignment) {
+    return AllocateTypeNode(C, Bytes, Alignment);
+  }
+
+  void *operator new(size_t Bytes, void *Mem) throw() {
+    return Mem;
+  }
+
+  void operator delete(void *, const ASTContext &, unsigned) throw() { }
+  void operator delete(void *, void *) throw() { }
 };
 
 /// ExtQuals - We can encode up to four bits in the low bits of a
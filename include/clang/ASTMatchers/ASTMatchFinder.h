@@ -42,6 +42,7 @@
 #define LLVM_CLANG_AST_MATCHERS_AST_MATCH_FINDER_H
 
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/Support/Timer.h"
 
 namespace clang {
 
@@ -95,6 +96,49 @@ public:
     virtual void run() = 0;
   };
 
+  /// \brief Cost of a single registered matcher, collected when profiling
+  /// is enabled.
+  struct MatcherProfile {
+    MatcherProfile()
+      : NumMatches(0), NumMemoizationHits(0), NumMemoizationMisses(0) {}
+
+    /// \brief Time spent running the matcher, including recursive matches.
+    llvm::TimeRecord MatchTime;
+
+    /// \brief Time spent in the matcher's callback.
+    llvm::TimeRecord CallbackTime;
+
+    /// \brief Number of nodes the matcher matched.
+    unsigned NumMatches;
+
+    /// \brief Number of recursive (e.g. hasDescendant) matches that were
+    /// answered from the memoization cache, and that had to be computed.
+    /// @{
+    unsigned NumMemoizationHits;
+    unsigned NumMemoizationMisses;
+    /// @}
+  };
+
+  /// \brief A registered matcher together with its callback.
+  ///
+  /// Index is the position of the matcher in registration order.
+  struct MatcherEntry {
+    const internal::DynTypedMatcher *Matcher;
+    MatchCallback *Callback;
+    unsigned Index;
+  };
+  typedef std::vector<MatcherEntry> MatcherList;
+
+  /// \brief The registered matchers, bucketed by the kind of node they
+  /// match so that each node is only run against matchers that can match it.
+  struct MatchersByNodeKind {
+    MatcherList Decl;
+    MatcherList Type;
+    MatcherList Stmt;
+    MatcherList NestedNameSpecifier;
+    MatcherList NestedNameSpecifierLoc;
+  };
+
   MatchFinder();
   ~MatchFinder();
 
@@ -121,6 +165,19 @@ public:
   /// \brief Creates a clang ASTConsumer that finds all matches.
   clang::ASTConsumer *newASTConsumer();
 
+  /// \brief Enables collecting a \c MatcherProfile for every registered
+  /// matcher in ASTConsumers created afterwards.
+  void enableProfiling(bool Enable = true) { ProfilingEnabled = Enable; }
+
+  /// \brief Returns the profile of the \p Index-th registered matcher.
+  const MatcherProfile &getProfile(unsigned Index) const {
+    assert(Index < Profiles.size() && "Matcher index out of range");
+    return Profiles[Index];
+  }
+
+  /// \brief Prints the collected profiles, most expensive matcher first.
+  void printProfile(raw_ostream &OS) const;
+
   /// \brief Registers a callback to notify the end of parsing.
   ///
   /// The provided closure is called after parsing is done, before the AST is
@@ -129,10 +186,18 @@ public:
   void registerTestCallbackAfterParsing(ParsingDoneTestCallback *ParsingDone);
 
 private:
+  void addMatcherEntry(MatcherList &List,
+                       const internal::DynTypedMatcher *Matcher,
+                       MatchCallback *Action);
+
   /// \brief For each \c DynTypedMatcher a \c MatchCallback that will be called
   /// when it matches.
-  std::vector<std::pair<const internal::DynTypedMatcher*, MatchCallback*> >
-    MatcherCallbackPairs;
+  MatchersByNodeKind Matchers;
+
+  /// \brief One profile per registered matcher, in registration order.
+  std::vector<MatcherProfile> Profiles;
+
+  bool ProfilingEnabled;
 
   /// \brief Called when parsing is done.
   ParsingDoneTestCallback *ParsingDone;
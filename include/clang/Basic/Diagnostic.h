@@ -18,6 +18,7 @@
 #include "clang/Basic/DiagnosticIDs.h"
 #include "clang/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/OwningPtr.h"
@@ -186,6 +187,7 @@ private:
   unsigned ErrorLimit;           // Cap of # errors emitted, 0 -> no limit.
   unsigned TemplateBacktraceLimit; // Cap on depth of template backtrace stack,
                                    // 0 -> no limit.
+  bool FoldTemplateBacktrace;      // Fold repeated instantiation contexts.
   unsigned ConstexprBacktraceLimit; // Cap on depth of constexpr evaluation
                                     // backtrace stack, 0 -> no limit.
   ExtensionHandling ExtBehavior; // Map extensions onto warnings or errors?
@@ -261,6 +263,35 @@ private:
   /// so we can get back at it when we 'pop'.
   std::vector<DiagState *> DiagStateOnPushStack;
 
+  /// \brief The span of a file, in file offsets [Begin, End), over which a
+  /// single DiagStatePoint is in effect.
+  struct DiagStateRange {
+    unsigned Begin, End;
+    unsigned Point;  ///< Index into DiagStatePoints.
+    bool OpenEnded;  ///< Whether the range extends past the last point.
+  };
+
+  /// \brief Caches, per FileID, the last range of the file that was resolved
+  /// to a DiagStatePoint, so that repeated queries in a file with many
+  /// diagnostic pragmas avoid the binary search over DiagStatePoints.
+  ///
+  /// An open-ended range was computed while its point was the last one and
+  /// is only valid for as long as that remains true.
+  mutable llvm::DenseMap<FileID, DiagStateRange> DiagStateRangeCache;
+
+  /// \brief The diagnostics whose mapping may differ between DiagStates,
+  /// i.e. that were mapped by a pragma or after a pragma created a new state.
+  ///
+  /// The mapping of any other diagnostic is the same in every DiagState, so
+  /// its level can be computed from the current state without looking up the
+  /// state for the location.
+  llvm::BitVector LocationDependentDiags;
+
+  /// \brief Statistics for the diagnostic level queries.
+  mutable unsigned NumLevelQueries;
+  mutable unsigned NumStatePointLookups;
+  mutable unsigned NumStateRangeCacheHits;
+
   DiagState *GetCurDiagState() const {
     assert(!DiagStatePoints.empty());
     return DiagStatePoints.back().State;
@@ -281,6 +312,27 @@ private:
   /// the given source location.
   DiagStatePointsTy::iterator GetDiagStatePointForLoc(SourceLocation Loc) const;
 
+  /// \brief Returns the DiagState to use when computing the level of the
+  /// given diagnostic at the given location.
+  DiagState *GetDiagStateForDiag(diag::kind Diag, SourceLocation Loc) const {
+    ++NumLevelQueries;
+    if (Diag >= LocationDependentDiags.size() || !LocationDependentDiags[Diag])
+      return GetCurDiagState();
+    return GetDiagStatePointForLoc(Loc)->State;
+  }
+
+  /// \brief Records that the mapping of \p Diag was changed in a way that may
+  /// make it differ between DiagStates.
+  void markLocationDependent(diag::kind Diag) {
+    if (Diag >= LocationDependentDiags.size())
+      LocationDependentDiags.resize(diag::DIAG_UPPER_LIMIT);
+    LocationDependentDiags.set(Diag);
+  }
+
+  /// \brief Remembers the range of \p FID over which the point at index
+  /// \p Point is in effect, if it can be computed cheaply.
+  void cacheDiagStateRange(FileID FID, unsigned Point) const;
+
   /// \brief Sticky flag set to \c true when an error is emitted.
   bool ErrorOccurred;
 
@@ -367,7 +419,10 @@ public:
     assert(SourceMgr && "SourceManager not set!");
     return *SourceMgr;
   }
-  void setSourceManager(SourceManager *SrcMgr) { SourceMgr = SrcMgr; }
+  void setSourceManager(SourceManager *SrcMgr) {
+    SourceMgr = SrcMgr;
+    DiagStateRangeCache.clear();
+  }
 
   //===--------------------------------------------------------------------===//
   //  DiagnosticsEngine characterization methods, used by a client to customize
@@ -409,6 +464,12 @@ public:
     return TemplateBacktraceLimit;
   }
 
+  /// \brief Specify whether consecutive template instantiation contexts
+  /// with the same point of instantiation, as produced by recursive
+  /// instantiation, should be folded into a single note.
+  void setFoldTemplateBacktrace(bool Val) { FoldTemplateBacktrace = Val; }
+  bool getFoldTemplateBacktrace() const { return FoldTemplateBacktrace; }
+
   /// \brief Specify the maximum number of constexpr evaluation
   /// notes to emit along with a given diagnostic.
   void setConstexprBacktraceLimit(unsigned Limit) {
@@ -598,6 +659,9 @@ public:
   /// \brief Reset the state of the diagnostic object to its initial 
   /// configuration.
   void Reset();
+
+  /// \brief Print statistics about diagnostic level queries to stderr.
+  void PrintStats() const;
   
   //===--------------------------------------------------------------------===//
   // DiagnosticsEngine classification and reporting interfaces.
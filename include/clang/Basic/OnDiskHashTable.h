@@ -282,12 +282,20 @@ public:
   };
 
   iterator find(const external_key_type& eKey, Info *InfoPtr = 0) {
+    const internal_key_type& iKey = InfoObj.GetInternalKey(eKey);
+    return find_hashed(iKey, InfoObj.ComputeHash(iKey), InfoPtr);
+  }
+
+  /// \brief Look up the given key, whose hash has already been computed.
+  ///
+  /// This lets clients probing the same key in many tables built with the
+  /// same hash function compute the hash only once.
+  iterator find_hashed(const internal_key_type& iKey, unsigned key_hash,
+                       Info *InfoPtr = 0) {
     if (!InfoPtr)
       InfoPtr = &InfoObj;
 
     using namespace io;
-    const internal_key_type& iKey = InfoObj.GetInternalKey(eKey);
-    unsigned key_hash = InfoObj.ComputeHash(iKey);
 
     // Each bucket is just a 32-bit offset into the hash table file.
     unsigned idx = key_hash & (NumBuckets - 1);
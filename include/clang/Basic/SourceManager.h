@@ -51,6 +51,12 @@
 #include <vector>
 #include <cassert>
 
+namespace llvm {
+namespace sys {
+  class MutexImpl;
+}
+}
+
 namespace clang {
 
 class DiagnosticsEngine;
@@ -596,6 +602,17 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// starts at 2^31.
   static const unsigned MaxLoadedOffset = 1U << 31U;
 
+  /// \brief The offset local SLocEntries may not reach, in addition to
+  /// CurrentLoadedOffset. Lowered only for testing.
+  unsigned LocalSLocSpaceLimit;
+
+  /// \brief Whether a local SLocEntry of \p Size (plus one) still fits.
+  bool hasLocalSLocSpace(unsigned Size) const {
+    unsigned End = NextLocalOffset + Size + 1;
+    return End > NextLocalOffset && End <= CurrentLoadedOffset &&
+           End <= LocalSLocSpaceLimit;
+  }
+
   /// \brief A bitmap that indicates whether the entries of LoadedSLocEntryTable
   /// have already been loaded from the external source.
   ///
@@ -611,6 +628,18 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// is very common to look up many tokens from the same file.
   mutable FileID LastFileIDLookup;
 
+  /// \brief A small round-robin cache of the FileIDs most recently found by
+  /// searching the SLocEntry tables.
+  ///
+  /// Unlike LastFileIDLookup this also holds macro expansions, which code
+  /// with heavy macro use looks up over and over. Like the other caches of
+  /// the source manager it is shared by all threads, which is fine as long as
+  /// only one thread at a time uses the source manager. Concurrent queries
+  /// bypass both FileID caches, see enableConcurrentQueries().
+  enum { NumRecentFileIDLookups = 4 };
+  mutable FileID RecentFileIDLookups[NumRecentFileIDLookups];
+  mutable unsigned NextRecentFileIDLookup;
+
   /// \brief Holds information for \#line directives.
   ///
   /// This is referenced by indices from SLocEntryTable.
@@ -631,6 +660,7 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable unsigned NumSlowFileIDLookups, NumRecentFileIDHits;
 
   // Cache results for the isBeforeInTranslationUnit method.
   mutable IsBeforeInTranslationUnitCache IsBeforeInTUCache;
@@ -646,6 +676,12 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   mutable llvm::DenseMap<FileID, MacroArgsMap *> MacroArgsCacheMap;
 
+  /// \brief If non-null, serializes updates of the caches above so that
+  /// several threads can query source locations at once.
+  ///
+  /// \see enableConcurrentQueries
+  llvm::sys::MutexImpl *CacheMutex;
+
   // SourceManager doesn't support copy construction.
   explicit SourceManager(const SourceManager&) LLVM_DELETED_FUNCTION;
   void operator=(const SourceManager&) LLVM_DELETED_FUNCTION;
@@ -718,7 +754,8 @@ public:
   /// \brief Create a new FileID that represents the specified file
   /// being \#included from the specified IncludePosition.
   ///
-  /// This translates NULL into standard input.
+  /// This translates NULL into standard input. Returns an invalid FileID,
+  /// after a fatal diagnostic, if the source locations have run out.
   FileID createFileID(const FileEntry *SourceFile, SourceLocation IncludePos,
                       SrcMgr::CharacteristicKind FileCharacter,
                       int LoadedID = 0, unsigned LoadedOffset = 0) {
@@ -732,7 +769,9 @@ public:
   /// \brief Create a new FileID that represents the specified memory buffer.
   ///
   /// This does no caching of the buffer and takes ownership of the
-  /// MemoryBuffer, so only pass a MemoryBuffer to this once.
+  /// MemoryBuffer, so only pass a MemoryBuffer to this once. Like
+  /// createFileID, returns an invalid FileID if the source locations have
+  /// run out.
   FileID createFileIDForMemBuffer(const llvm::MemoryBuffer *Buffer,
                                   int LoadedID = 0, unsigned LoadedOffset = 0,
                                  SourceLocation IncludeLoc = SourceLocation()) {
@@ -744,6 +783,9 @@ public:
   /// fact that a token from SpellingLoc should actually be referenced from
   /// ExpansionLoc, and that it represents the expansion of a macro argument
   /// into the function-like macro body.
+  ///
+  /// If the source locations have run out, this reports a fatal error and
+  /// returns \p Loc, which can be offset just like the new location.
   SourceLocation createMacroArgExpansionLoc(SourceLocation Loc,
                                             SourceLocation ExpansionLoc,
                                             unsigned TokLength);
@@ -751,6 +793,9 @@ public:
   /// \brief Return a new SourceLocation that encodes the fact
   /// that a token from SpellingLoc should actually be referenced from
   /// ExpansionLoc.
+  ///
+  /// If the source locations have run out, this reports a fatal error and
+  /// returns \p Loc, which can be offset just like the new location.
   SourceLocation createExpansionLoc(SourceLocation Loc,
                                     SourceLocation ExpansionLocStart,
                                     SourceLocation ExpansionLocEnd,
@@ -909,8 +954,9 @@ public:
   FileID getFileID(SourceLocation SpellingLoc) const {
     unsigned SLocOffset = SpellingLoc.getOffset();
 
-    // If our one-entry cache covers this offset, just return it.
-    if (isOffsetInFileID(LastFileIDLookup, SLocOffset))
+    // If our one-entry cache covers this offset, just return it. Concurrent
+    // queries must not touch the cache; getFileIDSlow() handles them.
+    if (!CacheMutex && isOffsetInFileID(LastFileIDLookup, SLocOffset))
       return LastFileIDLookup;
 
     return getFileIDSlow(SLocOffset);
@@ -1352,6 +1398,17 @@ public:
   ///
   void PrintStats() const;
 
+  /// \brief Allow source locations to be queried from several threads at
+  /// once, as long as nothing creates new FileIDs meanwhile.
+  ///
+  /// This loads every source location entry and file buffer that would
+  /// otherwise be loaded on first use. From then on FileID lookups search
+  /// the SLocEntry tables without going through the shared lookup caches,
+  /// and the other lookups that update caches are serialized. Entries and
+  /// buffers that are created later are not loaded, so call this again after
+  /// creating any.
+  void enableConcurrentQueries();
+
   /// \brief Get the number of local SLocEntries we have.
   unsigned local_sloc_entry_size() const { return LocalSLocEntryTable.size(); }
 
@@ -1384,6 +1441,10 @@ public:
 
   unsigned getNextLocalOffset() const { return NextLocalOffset; }
 
+  /// \brief Don't let local files and macro expansions use offsets from
+  /// \p Limit on, so tests can run out of source locations quickly.
+  void setLocalSLocSpaceLimit(unsigned Limit) { LocalSLocSpaceLimit = Limit; }
+
   void setExternalSLocEntrySource(ExternalSLocEntrySource *Source) {
     assert(LoadedSLocEntryTable.empty() &&
            "Invalidating existing loaded entries");
@@ -1395,7 +1456,8 @@ public:
   ///
   /// NumSLocEntries will be allocated, which occupy a total of TotalSize space
   /// in the global source view. The lowest ID and the base offset of the
-  /// entries will be returned.
+  /// entries will be returned, or (0, 0) after a fatal error if there isn't
+  /// enough space left.
   std::pair<int, unsigned>
   AllocateLoadedSLocEntries(unsigned NumSLocEntries, unsigned TotalSize);
 
@@ -1544,6 +1606,7 @@ private:
   createMemBufferContentCache(const llvm::MemoryBuffer *Buf);
 
   FileID getFileIDSlow(unsigned SLocOffset) const;
+  FileID getFileIDUncached(unsigned SLocOffset) const;
   FileID getFileIDLocal(unsigned SLocOffset) const;
   FileID getFileIDLoaded(unsigned SLocOffset) const;
 
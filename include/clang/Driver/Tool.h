@@ -67,6 +67,18 @@ public:
                             const InputInfoList &Inputs,
                             const ArgList &TCArgs,
                             const char *LinkingOutput) const = 0;
+
+  /// \brief Can this tool combine object files into a single relocatable
+  /// object file.
+  virtual bool hasRelocatableLink() const { return false; }
+
+  /// ConstructRelocatableLinkJob - Construct a job to combine the object
+  /// files \p Inputs into the relocatable object file \p Output, for the
+  /// action \p JA. Only valid if hasRelocatableLink() is true.
+  virtual void ConstructRelocatableLinkJob(Compilation &C, const JobAction &JA,
+                                           const InputInfo &Output,
+                                           const InputInfoList &Inputs,
+                                           const ArgList &TCArgs) const;
 };
 
 } // end namespace driver
@@ -27,8 +27,10 @@
 #include "clang-c/Index.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Path.h"
 #include <map>
 #include <string>
@@ -39,6 +41,10 @@
 
 namespace llvm {
   class MemoryBuffer;
+namespace sys {
+  class MutexImpl;
+  class RWMutexImpl;
+}
 }
 
 namespace clang {
@@ -51,6 +57,7 @@ class Decl;
 class DiagnosticsEngine;
 class FileEntry;
 class FileManager;
+class FunctionDecl;
 class HeaderSearch;
 class Preprocessor;
 class SourceManager;
@@ -258,6 +265,19 @@ private:
   /// \brief True if non-system source files should be treated as volatile
   /// (likely to change while trying to use them).
   bool UserFilesAreVolatile : 1;
+
+  /// \brief Whether reparsing only parses the main-file function bodies
+  /// whose text changed since the previous parse.
+  ///
+  /// Unchanged bodies are left for parsing on demand, and their diagnostics
+  /// are carried over from the previous parse. Any change outside the
+  /// function bodies of the main file makes the next parse a full one.
+  bool IncrementalFunctionBodies : 1;
+
+  /// \brief Whether read-only queries may be run on several threads at once.
+  ///
+  /// See ConcurrentQueryState for what this entails.
+  bool ConcurrentQueries : 1;
  
   /// \brief The language options used when we load an AST file.
   LangOptions ASTFileLangOpts;
@@ -362,6 +382,130 @@ private:
   /// \brief The current hash value for the top-level declaration and macro
   /// definition names
   unsigned CurrentTopLevelHashValue;
+
+  /// \brief The number of precompiled preambles built so far.
+  unsigned PreambleGeneration;
+
+  /// \brief A function body in the main file, as tracked in incremental
+  /// function-body mode.
+  struct FunctionBodyInfo {
+    /// \brief The function, during the parse that recorded the body.
+    FunctionDecl *FD;
+
+    /// \brief The offsets of the braces around the body.
+    unsigned Begin, End;
+
+    /// \brief The index of the body in the previous parse if the body was
+    /// left lazy because its text did not change, ~0U otherwise.
+    unsigned ReusedFrom;
+
+    /// \brief Whether all diagnostics of the body could be carried over to
+    /// a parse that leaves the body lazy.
+    bool DiagnosticsAreLocal;
+
+    /// \brief Whether parsing the body had no effects beyond marking the
+    /// declarations below used, such as instantiating templates or defining
+    /// implicit members, so that a parse may leave it lazy.
+    bool UsesAreLocal;
+
+    /// \brief The declarations that Sema checks for uses at the end of the
+    /// translation unit and that the body uses, or only references, as keys
+    /// that identify them across parses, as recorded while parsing it.
+    std::vector<std::string> UsedDecls, ReferencedDecls;
+
+    bool operator<(const FunctionBodyInfo &RHS) const {
+      return Begin < RHS.Begin;
+    }
+  };
+
+  /// \brief A range of a function body diagnostic, as offsets from the
+  /// opening brace of the body.
+  struct FunctionBodyRange {
+    unsigned Begin, End;
+    bool IsTokenRange;
+  };
+
+  /// \brief A diagnostic reported inside a function body, kept independent
+  /// of the source manager so it can be carried over to the next parse.
+  struct FunctionBodyDiagnostic {
+    unsigned Body;
+    DiagnosticsEngine::Level Level;
+    unsigned ID;
+    std::string Message;
+    unsigned Offset;
+    std::vector<FunctionBodyRange> Ranges;
+    std::vector<std::pair<FunctionBodyRange, std::string> > FixIts;
+  };
+
+  /// \brief The main-file function bodies of the last parse, in source order.
+  std::vector<FunctionBodyInfo> FunctionBodies;
+
+  /// \brief The text of the main file of the last parse, which the bodies in
+  /// \c FunctionBodies point into.
+  std::string FunctionBodiesMainFileText;
+
+  /// \brief The state of a file read by a parse: its size and modification
+  /// time, or, for a file overridden by a buffer, the size and a hash of the
+  /// buffer.
+  struct FunctionBodyDependency {
+    off_t Size;
+    time_t ModTime;
+    unsigned BufferHash;
+
+    bool operator!=(const FunctionBodyDependency &RHS) const {
+      return Size != RHS.Size || ModTime != RHS.ModTime ||
+             BufferHash != RHS.BufferHash;
+    }
+  };
+
+  /// \brief The files besides the main file and the precompiled preamble
+  /// that the last parse read.
+  llvm::StringMap<FunctionBodyDependency> FunctionBodyDependencies;
+
+  /// \brief A hash identifying the precompiled preamble of the last parse.
+  unsigned FunctionBodiesPreambleHash;
+
+  /// \brief The diagnostics of the bodies in \c FunctionBodies, saved before
+  /// a reparse.
+  std::vector<FunctionBodyDiagnostic> FunctionBodyDiagnostics;
+
+  /// \brief The main-file function bodies seen by the current parse.
+  std::vector<FunctionBodyInfo> ParsedFunctionBodies;
+
+  /// \brief The opening-brace offsets at which the current main file has the
+  /// same function bodies as the last parse, paired with the indices of those
+  /// bodies in \c FunctionBodies. Sorted by offset.
+  std::vector<std::pair<unsigned, unsigned> > UnchangedFunctionBodies;
+
+  /// \brief The functions whose bodies the current parse left lazy because
+  /// they did not change, and whose diagnostics were carried over.
+  llvm::SmallPtrSet<FunctionDecl *, 16> ReusedFunctionBodies;
+
+  /// \brief The functions whose bodies the parse may have left lazy, with the
+  /// expansion ranges of the bodies.
+  ///
+  /// The bodies don't overlap; once \c LazyFunctionBodyRangesSorted, they are
+  /// in translation unit order.
+  std::vector<std::pair<SourceRange, FunctionDecl *> > LazyFunctionBodyRanges;
+  bool LazyFunctionBodyRangesSorted;
+
+  /// \brief How many ReadOnlyChecks are active on this ASTUnit, unless
+  /// concurrent queries are enabled.
+  unsigned ReadOnlyCheckDepth;
+
+  bool getFunctionBodyOffset(SourceLocation Loc, unsigned &Body,
+                             unsigned &Offset);
+  void saveFunctionBodyDiagnostics();
+  void matchFunctionBodies();
+  void finishFunctionBodies();
+  unsigned hashFunctionBodiesPreamble();
+  bool getFunctionBodyDependency(StringRef Name,
+                                 FunctionBodyDependency &Dep);
+  bool recordFunctionBodyDependencies();
+  bool functionBodyDependenciesChanged();
+  void collectFunctionBodyUses(FunctionBodyInfo &Body);
+  void addLazyFunctionBody(FunctionDecl *FD, SourceRange BodyRange);
+  bool canParseLazyFunctionBodies() const;
   
   /// \brief Bit used by CIndex to mark when a translation unit may be in an
   /// inconsistent state, and is not safe to free.
@@ -417,7 +561,68 @@ private:
   };
   ConcurrencyState ConcurrencyCheckValue;
 
+  /// \brief Lets several threads query the ASTUnit at once when concurrent
+  /// queries are enabled.
+  ///
+  /// Read-only queries share the access lock, while anything that modifies
+  /// the ASTUnit takes it exclusively and so waits for them to finish. State
+  /// that read-only queries would otherwise build on first use is either
+  /// built after each parse (see prepareForConcurrentQueries()) or guarded by
+  /// the lazy-state lock. Both locks keep count of how often a thread had to
+  /// wait for them and for how long; the counts are printed when the ASTUnit
+  /// is destroyed if LIBCLANG_TIMING is set.
+  ///
+  /// A thread waiting for exclusive access may hold up new readers, as it
+  /// does with writer-preferring read/write locks. Read-only queries nest,
+  /// e.g. within visitor callbacks, so only the outermost ReadOnlyCheck of a
+  /// thread takes the shared lock.
+  class ConcurrentQueryState {
+  public:
+    struct LockStatistics {
+      llvm::sys::cas_flag Acquisitions;
+      unsigned Contended;
+      uint64_t WaitMicroseconds;
+
+      LockStatistics() : Acquisitions(0), Contended(0), WaitMicroseconds(0) { }
+    };
+
+  private:
+    llvm::sys::RWMutexImpl *AccessMutex;
+    llvm::sys::MutexImpl *LazyStateMutex;
+    llvm::sys::MutexImpl *StatisticsMutex;
+
+    /// \brief The number of threads holding or waiting for the access lock
+    /// in each mode; used to tell whether an acquisition had to wait.
+    volatile llvm::sys::cas_flag Readers, Writers;
+
+    LockStatistics Shared, Exclusive, LazyState;
+
+    void recordWait(LockStatistics &Stats, uint64_t Microseconds);
+    static void printLockStatistics(raw_ostream &OS, StringRef Name,
+                                    const LockStatistics &Stats);
+
+  public:
+    ConcurrentQueryState();
+    ~ConcurrentQueryState();
+
+    void startShared();
+    void finishShared();
+    void startExclusive();
+    void finishExclusive();
+    void lockLazyState();
+    void unlockLazyState();
+
+    void printStatistics(raw_ostream &OS) const;
+  };
+  ConcurrentQueryState ConcurrentQueryLocks;
+
+  void prepareForConcurrentQueries();
+
 public:
+  /// \brief Scoped use of the ASTUnit that may modify it.
+  ///
+  /// With concurrent queries enabled, this waits until no other thread uses
+  /// the ASTUnit.
   class ConcurrencyCheck {
     ASTUnit &Self;
     
@@ -425,14 +630,58 @@ public:
     explicit ConcurrencyCheck(ASTUnit &Self)
       : Self(Self) 
     { 
+      if (Self.ConcurrentQueries)
+        Self.ConcurrentQueryLocks.startExclusive();
       Self.ConcurrencyCheckValue.start();
     }
     ~ConcurrencyCheck() {
       Self.ConcurrencyCheckValue.finish();
+      if (Self.ConcurrentQueries)
+        Self.ConcurrentQueryLocks.finishExclusive();
     }
   };
   friend class ConcurrencyCheck;
-  
+
+  /// \brief Scoped use of the ASTUnit that only reads it.
+  ///
+  /// With concurrent queries enabled, any number of threads may hold one of
+  /// these at once. Otherwise this behaves like ConcurrencyCheck.
+  class ReadOnlyCheck {
+    ASTUnit &Self;
+
+    /// \brief The innermost ReadOnlyCheck of this thread that encloses this
+    /// one, on any ASTUnit.
+    const ReadOnlyCheck *Outer;
+
+    /// \brief Whether this check holds the shared lock, rather than an
+    /// enclosing check of this thread.
+    bool HoldsSharedLock;
+
+  public:
+    explicit ReadOnlyCheck(ASTUnit &Self);
+    ~ReadOnlyCheck();
+  };
+  friend class ReadOnlyCheck;
+
+  /// \brief Serializes read-only queries while they touch state that is
+  /// still built on first use, such as the identifier table.
+  ///
+  /// Does nothing unless concurrent queries are enabled.
+  class LazyStateGuard {
+    ASTUnit &Self;
+
+  public:
+    explicit LazyStateGuard(ASTUnit &Self) : Self(Self) {
+      if (Self.ConcurrentQueries)
+        Self.ConcurrentQueryLocks.lockLazyState();
+    }
+    ~LazyStateGuard() {
+      if (Self.ConcurrentQueries)
+        Self.ConcurrentQueryLocks.unlockLazyState();
+    }
+  };
+  friend class LazyStateGuard;
+
   ~ASTUnit();
 
   bool isMainFileAST() const { return MainFileIsAST; }
@@ -526,6 +775,33 @@ public:
     TopLevelDeclsInPreamble.push_back(D);
   }
 
+  /// \brief Determine whether the parser should leave the body of \p FD,
+  /// spanning \p BodyRange, for parsing on demand, and if so, tell \p S what
+  /// the body uses.
+  ///
+  /// Note: This is used internally by the top-level tracking action
+  bool shouldParseFunctionBodyLazily(Sema &S, FunctionDecl *FD,
+                                     SourceRange BodyRange);
+
+  /// \brief Parse the body of \p FD if the parser left it lazy.
+  ///
+  /// \returns true if a body was parsed.
+  bool parseLazyFunctionBody(FunctionDecl *FD);
+
+  /// \brief Parse the lazy bodies of the functions declared by \p D or
+  /// nested in it.
+  ///
+  /// Parsing a body modifies the AST, so this is a use of the ASTUnit that may
+  /// modify it, like a reparse: a query that only reads the AST calls this
+  /// for the region it is about to walk before it takes its ReadOnlyCheck.
+  /// Within a ReadOnlyCheck, e.g. from a visitor callback, this parses
+  /// nothing, and the query sees the bodies that the enclosing query parsed.
+  void parseLazyFunctionBodies(Decl *D);
+
+  /// \brief Parse the lazy bodies overlapping \p Range, or all of them if
+  /// \p Range is invalid, as parseLazyFunctionBodies(Decl*) does.
+  void parseLazyFunctionBodies(SourceRange Range = SourceRange());
+
   /// \brief Retrieve a reference to the current top-level name hash value.
   ///
   /// Note: This is used internally by the top-level tracking action
@@ -749,6 +1025,9 @@ public:
                             bool IncludeBriefCommentsInCodeCompletion = false,
                                       bool AllowPCHWithCompilerErrors = false,
                                       bool SkipFunctionBodies = false,
+                                      bool LazyFunctionBodies = false,
+                                      bool IncrementalFunctionBodies = false,
+                                      bool ConcurrentQueries = false,
                                       bool UserFilesAreVolatile = false,
                                       OwningPtr<ASTUnit> *ErrAST = 0);
   
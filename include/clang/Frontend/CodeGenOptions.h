@@ -79,6 +79,9 @@ public:
                                   ///< template classes with hidden visibility
   unsigned HiddenWeakVTables : 1; ///< Emit weak vtables, RTTI, and thunks with
                                   ///< hidden visibility.
+  unsigned HomeClassDebugInfo : 1; ///< Describe classes in full only where
+                                   ///< their vtable or explicit instantiation
+                                   ///< is emitted (-fhome-class-debug-info).
   unsigned InstrumentFunctions : 1; ///< Set when -finstrument-functions is
                                     ///< enabled.
   unsigned InstrumentForProfiling : 1; ///< Set when -pg is enabled.
@@ -176,6 +179,11 @@ public:
   /// A list of command-line options to forward to the LLVM backend.
   std::vector<std::string> BackendOptions;
 
+  /// The object files to write the module partitions after the first to,
+  /// when generating code for them separately. Partitions that end up empty
+  /// still get an object file.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// The user specified number of registers to be used for integral arguments,
   /// or 0 if unspecified.
   unsigned NumRegisterParameters;
@@ -186,6 +194,11 @@ public:
   /// The lower bound for a buffer to be considered for stack protection.
   unsigned SSPBufferSize;
 
+  /// The number of module partitions to generate object files for
+  /// separately, or 0 or 1 to generate code for the whole module at once.
+  /// Only used with ParallelCodeGenOutputs.
+  unsigned ParallelCodeGen;
+
   /// The default TLS model to use.
   TLSModel DefaultTLSModel;
 
@@ -208,6 +221,7 @@ public:
     FunctionSections = 0;
     HiddenWeakTemplateVTables = 0;
     HiddenWeakVTables = 0;
+    HomeClassDebugInfo = 0;
     InstrumentFunctions = 0;
     InstrumentForProfiling = 0;
     LessPreciseFPMAD = 0;
@@ -242,6 +256,7 @@ public:
     StackAlignment = 0;
     BoundsChecking = 0;
     SSPBufferSize = 8;
+    ParallelCodeGen = 0;
     UseInitArray = 0;
 
     DebugInfo = NoDebugInfo;
@@ -111,6 +111,20 @@ class CompilerInstance : public ModuleLoader {
   /// \brief The result of the last module import.
   ///
   Module *LastModuleImportResult;
+
+  /// \brief Whether we have already given the module cache a chance to be
+  /// pruned.
+  bool HaveConsideredModuleCachePruning;
+
+  /// \brief The number of module imports satisfied by a module file that was
+  /// already in the module cache.
+  unsigned NumModuleCacheHits;
+
+  /// \brief The number of module imports that required building the module.
+  unsigned NumModuleCacheMisses;
+
+  /// \brief The wall-clock time spent building modules, in seconds.
+  double ModuleBuildTime;
   
   /// \brief Holds information about the output file.
   ///
@@ -544,7 +558,8 @@ public:
                              bool DisableStatCache,
                              bool AllowPCHWithCompilerErrors,
                              Preprocessor &PP, ASTContext &Context,
-                             void *DeserializationListener, bool Preamble);
+                             void *DeserializationListener, bool Preamble,
+                             bool LazyPCHValidation = false);
 
   /// Create a code completion consumer using the invocation; note that this
   /// will cause the source manager to truncate the input source file at the
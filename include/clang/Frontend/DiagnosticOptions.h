@@ -49,11 +49,14 @@ public:
 
   unsigned ElideType: 1;         /// Elide identical types in template diffing
   unsigned ShowTemplateTree: 1;  /// Print a template tree when diffing
+  unsigned FoldTemplateBacktrace: 1; /// Fold repeated instantiation contexts
 
   unsigned ErrorLimit;           /// Limit # errors emitted.
   unsigned MacroBacktraceLimit;  /// Limit depth of macro expansion backtrace.
   unsigned TemplateBacktraceLimit; /// Limit depth of instantiation backtrace.
   unsigned ConstexprBacktraceLimit; /// Limit depth of constexpr backtrace.
+  unsigned NoteByteLimit;        /// Limit bytes printed for a diagnostic
+                                 /// before its remaining notes are dropped.
 
   /// The distance between tab stops.
   unsigned TabStop;
@@ -103,6 +106,8 @@ public:
     TemplateBacktraceLimit = DefaultTemplateBacktraceLimit;
     MacroBacktraceLimit = DefaultMacroBacktraceLimit;
     ConstexprBacktraceLimit = DefaultConstexprBacktraceLimit;
+    FoldTemplateBacktrace = 0;
+    NoteByteLimit = 0;
   }
 };
 
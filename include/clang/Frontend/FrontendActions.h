@@ -203,6 +203,16 @@ protected:
   void ExecuteAction();
 };
 
+/// \brief Evaluate only the preprocessor directives of the input, which is
+/// enough to find the files it depends on (e.g., for -MD/-MF output).
+///
+/// Text outside of directives is skipped without being tokenized or macro
+/// expanded, so diagnostics that would be produced there are not.
+class ScanDependenciesAction : public PreprocessorFrontendAction {
+protected:
+  void ExecuteAction();
+};
+
 class PrintPreprocessedAction : public PreprocessorFrontendAction {
 protected:
   void ExecuteAction();
@@ -49,7 +49,8 @@ namespace frontend {
     RewriteTest,            ///< Rewriter playground
     RunAnalysis,            ///< Run one or more source code analyses.
     MigrateSource,          ///< Run migrator.
-    RunPreprocessorOnly     ///< Just lex, no output.
+    RunPreprocessorOnly,    ///< Just lex, no output.
+    ScanDependencies        ///< Only evaluate preprocessor directives.
   };
 }
 
@@ -97,6 +98,8 @@ public:
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowStats : 1;                  ///< Show frontend performance
                                            /// metrics and statistics.
+  unsigned ShowModuleCacheStats : 1;       ///< Show module cache hits,
+                                           /// misses and build times.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
   unsigned ShowVersion : 1;                ///< Show the -version text.
@@ -111,6 +114,13 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned LazyFunctionBodies : 1;         ///< Cache function bodies and
+                                           /// parse them only when a client
+                                           /// asks for them.
+
+  /// \brief If nonzero, the offset at which the source manager runs out of
+  /// local source locations. Only useful for testing.
+  unsigned SourceLocationLimit;
 
   CodeCompleteOptions CodeCompleteOpts;
 
@@ -185,11 +195,14 @@ public:
     RelocatablePCH = 0;
     ShowHelp = 0;
     ShowStats = 0;
+    ShowModuleCacheStats = 0;
     ShowTimers = 0;
     ShowVersion = 0;
     ARCMTAction = ARCMT_None;
     ARCMTMigrateEmitARCErrors = 0;
     SkipFunctionBodies = 0;
+    LazyFunctionBodies = 0;
+    SourceLocationLimit = 0;
     ObjCMTAction = ObjCMT_None;
   }
 
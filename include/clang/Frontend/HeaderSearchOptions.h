@@ -103,6 +103,22 @@ public:
   ///
   /// Note: Only used for testing!
   unsigned DisableModuleHash : 1;
+
+  /// \brief The interval (in seconds) between pruning operations on the
+  /// module cache, or zero to never prune.
+  ///
+  /// The time of the last pruning is kept in a "modules.timestamp" file at
+  /// the root of the module cache.
+  unsigned ModuleCachePruneInterval;
+
+  /// \brief The time (in seconds) after which an unused module file in the
+  /// module cache is considered stale and removed when the cache is pruned.
+  unsigned ModuleCachePruneAfter;
+
+  /// \brief The maximum size (in megabytes) of the module files in the module
+  /// cache, or zero for no limit. When the cache is pruned and exceeds this
+  /// size, the least recently used module files are removed first.
+  unsigned ModuleCacheMaxSize;
   
   /// Include the compiler builtin includes.
   unsigned UseBuiltinIncludes : 1;
@@ -121,7 +137,10 @@ public:
 
 public:
   HeaderSearchOptions(StringRef _Sysroot = "/")
-    : Sysroot(_Sysroot), DisableModuleHash(0), UseBuiltinIncludes(true),
+    : Sysroot(_Sysroot), DisableModuleHash(0),
+      ModuleCachePruneInterval(7*24*60*60),
+      ModuleCachePruneAfter(31*24*60*60), ModuleCacheMaxSize(0),
+      UseBuiltinIncludes(true),
       UseStandardSystemIncludes(true), UseStandardCXXIncludes(true),
       UseLibcxx(false), Verbose(false) {}
 
@@ -44,6 +44,8 @@ public:
   virtual void HandleTopLevelDeclInObjCContainer(DeclGroupRef D);
   virtual void CompleteTentativeDefinition(VarDecl *D);
   virtual void HandleVTable(CXXRecordDecl *RD, bool DefinitionRequired);
+  virtual bool shouldParseFunctionBodyLazily(FunctionDecl *FD,
+                                             SourceRange BodyRange);
   virtual ASTMutationListener *GetASTMutationListener();
   virtual ASTDeserializationListener *GetASTDeserializationListener();
   virtual void PrintStats();
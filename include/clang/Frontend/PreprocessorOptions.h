@@ -65,6 +65,10 @@ public:
   /// precompiled headers.
   bool DisablePCHValidation;
 
+  /// \brief When true, the input files of a precompiled header or AST file
+  /// are checked against the file system only when they are first used.
+  bool LazyPCHValidation;
+
   /// \brief When true, disables the use of the stat cache within a
   /// precompiled header or AST file.
   bool DisableStatCache;
@@ -167,7 +171,8 @@ public:
 public:
   PreprocessorOptions() : UsePredefines(true), DetailedRecord(false),
                           DetailedRecordConditionalDirectives(false),
-                          DisablePCHValidation(false), DisableStatCache(false),
+                          DisablePCHValidation(false), LazyPCHValidation(false),
+                          DisableStatCache(false),
                           AllowPCHWithCompilerErrors(false),
                           DumpDeserializedPCHDecls(false),
                           PrecompiledPreambleBytes(0, true),
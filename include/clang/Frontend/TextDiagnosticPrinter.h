@@ -36,6 +36,13 @@ class TextDiagnosticPrinter : public DiagnosticConsumer {
 
   unsigned OwnsOutputStream : 1;
 
+  /// Whether the notes of the current diagnostic are being dropped because
+  /// of -fdiagnostics-note-byte-limit.
+  unsigned DroppingNotes : 1;
+
+  /// The number of bytes printed for the current diagnostic and its notes.
+  uint64_t BytesPrintedForDiag;
+
 public:
   TextDiagnosticPrinter(raw_ostream &os, const DiagnosticOptions &diags,
                         bool OwnsOutputStream = false);
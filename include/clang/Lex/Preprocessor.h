@@ -654,6 +654,15 @@ public:
     DisableMacroExpansion = OldVal;
   }
 
+  /// \brief Skip the text of the current file up to the next preprocessing
+  /// directive (or the end of the file), without forming identifiers or
+  /// expanding macros.
+  ///
+  /// This is for clients that only care about the effect of directives, such
+  /// as dependency scanning. It does nothing while lexing from a macro
+  /// expansion or a PTH file.
+  void SkipToNextDirective();
+
   /// LexUnexpandedNonComment - Like LexNonComment, but this disables macro
   /// expansion of identifier tokens.
   void LexUnexpandedNonComment(Token &Result) {
@@ -37,12 +37,14 @@ namespace clang {
                 ASTContext &Ctx, bool PrintStats = false,
                 TranslationUnitKind TUKind = TU_Complete,
                 CodeCompleteConsumer *CompletionConsumer = 0,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                bool LazyFunctionBodies = false);
 
   /// \brief Parse the main file known to the preprocessor, producing an 
   /// abstract syntax tree.
   void ParseAST(Sema &S, bool PrintStats = false,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                bool LazyFunctionBodies = false);
   
 }  // end namespace clang
 
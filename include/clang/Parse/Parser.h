@@ -223,8 +223,13 @@ class Parser : public CodeCompletionHandler {
 
   bool SkipFunctionBodies;
 
+  /// \brief Whether to cache function bodies instead of parsing them, so
+  /// that they can be parsed on demand through Sema::ParseLazyFunctionBody.
+  bool LazyFunctionBodies;
+
 public:
-  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies);
+  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies,
+         bool LazyFunctionBodies = false);
   ~Parser();
 
   const LangOptions &getLangOpts() const { return PP.getLangOpts(); }
@@ -1053,6 +1058,64 @@ private:
   static void LateTemplateParserCallback(void *P, const FunctionDecl *FD);
   void LateTemplateParser(const FunctionDecl *FD);
 
+  /// \brief Contains the cached tokens of a function body that was skipped
+  /// in lazy-body mode. Will be parsed when a client asks for the body.
+  struct LazyParsedFunctionBody {
+    explicit LazyParsedFunctionBody(FunctionDecl *FD)
+      : D(FD) {}
+
+    CachedTokens Toks;
+
+    /// \brief The function whose body is cached.
+    FunctionDecl *D;
+
+    /// \brief The #pragma STDC FP_CONTRACT and OPENCL EXTENSION state at the
+    /// body, which the end of the translation unit may no longer have.
+    FPOptions FPFeatures;
+    OpenCLOptions OpenCLFeatures;
+
+    /// \brief The identifiers the body mentions, sorted, while it is in
+    /// \c PendingLazyBodies.
+    SmallVector<IdentifierInfo*, 16> Names;
+  };
+
+  bool canParseFunctionBodyLazily(Decl *D);
+  bool callsUndeclaredFunction(const CachedTokens &Toks);
+  void ParseLazyFunctionBody(FunctionDecl *FD);
+  typedef llvm::DenseMap<const FunctionDecl*, LazyParsedFunctionBody*>
+    LazyParsedBodyMapT;
+  LazyParsedBodyMapT LazyParsedBodyMap;
+
+  /// \brief The cached bodies that were not parsed yet, in the order they
+  /// were cached, until the end of the translation unit.
+  ///
+  /// A body is parsed right before the parser hands Sema a later declaration
+  /// of a name the body mentions, or a declaration that may change its
+  /// meaning without being mentioned in it, so that it means what it would
+  /// have meant if parsed in place.
+  SmallVector<LazyParsedFunctionBody*, 16> PendingLazyBodies;
+
+  /// \brief How many of the \c PendingLazyBodies mention each identifier.
+  llvm::DenseMap<IdentifierInfo*, unsigned> PendingLazyBodyNames;
+
+  void addPendingLazyBody(LazyParsedFunctionBody *LB);
+  bool isDeclaredName(IdentifierInfo *II, unsigned IDNS);
+  void ParsePendingLazyBodies(IdentifierInfo *Name);
+  void ParsePendingLazyBodies(Declarator &D);
+  void ParsePendingLazyBodiesBeforeTag(IdentifierInfo *Name,
+                                       Sema::TagUseKind TUK,
+                                       bool IsQualified);
+  void ParsePendingLazyBodiesBeforeDefinition(Decl *TagOrTemplate);
+
+public:
+  /// \brief Whether any function body was cached for lazy parsing.
+  bool hasLazyFunctionBodies() const { return !LazyParsedBodyMap.empty(); }
+
+  static void LazyBodyParserCallback(void *P, FunctionDecl *FD);
+  static void LazyBodyParserCleanup(void *P);
+
+private:
+
   Sema::ParsingClassState
   PushParsingClass(Decl *TagOrTemplate, bool TopLevelClass);
   void DeallocateParsedClasses(ParsingClass *Class);
@@ -42,6 +42,7 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include <deque>
 #include <string>
 
@@ -363,6 +364,116 @@ public:
     OpaqueParser = P;
   }
 
+  /// \brief Callback to the parser to parse function bodies that were skipped
+  /// in lazy-body mode, and to release the parser once Sema is done with it.
+  typedef void LazyBodyParserCB(void *P, FunctionDecl *FD);
+  typedef void LazyBodyParserCleanupCB(void *P);
+  LazyBodyParserCB *LazyBodyParser;
+  LazyBodyParserCleanupCB *LazyBodyParserCleanup;
+  void *OpaqueLazyBodyParser;
+
+  /// \brief Hand over a parser that holds the cached tokens of lazily
+  /// parsed function bodies. Sema owns it from then on and releases it
+  /// through \p Cleanup.
+  void SetLazyBodyParser(LazyBodyParserCB *LBP,
+                         LazyBodyParserCleanupCB *Cleanup, void *P) {
+    LazyBodyParser = LBP;
+    LazyBodyParserCleanup = Cleanup;
+    OpaqueLazyBodyParser = P;
+  }
+
+  /// \brief Parse the body of \p FD if the parser skipped it in lazy-body
+  /// mode.
+  ///
+  /// \returns true if a body was parsed.
+  bool ParseLazyFunctionBody(FunctionDecl *FD);
+
+  /// \brief What the function bodies left lazy use, as the keys from
+  /// getLazyFunctionBodyUseKey() of declarations that are checked for uses
+  /// at the end of the translation unit, mapped to whether they are used
+  /// rather than only referenced.
+  ///
+  /// A client that leaves a body lazy because it parsed the same body
+  /// before fills this in, so that the declarations only that body uses are
+  /// not reported as unused.
+  llvm::StringMap<bool> LazyFunctionBodyUses;
+
+  /// \brief The identifiers that the function bodies still lazy at the end
+  /// of the translation unit mention.
+  ///
+  /// The parser fills this in. The declarations with these names are taken
+  /// as used, since the bodies may use them; the bodies' own diagnostics,
+  /// such as uses of undefined internal declarations, are not reported.
+  llvm::SmallPtrSet<IdentifierInfo *, 32> LazyFunctionBodyNames;
+
+  /// \brief Identify \p D across parses of the same source by its qualified
+  /// name and type.
+  static std::string getLazyFunctionBodyUseKey(const NamedDecl *D);
+
+  /// \brief Mark the declarations in \c LazyFunctionBodyUses as used or
+  /// referenced, and those named in \c LazyFunctionBodyNames as used.
+  void MarkLazyFunctionBodyUses();
+
+  /// \brief What parsing a function body used, recorded at parse time so
+  /// that a client can leave the same body lazy on a later parse.
+  struct FunctionBodyUses {
+    /// \brief Keys of the declarations that the body uses, or only
+    /// references, as in \c LazyFunctionBodyUses.
+    std::vector<std::string> UsedDecls, ReferencedDecls;
+
+    /// \brief Whether parsing the body did more than mark declarations used:
+    /// instantiate templates, define implicit members, use vtables or note
+    /// undefined internal declarations. A parse that leaves the body lazy
+    /// would do none of that, so the body can't be left lazy.
+    bool HasNonLocalEffects;
+
+    FunctionBodyUses() : HasNonLocalEffects(false) { }
+  };
+
+  /// \brief The uses recorded while parsing function bodies that the
+  /// consumer wanted parsed right away in lazy-body mode.
+  llvm::DenseMap<const FunctionDecl *, FunctionBodyUses>
+    RecordedFunctionBodyUses;
+
+  /// \brief Where the uses of the function body being parsed are recorded,
+  /// if anywhere.
+  FunctionBodyUses *CurFunctionBodyUses;
+
+  /// \brief Records the uses of the function body parsed while this object
+  /// is alive, once record() is called.
+  class FunctionBodyUsesRAII {
+  public:
+    explicit FunctionBodyUsesRAII(Sema &S)
+      : S(S), SavedUses(S.CurFunctionBodyUses) { }
+
+    void record(const FunctionDecl *FD) {
+      S.CurFunctionBodyUses = &S.RecordedFunctionBodyUses[FD];
+    }
+
+    ~FunctionBodyUsesRAII() {
+      S.CurFunctionBodyUses = SavedUses;
+    }
+
+  private:
+    Sema &S;
+    FunctionBodyUses *SavedUses;
+  };
+
+  /// \brief Record that the function body being parsed uses \p D, or only
+  /// references it.
+  void recordFunctionBodyUse(const NamedDecl *D, bool Used) {
+    if (CurFunctionBodyUses)
+      recordFunctionBodyUseSlow(D, Used);
+  }
+  void recordFunctionBodyUseSlow(const NamedDecl *D, bool Used);
+
+  /// \brief Record that parsing the current function body has effects
+  /// beyond the body.
+  void recordFunctionBodyNonLocalEffect() {
+    if (CurFunctionBodyUses)
+      CurFunctionBodyUses->HasNonLocalEffects = true;
+  }
+
   class DelayedDiagnostics;
 
   class DelayedDiagnosticsState {
@@ -5714,6 +5825,10 @@ public:
     Sema &SemaRef;
     bool Invalid;
     bool SavedInNonInstantiationSFINAEContext;
+    /// \brief The ASTContext::AllocationOwner to restore when this
+    /// instantiation is popped, or ASTContext::NumAllocationOwners once it
+    /// has been restored.
+    unsigned SavedAllocationOwner;
     bool CheckInstantiationDepth(SourceLocation PointOfInstantiation,
                                  SourceRange InstantiationRange);
 
@@ -586,6 +586,11 @@ private:
   /// \brief Whether to disable the use of stat caches in AST files.
   bool DisableStatCache;
 
+  /// \brief Whether to check the input files of an AST file against the
+  /// file system only when their source location entries are first read,
+  /// rather than all of them when the AST file is loaded.
+  bool ValidateInputFilesLazily;
+
   /// \brief Whether to accept an AST file with compiler errors.
   bool AllowASTWithCompilerErrors;
 
@@ -610,6 +615,10 @@ private:
   /// the PCH file.
   unsigned NumSLocEntriesRead;
 
+  /// \brief The number of input files checked against the file system, and
+  /// the number of input files in the chain.
+  unsigned NumInputFilesValidated, TotalNumInputFiles;
+
   /// \brief The number of source location entries in the chain.
   unsigned TotalNumSLocEntries;
 
@@ -906,6 +915,19 @@ public:
   /// the actual file in the file system.
   ASTReadResult validateFileEntries(ModuleFile &M);
 
+  /// \brief Checks a single input file of an AST file against the file
+  /// system, given the size and modification time recorded for it.
+  ///
+  /// \returns true if the file is unchanged.
+  bool validateInputFile(StringRef Filename, const FileEntry *File,
+                         off_t StoredSize, time_t StoredTime);
+
+  /// \brief Check input files only when their source location entries are
+  /// first read. Must be set before the AST file is loaded.
+  void setValidateInputFilesLazily(bool Lazy) {
+    ValidateInputFilesLazily = Lazy;
+  }
+
   /// \brief Make the entities in the given module and any of its (non-explicit)
   /// submodules visible to name lookup.
   ///
@@ -80,6 +80,10 @@ public:
 
   /// \brief The generation of which this module file is a part.
   unsigned Generation;
+
+  /// \brief The position of this module file in the module manager's
+  /// chain.
+  unsigned Index;
   
   /// \brief The memory buffer that stores the data associated with
   /// this AST file.
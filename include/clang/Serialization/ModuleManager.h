@@ -38,6 +38,14 @@ class ModuleManager {
   
   /// \brief A lookup of in-memory (virtual file) buffers
   llvm::DenseMap<const FileEntry *, llvm::MemoryBuffer *> InMemoryBuffers;
+
+  /// \brief The order in which visit() walks the modules, from the roots of
+  /// the import graph to its leaves.
+  ///
+  /// Computed on demand by visit() and cleared whenever a module or an
+  /// import edge is added, so that each identifier or selector lookup does
+  /// not have to re-sort the module graph.
+  SmallVector<ModuleFile *, 4> VisitOrder;
   
 public:
   typedef SmallVector<ModuleFile*, 2>::iterator ModuleIterator;
@@ -13,6 +13,7 @@
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/SourceLocation.h"
 using namespace clang;
 
 bool ASTConsumer::HandleTopLevelDecl(DeclGroupRef D) {
@@ -24,3 +25,8 @@ void ASTConsumer::HandleInterestingDecl(DeclGroupRef D) {
 }
 
 void ASTConsumer::HandleTopLevelDeclInObjCContainer(DeclGroupRef D) {}
+
+bool ASTConsumer::shouldParseFunctionBodyLazily(FunctionDecl *FD,
+                                                SourceRange BodyRange) {
+  return true;
+}
@@ -33,6 +33,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Capacity.h"
 #include "CXXABI.h"
+#include <algorithm>
 #include <map>
 
 using namespace clang;
@@ -49,6 +50,9 @@ unsigned ASTContext::NumImplicitMoveAssignmentOperators;
 unsigned ASTContext::NumImplicitMoveAssignmentOperatorsDeclared;
 unsigned ASTContext::NumImplicitDestructors;
 unsigned ASTContext::NumImplicitDestructorsDeclared;
+unsigned ASTContext::NumTemplateSpecializationLookups;
+unsigned ASTContext::NumTemplateSpecializationLookupHits;
+bool ASTContext::AllocationStatisticsEnabled = false;
 
 enum FloatingRank {
   HalfRank, FloatRank, DoubleRank, LongDoubleRank
@@ -574,6 +578,7 @@ ASTContext::ASTContext(LangOptions& LOpts, SourceManager &SM,
     ExternalSource(0), Listener(0),
     Comments(SM), CommentsLoaded(false),
     CommentCommandTraits(BumpAlloc),
+    CurrentAllocationOwner(AO_Other),
     LastSDM(0, 0),
     UniqueBlockByRefTypeID(0) 
 {
@@ -647,7 +652,8 @@ void ASTContext::PrintStats() const {
 #define TYPE(Name, Parent)                                              \
   if (counts[Idx])                                                      \
     llvm::errs() << "    " << counts[Idx] << " " << #Name               \
-                 << " types\n";                                         \
+                 << " types, " << sizeof(Name##Type) << " each ("       \
+                 << counts[Idx] * sizeof(Name##Type) << " bytes)\n";    \
   TotalBytes += counts[Idx] * sizeof(Name##Type);                       \
   ++Idx;
 #define ABSTRACT_TYPE(Name, Parent)
@@ -677,14 +683,111 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (getLangOpts().CPlusPlus)
+    PrintTemplateSpecializationStats();
+
   if (ExternalSource.get()) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
   }
 
+  PrintAllocationStats();
   BumpAlloc.PrintStats();
 }
 
+void ASTContext::EnableAllocationStatistics() {
+  AllocationStatisticsEnabled = true;
+}
+
+void ASTContext::PrintAllocationStats() const {
+  if (!AllocationStatisticsEnabled)
+    return;
+
+  static const char *const OwnerNames[NumAllocationOwners] = {
+    "other", "parse", "sema", "template instantiation", "serialization"
+  };
+  static const char *const CategoryNames[NumAllocationCategories] = {
+    "other", "type", "decl", "stmt/expr"
+  };
+
+  llvm::errs() << "\n*** AST Allocation Stats:\n";
+  uint64_t TotalAllocations = 0, TotalBytes = 0;
+  uint64_t CategoryBytes[NumAllocationCategories] = { 0 };
+  for (unsigned O = 0; O != NumAllocationOwners; ++O) {
+    uint64_t OwnerAllocations = 0, OwnerBytes = 0;
+    for (unsigned C = 0; C != NumAllocationCategories; ++C) {
+      OwnerAllocations += AllocationStats[O][C].NumAllocations;
+      OwnerBytes += AllocationStats[O][C].NumBytes;
+      CategoryBytes[C] += AllocationStats[O][C].NumBytes;
+    }
+    if (OwnerAllocations == 0)
+      continue;
+
+    llvm::errs() << "  " << OwnerBytes << " bytes in " << OwnerAllocations
+                 << " allocations by " << OwnerNames[O] << "\n";
+    for (unsigned C = 0; C != NumAllocationCategories; ++C)
+      if (AllocationStats[O][C].NumAllocations)
+        llvm::errs() << "    " << AllocationStats[O][C].NumBytes
+                     << " bytes in " << AllocationStats[O][C].NumAllocations
+                     << " " << CategoryNames[C] << " allocations\n";
+    TotalAllocations += OwnerAllocations;
+    TotalBytes += OwnerBytes;
+  }
+
+  for (unsigned C = 0; C != NumAllocationCategories; ++C)
+    if (CategoryBytes[C])
+      llvm::errs() << "  " << CategoryBytes[C] << " bytes total for "
+                   << CategoryNames[C] << " allocations\n";
+  llvm::errs() << "Total bytes = " << TotalBytes << " in " << TotalAllocations
+               << " allocations\n";
+}
+
+namespace {
+  /// \brief Orders templates by decreasing number of specializations.
+  struct SpecializationCountGreater {
+    typedef std::pair<unsigned, RedeclarableTemplateDecl *> Entry;
+    bool operator()(const Entry &LHS, const Entry &RHS) const {
+      return LHS.first > RHS.first;
+    }
+  };
+}
+
+void ASTContext::PrintTemplateSpecializationStats() const {
+  llvm::errs() << "\n*** Template Specialization Stats:\n";
+  llvm::errs() << "  " << NumTemplateSpecializationLookupHits << "/"
+               << NumTemplateSpecializationLookups
+               << " specialization lookups found an existing specialization\n";
+
+  typedef std::pair<unsigned, RedeclarableTemplateDecl *> Entry;
+  SmallVector<Entry, 16> Counts;
+  unsigned TotalSpecs = 0;
+  for (unsigned I = 0, N = SpecializableTemplates.size(); I != N; ++I) {
+    RedeclarableTemplateDecl *Template = SpecializableTemplates[I];
+    unsigned NumSpecs = 0;
+    if (FunctionTemplateDecl *FTD = dyn_cast<FunctionTemplateDecl>(Template))
+      NumSpecs = FTD->getNumSpecializations();
+    else if (ClassTemplateDecl *CTD = dyn_cast<ClassTemplateDecl>(Template))
+      NumSpecs = CTD->getNumLoadedSpecializations();
+    if (NumSpecs == 0)
+      continue;
+
+    TotalSpecs += NumSpecs;
+    Counts.push_back(Entry(NumSpecs, Template));
+  }
+
+  llvm::errs() << "  " << TotalSpecs << " specializations of "
+               << Counts.size() << " templates\n";
+
+  // Only the templates with the most specializations are interesting; a
+  // stable sort keeps the report deterministic for ties.
+  std::stable_sort(Counts.begin(), Counts.end(), SpecializationCountGreater());
+  const unsigned MaxTemplatesShown = 10;
+  for (unsigned I = 0, N = std::min<unsigned>(MaxTemplatesShown, Counts.size());
+       I != N; ++I)
+    llvm::errs() << "    " << Counts[I].first << " "
+                 << Counts[I].second->getQualifiedNameAsString() << "\n";
+}
+
 TypedefDecl *ASTContext::getInt128Decl() const {
   if (!Int128Decl) {
     TypeSourceInfo *TInfo = getTrivialTypeSourceInfo(Int128Ty);
@@ -1711,7 +1814,7 @@ TypeSourceInfo *ASTContext::CreateTypeSourceInfo(QualType T,
            "incorrect data size provided to CreateTypeSourceInfo!");
 
   TypeSourceInfo *TInfo =
-    (TypeSourceInfo*)BumpAlloc.Allocate(sizeof(TypeSourceInfo) + DataSize, 8);
+    (TypeSourceInfo*)Allocate(sizeof(TypeSourceInfo) + DataSize, 8, AC_Type);
   new (TInfo) TypeSourceInfo(T);
   return TInfo;
 }
@@ -2560,7 +2663,8 @@ ASTContext::getFunctionType(QualType ResultTy,
   if (EPI.ConsumedArguments)
     Size += NumArgs * sizeof(bool);
 
-  FunctionProtoType *FTP = (FunctionProtoType*) Allocate(Size, TypeAlignment);
+  FunctionProtoType *FTP
+    = (FunctionProtoType*) Allocate(Size, TypeAlignment, AC_Type);
   FunctionProtoType::ExtProtoInfo newEPI = EPI;
   newEPI.ExtInfo = EPI.ExtInfo.withCallingConv(CallConv);
   new (FTP) FunctionProtoType(ResultTy, ArgArray, NumArgs, Canonical, newEPI);
@@ -2872,7 +2976,7 @@ ASTContext::getTemplateSpecializationType(TemplateName Template,
   void *Mem = Allocate(sizeof(TemplateSpecializationType) +
                        sizeof(TemplateArgument) * NumArgs +
                        (IsTypeAlias? sizeof(QualType) : 0),
-                       TypeAlignment);
+                       TypeAlignment, AC_Type);
   TemplateSpecializationType *Spec
     = new (Mem) TemplateSpecializationType(Template, Args, NumArgs, CanonType,
                                          IsTypeAlias ? Underlying : QualType());
@@ -2913,7 +3017,7 @@ ASTContext::getCanonicalTemplateSpecializationType(TemplateName Template,
     // Allocate a new canonical template specialization type.
     void *Mem = Allocate((sizeof(TemplateSpecializationType) +
                           sizeof(TemplateArgument) * NumArgs),
-                         TypeAlignment);
+                         TypeAlignment, AC_Type);
     Spec = new (Mem) TemplateSpecializationType(CanonTemplate,
                                                 CanonArgs.data(), NumArgs,
                                                 QualType(), QualType());
@@ -3067,7 +3171,7 @@ ASTContext::getDependentTemplateSpecializationType(
 
   void *Mem = Allocate((sizeof(DependentTemplateSpecializationType) +
                         sizeof(TemplateArgument) * NumArgs),
-                       TypeAlignment);
+                       TypeAlignment, AC_Type);
   T = new (Mem) DependentTemplateSpecializationType(Keyword, NNS,
                                                     Name, NumArgs, Args, Canon);
   Types.push_back(T);
@@ -3185,7 +3289,7 @@ QualType ASTContext::getObjCObjectType(QualType BaseType,
 
   unsigned Size = sizeof(ObjCObjectTypeImpl);
   Size += NumProtocols * sizeof(ObjCProtocolDecl *);
-  void *Mem = Allocate(Size, TypeAlignment);
+  void *Mem = Allocate(Size, TypeAlignment, AC_Type);
   ObjCObjectTypeImpl *T =
     new (Mem) ObjCObjectTypeImpl(Canonical, BaseType, Protocols, NumProtocols);
 
@@ -3215,7 +3319,7 @@ QualType ASTContext::getObjCObjectPointerType(QualType ObjectT) const {
   }
 
   // No match.
-  void *Mem = Allocate(sizeof(ObjCObjectPointerType), TypeAlignment);
+  void *Mem = Allocate(sizeof(ObjCObjectPointerType), TypeAlignment, AC_Type);
   ObjCObjectPointerType *QType =
     new (Mem) ObjCObjectPointerType(Canonical, ObjectT);
 
@@ -3241,7 +3345,7 @@ QualType ASTContext::getObjCInterfaceType(const ObjCInterfaceDecl *Decl,
   if (const ObjCInterfaceDecl *Def = Decl->getDefinition())
     Decl = Def;
   
-  void *Mem = Allocate(sizeof(ObjCInterfaceType), TypeAlignment);
+  void *Mem = Allocate(sizeof(ObjCInterfaceType), TypeAlignment, AC_Type);
   ObjCInterfaceType *T = new (Mem) ObjCInterfaceType(Decl);
   Decl->TypeForDecl = T;
   Types.push_back(T);
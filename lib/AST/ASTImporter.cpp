@@ -4439,8 +4439,10 @@ SourceLocation ASTImporter::Import(SourceLocation FromLoc) {
   FromLoc = FromSM.getSpellingLoc(FromLoc);
   std::pair<FileID, unsigned> Decomposed = FromSM.getDecomposedLoc(FromLoc);
   SourceManager &ToSM = ToContext.getSourceManager();
-  return ToSM.getLocForStartOfFile(Import(Decomposed.first))
-             .getLocWithOffset(Decomposed.second);
+  FileID ToID = Import(Decomposed.first);
+  if (ToID.isInvalid())
+    return SourceLocation();
+  return ToSM.getLocForStartOfFile(ToID).getLocWithOffset(Decomposed.second);
 }
 
 SourceRange ASTImporter::Import(SourceRange FromRange) {
@@ -1639,7 +1639,7 @@ bool FunctionDecl::isVariadic() const {
 
 bool FunctionDecl::hasBody(const FunctionDecl *&Definition) const {
   for (redecl_iterator I = redecls_begin(), E = redecls_end(); I != E; ++I) {
-    if (I->Body || I->IsLateTemplateParsed) {
+    if (I->Body || I->IsLateTemplateParsed || I->HasUnparsedCachedBody) {
       Definition = *I;
       return true;
     }
@@ -1664,7 +1664,8 @@ bool FunctionDecl::hasTrivialBody() const
 
 bool FunctionDecl::isDefined(const FunctionDecl *&Definition) const {
   for (redecl_iterator I = redecls_begin(), E = redecls_end(); I != E; ++I) {
-    if (I->IsDeleted || I->IsDefaulted || I->Body || I->IsLateTemplateParsed) {
+    if (I->IsDeleted || I->IsDefaulted || I->Body || I->IsLateTemplateParsed ||
+        I->HasUnparsedCachedBody) {
       Definition = I->IsDeleted ? I->getCanonicalDecl() : *I;
       return true;
     }
@@ -1678,7 +1679,7 @@ Stmt *FunctionDecl::getBody(const FunctionDecl *&Definition) const {
     if (I->Body) {
       Definition = *I;
       return I->Body.get(getASTContext().getExternalSource());
-    } else if (I->IsLateTemplateParsed) {
+    } else if (I->IsLateTemplateParsed || I->HasUnparsedCachedBody) {
       Definition = *I;
       return 0;
     }
@@ -44,7 +44,7 @@ void *Decl::AllocateDeserializedDecl(const ASTContext &Context,
                                      unsigned Size) {
   // Allocate an extra 8 bytes worth of storage, which ensures that the
   // resulting pointer will still be 8-byte aligned. 
-  void *Start = Context.Allocate(Size + 8);
+  void *Start = Context.Allocate(Size + 8, 8, ASTContext::AC_Decl);
   void *Result = (char*)Start + 8;
   
   unsigned *PrefixPtr = (unsigned *)Result - 2;
@@ -169,7 +169,11 @@ RedeclarableTemplateDecl::findSpecializationImpl(
   llvm::FoldingSetNodeID ID;
   EntryType::Profile(ID,Args,NumArgs, getASTContext());
   EntryType *Entry = Specs.FindNodeOrInsertPos(ID, InsertPos);
-  return Entry ? SETraits::getMostRecentDecl(Entry) : 0;
+  ++ASTContext::NumTemplateSpecializationLookups;
+  if (!Entry)
+    return 0;
+  ++ASTContext::NumTemplateSpecializationLookupHits;
+  return SETraits::getMostRecentDecl(Entry);
 }
 
 /// \brief Generate the injected template arguments for the given template
@@ -244,6 +248,7 @@ RedeclarableTemplateDecl::CommonBase *
 FunctionTemplateDecl::newCommon(ASTContext &C) {
   Common *CommonPtr = new (C) Common;
   C.AddDeallocation(DeallocateCommon, CommonPtr);
+  C.addSpecializableTemplate(this);
   return CommonPtr;
 }
 
@@ -331,6 +336,7 @@ RedeclarableTemplateDecl::CommonBase *
 ClassTemplateDecl::newCommon(ASTContext &C) {
   Common *CommonPtr = new (C) Common;
   C.AddDeallocation(DeallocateCommon, CommonPtr);
+  C.addSpecializableTemplate(this);
   return CommonPtr;
 }
 
@@ -662,6 +668,25 @@ TemplateArgumentList::CreateCopy(ASTContext &Context,
   return new (Mem) TemplateArgumentList(StoredArgs, NumArgs, true);
 }
 
+void TemplateArgumentList::Profile(llvm::FoldingSetNodeID &ID,
+                                   const TemplateArgument *Args,
+                                   unsigned NumArgs,
+                                   const ASTContext &Context) {
+  ID.AddInteger(NumArgs);
+  for (unsigned Arg = 0; Arg != NumArgs; ++Arg)
+    Args[Arg].Profile(ID, Context);
+}
+
+unsigned TemplateArgumentList::getProfileHash(const ASTContext &Context) const {
+  if (!HasProfileHash) {
+    llvm::FoldingSetNodeID ID;
+    Profile(ID, data(), size(), Context);
+    ProfileHash = ID.ComputeHash();
+    HasProfileHash = true;
+  }
+  return ProfileHash;
+}
+
 FunctionTemplateSpecializationInfo *
 FunctionTemplateSpecializationInfo::Create(ASTContext &C, FunctionDecl *FD,
                                            FunctionTemplateDecl *Template,
@@ -981,16 +981,14 @@ CallExpr::CallExpr(ASTContext& C, Expr *fn, ArrayRef<Expr*> args,
 
 CallExpr::CallExpr(ASTContext &C, StmtClass SC, EmptyShell Empty)
   : Expr(SC, Empty), SubExprs(0), NumArgs(0) {
-  // FIXME: Why do we allocate this?
-  SubExprs = new (C) Stmt*[PREARGS_START];
+  // The sub-expression array is allocated by setNumArgs() once the number
+  // of arguments is known.
   CallExprBits.NumPreArgs = 0;
 }
 
 CallExpr::CallExpr(ASTContext &C, StmtClass SC, unsigned NumPreArgs,
                    EmptyShell Empty)
   : Expr(SC, Empty), SubExprs(0), NumArgs(0) {
-  // FIXME: Why do we allocate this?
-  SubExprs = new (C) Stmt*[PREARGS_START+NumPreArgs];
   CallExprBits.NumPreArgs = NumPreArgs;
 }
 
@@ -1027,22 +1025,24 @@ FunctionDecl *CallExpr::getDirectCallee() {
 /// to null.
 void CallExpr::setNumArgs(ASTContext& C, unsigned NumArgs) {
   // No change, just return.
-  if (NumArgs == getNumArgs()) return;
+  if (SubExprs && NumArgs == getNumArgs()) return;
 
   // If shrinking # arguments, just delete the extras and forgot them.
-  if (NumArgs < getNumArgs()) {
+  if (SubExprs && NumArgs < getNumArgs()) {
     this->NumArgs = NumArgs;
     return;
   }
 
   // Otherwise, we are growing the # arguments.  New an bigger argument array.
+  // Empty shells have no array yet, so there is nothing to copy over.
   unsigned NumPreArgs = getNumPreArgs();
+  unsigned NumOld = SubExprs ? getNumArgs()+PREARGS_START+NumPreArgs : 0;
   Stmt **NewSubExprs = new (C) Stmt*[NumArgs+PREARGS_START+NumPreArgs];
   // Copy over args.
-  for (unsigned i = 0; i != getNumArgs()+PREARGS_START+NumPreArgs; ++i)
+  for (unsigned i = 0; i != NumOld; ++i)
     NewSubExprs[i] = SubExprs[i];
   // Null out new args.
-  for (unsigned i = getNumArgs()+PREARGS_START+NumPreArgs;
+  for (unsigned i = NumOld;
        i != NumArgs+PREARGS_START+NumPreArgs; ++i)
     NewSubExprs[i] = 0;
 
@@ -20,6 +20,9 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <set>
 
 namespace clang {
@@ -28,6 +31,7 @@ namespace internal {
 namespace {
 
 typedef MatchFinder::MatchCallback MatchCallback;
+typedef MatchFinder::MatcherProfile MatcherProfile;
 
 /// \brief A \c RecursiveASTVisitor that builds a map from nodes to their
 /// parents as defined by the \c RecursiveASTVisitor.
@@ -261,9 +265,11 @@ private:
 class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
                         public ASTMatchFinder {
 public:
-  MatchASTVisitor(std::vector<std::pair<const internal::DynTypedMatcher*,
-                                        MatchCallback*> > *MatcherCallbackPairs)
-     : MatcherCallbackPairs(MatcherCallbackPairs),
+  MatchASTVisitor(const MatchFinder::MatchersByNodeKind *Matchers,
+                  std::vector<MatcherProfile> *Profiles)
+     : Matchers(Matchers),
+       Profiles(Profiles),
+       CurrentProfile(NULL),
        ActiveASTContext(NULL) {
   }
 
@@ -326,6 +332,12 @@ public:
            "Fix getMemoizationData once more types allow recursive matching.");
     std::pair<MemoizationMap::iterator, bool> InsertResult
       = ResultCache.insert(std::make_pair(input, MemoizedMatchResult()));
+    if (CurrentProfile != NULL) {
+      if (InsertResult.second)
+        ++CurrentProfile->NumMemoizationMisses;
+      else
+        ++CurrentProfile->NumMemoizationHits;
+    }
     if (InsertResult.second) {
       BoundNodesTreeBuilder DescendantBoundNodesBuilder;
       InsertResult.first->second.ResultOfMatch =
@@ -437,26 +449,56 @@ private:
     return false;
   }
 
-  // Matches all registered matchers on the given node and calls the
-  // result callback for every node that matches.
+  // Matches all registered matchers for the kind of the given node and
+  // calls the result callback for every node that matches.
+  void match(const Decl &Node) { matchWithList(Node, Matchers->Decl); }
+  void match(const Stmt &Node) { matchWithList(Node, Matchers->Stmt); }
+  void match(QualType Node) { matchWithList(Node, Matchers->Type); }
+  void match(const NestedNameSpecifier &Node) {
+    matchWithList(Node, Matchers->NestedNameSpecifier);
+  }
+  void match(NestedNameSpecifierLoc Node) {
+    matchWithList(Node, Matchers->NestedNameSpecifierLoc);
+  }
+
   template <typename T>
-  void match(const T &node) {
-    for (std::vector<std::pair<const internal::DynTypedMatcher*,
-                               MatchCallback*> >::const_iterator
-             I = MatcherCallbackPairs->begin(), E = MatcherCallbackPairs->end();
+  void matchWithList(const T &Node, const MatchFinder::MatcherList &List) {
+    for (MatchFinder::MatcherList::const_iterator I = List.begin(),
+                                                  E = List.end();
          I != E; ++I) {
+      CurrentProfile = Profiles ? &(*Profiles)[I->Index] : NULL;
+      if (CurrentProfile)
+        CurrentProfile->MatchTime -= llvm::TimeRecord::getCurrentTime(true);
       BoundNodesTreeBuilder Builder;
-      if (I->first->matches(ast_type_traits::DynTypedNode::create(node),
-                            this, &Builder)) {
-        BoundNodesTree BoundNodes = Builder.build();
-        MatchVisitor Visitor(ActiveASTContext, I->second);
-        BoundNodes.visitMatches(&Visitor);
+      bool Matched =
+        I->Matcher->matches(ast_type_traits::DynTypedNode::create(Node),
+                            this, &Builder);
+      if (CurrentProfile)
+        CurrentProfile->MatchTime += llvm::TimeRecord::getCurrentTime(false);
+      if (!Matched)
+        continue;
+
+      if (CurrentProfile) {
+        ++CurrentProfile->NumMatches;
+        CurrentProfile->CallbackTime -= llvm::TimeRecord::getCurrentTime(true);
       }
+      BoundNodesTree BoundNodes = Builder.build();
+      MatchVisitor Visitor(ActiveASTContext, I->Callback);
+      BoundNodes.visitMatches(&Visitor);
+      if (CurrentProfile)
+        CurrentProfile->CallbackTime += llvm::TimeRecord::getCurrentTime(false);
     }
+    CurrentProfile = NULL;
   }
 
-  std::vector<std::pair<const internal::DynTypedMatcher*,
-                        MatchCallback*> > *const MatcherCallbackPairs;
+  const MatchFinder::MatchersByNodeKind *const Matchers;
+
+  // Per-matcher profiles, or NULL if profiling is disabled.
+  std::vector<MatcherProfile> *const Profiles;
+
+  // The profile of the top-level matcher currently running, if any.
+  MatcherProfile *CurrentProfile;
+
   ASTContext *ActiveASTContext;
 
   // Maps a canonical type to its TypedefDecls.
@@ -576,11 +618,10 @@ bool MatchASTVisitor::TraverseNestedNameSpecifierLoc(
 
 class MatchASTConsumer : public ASTConsumer {
 public:
-  MatchASTConsumer(
-    std::vector<std::pair<const internal::DynTypedMatcher*,
-                          MatchCallback*> > *MatcherCallbackPairs,
-    MatchFinder::ParsingDoneTestCallback *ParsingDone)
-    : Visitor(MatcherCallbackPairs),
+  MatchASTConsumer(const MatchFinder::MatchersByNodeKind *Matchers,
+                   std::vector<MatcherProfile> *Profiles,
+                   MatchFinder::ParsingDoneTestCallback *ParsingDone)
+    : Visitor(Matchers, Profiles),
       ParsingDone(ParsingDone) {}
 
 private:
@@ -608,49 +649,108 @@ MatchFinder::MatchResult::MatchResult(const BoundNodes &Nodes,
 MatchFinder::MatchCallback::~MatchCallback() {}
 MatchFinder::ParsingDoneTestCallback::~ParsingDoneTestCallback() {}
 
-MatchFinder::MatchFinder() : ParsingDone(NULL) {}
+MatchFinder::MatchFinder() : ProfilingEnabled(false), ParsingDone(NULL) {}
 
-MatchFinder::~MatchFinder() {
-  for (std::vector<std::pair<const internal::DynTypedMatcher*,
-                             MatchCallback*> >::const_iterator
-           It = MatcherCallbackPairs.begin(), End = MatcherCallbackPairs.end();
+static void deleteMatchers(const MatchFinder::MatcherList &List) {
+  for (MatchFinder::MatcherList::const_iterator It = List.begin(),
+                                                End = List.end();
        It != End; ++It) {
-    delete It->first;
+    delete It->Matcher;
   }
 }
 
+MatchFinder::~MatchFinder() {
+  deleteMatchers(Matchers.Decl);
+  deleteMatchers(Matchers.Type);
+  deleteMatchers(Matchers.Stmt);
+  deleteMatchers(Matchers.NestedNameSpecifier);
+  deleteMatchers(Matchers.NestedNameSpecifierLoc);
+}
+
+void MatchFinder::addMatcherEntry(MatcherList &List,
+                                  const internal::DynTypedMatcher *Matcher,
+                                  MatchCallback *Action) {
+  MatcherEntry Entry = { Matcher, Action, unsigned(Profiles.size()) };
+  List.push_back(Entry);
+  Profiles.push_back(MatcherProfile());
+}
+
 void MatchFinder::addMatcher(const DeclarationMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<Decl>(NodeMatch), Action));
+  addMatcherEntry(Matchers.Decl,
+                  new internal::Matcher<Decl>(NodeMatch), Action);
 }
 
 void MatchFinder::addMatcher(const TypeMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<QualType>(NodeMatch), Action));
+  addMatcherEntry(Matchers.Type,
+                  new internal::Matcher<QualType>(NodeMatch), Action);
 }
 
 void MatchFinder::addMatcher(const StatementMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new internal::Matcher<Stmt>(NodeMatch), Action));
+  addMatcherEntry(Matchers.Stmt,
+                  new internal::Matcher<Stmt>(NodeMatch), Action);
 }
 
 void MatchFinder::addMatcher(const NestedNameSpecifierMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new NestedNameSpecifierMatcher(NodeMatch), Action));
+  addMatcherEntry(Matchers.NestedNameSpecifier,
+                  new NestedNameSpecifierMatcher(NodeMatch), Action);
 }
 
 void MatchFinder::addMatcher(const NestedNameSpecifierLocMatcher &NodeMatch,
                              MatchCallback *Action) {
-  MatcherCallbackPairs.push_back(std::make_pair(
-    new NestedNameSpecifierLocMatcher(NodeMatch), Action));
+  addMatcherEntry(Matchers.NestedNameSpecifierLoc,
+                  new NestedNameSpecifierLocMatcher(NodeMatch), Action);
 }
 
 ASTConsumer *MatchFinder::newASTConsumer() {
-  return new internal::MatchASTConsumer(&MatcherCallbackPairs, ParsingDone);
+  return new internal::MatchASTConsumer(&Matchers,
+                                        ProfilingEnabled ? &Profiles : NULL,
+                                        ParsingDone);
+}
+
+namespace {
+/// \brief Orders matcher indices by the total wall time of their profiles,
+/// most expensive first.
+struct ProfileCostGreater {
+  const std::vector<MatchFinder::MatcherProfile> &Profiles;
+
+  explicit ProfileCostGreater(
+      const std::vector<MatchFinder::MatcherProfile> &Profiles)
+    : Profiles(Profiles) {}
+
+  double cost(unsigned Index) const {
+    return Profiles[Index].MatchTime.getWallTime() +
+           Profiles[Index].CallbackTime.getWallTime();
+  }
+
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    return cost(LHS) > cost(RHS);
+  }
+};
+} // end anonymous namespace
+
+void MatchFinder::printProfile(raw_ostream &OS) const {
+  std::vector<unsigned> Order;
+  for (unsigned I = 0, N = Profiles.size(); I != N; ++I)
+    Order.push_back(I);
+  std::stable_sort(Order.begin(), Order.end(), ProfileCostGreater(Profiles));
+
+  OS << "*** AST Matcher Profile:\n";
+  for (unsigned I = 0, N = Order.size(); I != N; ++I) {
+    const MatcherProfile &Profile = Profiles[Order[I]];
+    unsigned NumMemoized =
+      Profile.NumMemoizationHits + Profile.NumMemoizationMisses;
+    OS << "  matcher #" << Order[I] << ": "
+       << llvm::format("%.4f", Profile.MatchTime.getWallTime())
+       << "s matching, "
+       << llvm::format("%.4f", Profile.CallbackTime.getWallTime())
+       << "s in callbacks, " << Profile.NumMatches << " matches, "
+       << Profile.NumMemoizationHits << "/" << NumMemoized
+       << " memoized recursive matches\n";
+  }
 }
 
 void MatchFinder::registerTestCallbackAfterParsing(
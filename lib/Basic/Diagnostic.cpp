@@ -14,6 +14,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/PartialDiagnostic.h"
+#include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/CrashRecoveryContext.h"
@@ -57,6 +58,7 @@ DiagnosticsEngine::DiagnosticsEngine(
 
   ErrorLimit = 0;
   TemplateBacktraceLimit = 0;
+  FoldTemplateBacktrace = false;
   ConstexprBacktraceLimit = 0;
 
   Reset();
@@ -115,6 +117,11 @@ void DiagnosticsEngine::Reset() {
   DiagStates.clear();
   DiagStatePoints.clear();
   DiagStateOnPushStack.clear();
+  DiagStateRangeCache.clear();
+  LocationDependentDiags.clear();
+  NumLevelQueries = 0;
+  NumStatePointLookups = 0;
+  NumStateRangeCacheHits = 0;
 
   // Create a DiagState and DiagStatePoint representing diagnostic changes
   // through command-line.
@@ -122,6 +129,17 @@ void DiagnosticsEngine::Reset() {
   DiagStatePoints.push_back(DiagStatePoint(&DiagStates.back(), FullSourceLoc()));
 }
 
+void DiagnosticsEngine::PrintStats() const {
+  llvm::errs() << "\n*** Diagnostic Stats:\n";
+  llvm::errs() << "  " << DiagStatePoints.size() << " diagnostic state points, "
+               << DiagStates.size() << " diagnostic states.\n";
+  llvm::errs() << "  " << LocationDependentDiags.count()
+               << " diagnostics with location-dependent mappings.\n";
+  llvm::errs() << "  " << NumLevelQueries << " diagnostic level queries, "
+               << NumStatePointLookups << " state point lookups, "
+               << NumStateRangeCacheHits << " state range cache hits.\n";
+}
+
 void DiagnosticsEngine::SetDelayedDiagnostic(unsigned DiagID, StringRef Arg1,
                                              StringRef Arg2) {
   if (DelayedDiagID)
@@ -152,6 +170,25 @@ DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
   if (Loc.isInvalid())
     return DiagStatePoints.end() - 1;
 
+  // Files with many diagnostic pragmas are queried over and over; try the
+  // range of the file we resolved last time before searching all the points.
+  FileID FID;
+  if (L.isFileID()) {
+    std::pair<FileID, unsigned> Decomposed = SourceMgr->getDecomposedLoc(L);
+    llvm::DenseMap<FileID, DiagStateRange>::const_iterator
+      Cached = DiagStateRangeCache.find(Decomposed.first);
+    if (Cached != DiagStateRangeCache.end()) {
+      const DiagStateRange &Range = Cached->second;
+      if (Range.Begin <= Decomposed.second && Decomposed.second < Range.End &&
+          (!Range.OpenEnded || Range.Point + 1 == DiagStatePoints.size())) {
+        ++NumStateRangeCacheHits;
+        return DiagStatePoints.begin() + Range.Point;
+      }
+    }
+    FID = Decomposed.first;
+  }
+
+  ++NumStatePointLookups;
   DiagStatePointsTy::iterator Pos = DiagStatePoints.end();
   FullSourceLoc LastStateChangePos = DiagStatePoints.back().Loc;
   if (LastStateChangePos.isValid() &&
@@ -159,9 +196,77 @@ DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
     Pos = std::upper_bound(DiagStatePoints.begin(), DiagStatePoints.end(),
                            DiagStatePoint(0, Loc));
   --Pos;
+
+  if (FID.isValid())
+    cacheDiagStateRange(FID, Pos - DiagStatePoints.begin());
   return Pos;
 }
 
+namespace {
+/// \brief Where a DiagStatePoint lies relative to a given file.
+enum PointPlacement {
+  PP_Unknown,   ///< Couldn't tell cheaply, e.g. the point is in a macro.
+  PP_Outside,   ///< Neither in the file nor in anything it includes.
+  PP_Direct,    ///< In the file itself, at the returned offset.
+  PP_Included   ///< In a file included at the returned offset.
+};
+}
+
+static PointPlacement getPointPlacement(const SourceManager &SM,
+                                        SourceLocation Loc, FileID FID,
+                                        unsigned &Offset) {
+  if (Loc.isInvalid())
+    return PP_Outside;
+
+  bool Direct = true;
+  while (Loc.isFileID()) {
+    std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(Loc);
+    if (Decomposed.first == FID) {
+      Offset = Decomposed.second;
+      return Direct ? PP_Direct : PP_Included;
+    }
+    Loc = SM.getIncludeLoc(Decomposed.first);
+    if (Loc.isInvalid())
+      return PP_Outside;
+    Direct = false;
+  }
+  return PP_Unknown;
+}
+
+void DiagnosticsEngine::cacheDiagStateRange(FileID FID, unsigned Point) const {
+  DiagStateRange Range;
+  Range.Point = Point;
+  Range.OpenEnded = Point + 1 == DiagStatePoints.size();
+
+  // The point is at or before the queried location, so the range starts at
+  // the point if it is in this file, right after the #include that contains
+  // it if it is in a file included from this one, or at the start of the
+  // file otherwise.
+  unsigned Offset;
+  switch (getPointPlacement(*SourceMgr, DiagStatePoints[Point].Loc, FID,
+                            Offset)) {
+  case PP_Unknown:  return;
+  case PP_Outside:  Range.Begin = 0; break;
+  case PP_Direct:   Range.Begin = Offset; break;
+  case PP_Included: Range.Begin = Offset + 1; break;
+  }
+
+  // Likewise, the range ends at the next point, or at the #include that
+  // leads to it.
+  Range.End = ~0U;
+  if (!Range.OpenEnded) {
+    switch (getPointPlacement(*SourceMgr, DiagStatePoints[Point + 1].Loc, FID,
+                              Offset)) {
+    case PP_Unknown:  return;
+    case PP_Outside:  break;
+    case PP_Direct:
+    case PP_Included: Range.End = Offset; break;
+    }
+  }
+
+  DiagStateRangeCache[FID] = Range;
+}
+
 void DiagnosticsEngine::setDiagnosticMapping(diag::kind Diag, diag::Mapping Map,
                                              SourceLocation L) {
   assert(Diag < diag::DIAG_UPPER_LIMIT &&
@@ -172,6 +277,10 @@ void DiagnosticsEngine::setDiagnosticMapping(diag::kind Diag, diag::Mapping Map,
   assert(!DiagStatePoints.empty());
   assert((L.isInvalid() || SourceMgr) && "No SourceMgr for valid location");
 
+  // Once pragmas are involved the DiagStates may disagree about this one.
+  if (L.isValid() || DiagStatePoints.size() > 1)
+    markLocationDependent(Diag);
+
   FullSourceLoc Loc = SourceMgr? FullSourceLoc(L, *SourceMgr) : FullSourceLoc();
   FullSourceLoc LastStateChangePos = DiagStatePoints.back().Loc;
   // Don't allow a mapping to a warning override an error/fatal mapping.
@@ -228,6 +337,8 @@ void DiagnosticsEngine::setDiagnosticMapping(diag::kind Diag, diag::Mapping Map,
   GetCurDiagState()->setMappingInfo(Diag, MappingInfo);
   DiagStatePoints.insert(Pos+1, DiagStatePoint(NewState,
                                                FullSourceLoc(Loc, *SourceMgr)));
+  // The indices of the following points changed.
+  DiagStateRangeCache.clear();
 }
 
 bool DiagnosticsEngine::setDiagnosticGroupMapping(
@@ -254,6 +365,8 @@ void DiagnosticsEngine::setDiagnosticWarningAsError(diag::kind Diag,
 
   // Otherwise, we want to set the diagnostic mapping's "no Werror" bit, and
   // potentially downgrade anything already mapped to be a warning.
+  if (DiagStatePoints.size() > 1)
+    markLocationDependent(Diag);
   DiagnosticMappingInfo &Info = GetCurDiagState()->getOrAddMappingInfo(Diag);
 
   if (Info.getMapping() == diag::MAP_ERROR ||
@@ -280,6 +393,8 @@ bool DiagnosticsEngine::setDiagnosticGroupWarningAsError(StringRef Group,
 
   // Perform the mapping change.
   for (unsigned i = 0, e = GroupDiags.size(); i != e; ++i) {
+    if (DiagStatePoints.size() > 1)
+      markLocationDependent(GroupDiags[i]);
     DiagnosticMappingInfo &Info = GetCurDiagState()->getOrAddMappingInfo(
       GroupDiags[i]);
 
@@ -302,6 +417,8 @@ void DiagnosticsEngine::setDiagnosticErrorAsFatal(diag::kind Diag,
   
   // Otherwise, we want to set the diagnostic mapping's "no Werror" bit, and
   // potentially downgrade anything already mapped to be a warning.
+  if (DiagStatePoints.size() > 1)
+    markLocationDependent(Diag);
   DiagnosticMappingInfo &Info = GetCurDiagState()->getOrAddMappingInfo(Diag);
   
   if (Info.getMapping() == diag::MAP_FATAL)
@@ -327,6 +444,8 @@ bool DiagnosticsEngine::setDiagnosticGroupErrorAsFatal(StringRef Group,
 
   // Perform the mapping change.
   for (unsigned i = 0, e = GroupDiags.size(); i != e; ++i) {
+    if (DiagStatePoints.size() > 1)
+      markLocationDependent(GroupDiags[i]);
     DiagnosticMappingInfo &Info = GetCurDiagState()->getOrAddMappingInfo(
       GroupDiags[i]);
 
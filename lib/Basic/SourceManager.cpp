@@ -23,6 +23,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Capacity.h"
+#include "llvm/Support/Mutex.h"
 #include <algorithm>
 #include <string>
 #include <cstring>
@@ -32,6 +33,24 @@ using namespace clang;
 using namespace SrcMgr;
 using llvm::MemoryBuffer;
 
+namespace {
+  /// \brief Holds the SourceManager's cache mutex, if it has one, for the
+  /// duration of a query that updates its caches.
+  class CacheLock {
+    llvm::sys::MutexImpl *Mutex;
+
+  public:
+    explicit CacheLock(llvm::sys::MutexImpl *Mutex) : Mutex(Mutex) {
+      if (Mutex)
+        Mutex->acquire();
+    }
+    ~CacheLock() {
+      if (Mutex)
+        Mutex->release();
+    }
+  };
+}
+
 //===----------------------------------------------------------------------===//
 // SourceManager Helper Classes
 //===----------------------------------------------------------------------===//
@@ -374,9 +393,11 @@ SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
                              bool UserFilesAreVolatile)
   : Diag(Diag), FileMgr(FileMgr), OverridenFilesKeepOriginalName(true),
     UserFilesAreVolatile(UserFilesAreVolatile),
+    LocalSLocSpaceLimit(MaxLoadedOffset),
     ExternalSLocEntries(0), LineTable(0), NumLinearScans(0),
-    NumBinaryProbes(0), FakeBufferForRecovery(0),
-    FakeContentCacheForRecovery(0) {
+    NumBinaryProbes(0), NumSlowFileIDLookups(0), NumRecentFileIDHits(0),
+    FakeBufferForRecovery(0),
+    FakeContentCacheForRecovery(0), CacheMutex(0) {
   clearIDTables();
   Diag.setSourceManager(this);
 }
@@ -408,6 +429,8 @@ SourceManager::~SourceManager() {
          I = MacroArgsCacheMap.begin(),E = MacroArgsCacheMap.end(); I!=E; ++I) {
     delete I->second;
   }
+
+  delete CacheMutex;
 }
 
 void SourceManager::clearIDTables() {
@@ -418,6 +441,9 @@ void SourceManager::clearIDTables() {
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = 0;
   LastFileIDLookup = FileID();
+  for (unsigned I = 0; I != NumRecentFileIDLookups; ++I)
+    RecentFileIDLookups[I] = FileID();
+  NextRecentFileIDLookup = 0;
 
   if (LineTable)
     LineTable->clear();
@@ -506,10 +532,13 @@ std::pair<int, unsigned>
 SourceManager::AllocateLoadedSLocEntries(unsigned NumSLocEntries,
                                          unsigned TotalSize) {
   assert(ExternalSLocEntries && "Don't have an external sloc source");
+  if (TotalSize > CurrentLoadedOffset - NextLocalOffset) {
+    Diag.Report(diag::err_source_locations_exhausted);
+    return std::make_pair(0, 0U);
+  }
   LoadedSLocEntryTable.resize(LoadedSLocEntryTable.size() + NumSLocEntries);
   SLocEntryLoaded.resize(LoadedSLocEntryTable.size());
   CurrentLoadedOffset -= TotalSize;
-  assert(CurrentLoadedOffset >= NextLocalOffset && "Out of source locations");
   int ID = LoadedSLocEntryTable.size();
   return std::make_pair(-ID - 1, CurrentLoadedOffset);
 }
@@ -557,13 +586,17 @@ FileID SourceManager::createFileID(const ContentCache *File,
     SLocEntryLoaded[Index] = true;
     return FileID::get(LoadedID);
   }
+  unsigned FileSize = File->getSize();
+  // Running out is possible with enough input, e.g. heavily macro-generated
+  // code, so check this in release builds too rather than silently wrapping
+  // around into the loaded-entry space. The file then isn't entered.
+  if (!hasLocalSLocSpace(FileSize)) {
+    Diag.Report(IncludePos, diag::err_source_locations_exhausted);
+    return FileID();
+  }
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset,
                                                FileInfo::get(IncludePos, File,
                                                              FileCharacter)));
-  unsigned FileSize = File->getSize();
-  assert(NextLocalOffset + FileSize + 1 > NextLocalOffset &&
-         NextLocalOffset + FileSize + 1 <= CurrentLoadedOffset &&
-         "Ran out of source locations!");
   // We do a +1 here because we want a SourceLocation that means "the end of the
   // file", e.g. for the "no newline at the end of the file" diagnostic.
   NextLocalOffset += FileSize + 1;
@@ -609,10 +642,16 @@ SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
     SLocEntryLoaded[Index] = true;
     return SourceLocation::getMacroLoc(LoadedOffset);
   }
+  // Once the space is exhausted, the tokens keep their spelling location.
+  // Callers offset the result by up to TokLength, which stays within the
+  // spelled tokens, whereas the expansion location may be at the end of a
+  // file. The fatal error stops the compilation anyway.
+  if (!hasLocalSLocSpace(TokLength)) {
+    Diag.Report(Info.getExpansionLocStart(),
+                diag::err_source_locations_exhausted);
+    return Info.getSpellingLoc();
+  }
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset, Info));
-  assert(NextLocalOffset + TokLength + 1 > NextLocalOffset &&
-         NextLocalOffset + TokLength + 1 <= CurrentLoadedOffset &&
-         "Ran out of source locations!");
   // See createFileID for that +1.
   NextLocalOffset += TokLength + 1;
   return SourceLocation::getMacroLoc(NextLocalOffset - (TokLength + 1));
@@ -696,11 +735,65 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
   if (!SLocOffset)
     return FileID::get(0);
 
+  // The caches below are shared by all threads.
+  if (CacheMutex)
+    return getFileIDUncached(SLocOffset);
+
+  ++NumSlowFileIDLookups;
+
+  // Before searching, check the FileIDs we found most recently.
+  for (unsigned I = 0; I != NumRecentFileIDLookups; ++I) {
+    FileID FID = RecentFileIDLookups[I];
+    if (!FID.isInvalid() && isOffsetInFileID(FID, SLocOffset)) {
+      ++NumRecentFileIDHits;
+      return FID;
+    }
+  }
+
   // Now it is time to search for the correct file. See where the SLocOffset
   // sits in the global view and consult local or loaded buffers for it.
-  if (SLocOffset < NextLocalOffset)
-    return getFileIDLocal(SLocOffset);
-  return getFileIDLoaded(SLocOffset);
+  FileID Res = SLocOffset < NextLocalOffset ? getFileIDLocal(SLocOffset)
+                                            : getFileIDLoaded(SLocOffset);
+  RecentFileIDLookups[NextRecentFileIDLookup] = Res;
+  NextRecentFileIDLookup = (NextRecentFileIDLookup + 1) % NumRecentFileIDLookups;
+  return Res;
+}
+
+/// \brief Return the FileID for a SourceLocation by binary search, without
+/// reading or updating any lookup cache.
+///
+/// This is how FileIDs are found while several threads query the source
+/// manager at once; all loaded entries have been loaded by then.
+FileID SourceManager::getFileIDUncached(unsigned SLocOffset) const {
+  if (SLocOffset < NextLocalOffset) {
+    // Find the last local entry that starts at or before the offset.
+    unsigned LessIndex = 0, GreaterIndex = LocalSLocEntryTable.size();
+    while (GreaterIndex - LessIndex > 1) {
+      unsigned MiddleIndex = (GreaterIndex - LessIndex) / 2 + LessIndex;
+      if (LocalSLocEntryTable[MiddleIndex].getOffset() <= SLocOffset)
+        LessIndex = MiddleIndex;
+      else
+        GreaterIndex = MiddleIndex;
+    }
+    return FileID::get(LessIndex);
+  }
+
+  if (SLocOffset < CurrentLoadedOffset)
+    return FileID();
+
+  // The loaded table is sorted by decreasing offset; find the first entry
+  // that starts at or before the offset.
+  unsigned GreaterIndex = 0, LessIndex = LoadedSLocEntryTable.size();
+  while (GreaterIndex != LessIndex) {
+    unsigned MiddleIndex = (LessIndex - GreaterIndex) / 2 + GreaterIndex;
+    if (LoadedSLocEntryTable[MiddleIndex].getOffset() > SLocOffset)
+      GreaterIndex = MiddleIndex + 1;
+    else
+      LessIndex = MiddleIndex;
+  }
+  if (LessIndex == LoadedSLocEntryTable.size())
+    return FileID();
+  return FileID::get(-int(LessIndex) - 2);
 }
 
 /// \brief Return the FileID for a SourceLocation with a low offset.
@@ -1167,6 +1260,8 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos,
     return 1;
   }
 
+  CacheLock Lock(CacheMutex);
+
   ContentCache *Content;
   if (LastLineNoFileIDQuery == FID)
     Content = LastLineNoContentCache;
@@ -1608,6 +1703,7 @@ SourceLocation SourceManager::translateLineCol(FileID FID,
     
   // If this is the first use of line information for this buffer, compute the
   // SourceLineCache for it on demand.
+  CacheLock Lock(CacheMutex);
   if (Content->SourceLineCache == 0) {
     bool MyInvalid = false;
     ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
@@ -1755,6 +1851,7 @@ SourceManager::getMacroArgExpandedLocation(SourceLocation Loc) const {
   if (FID.isInvalid())
     return Loc;
 
+  CacheLock Lock(CacheMutex);
   MacroArgsMap *&MacroArgsCache = MacroArgsCacheMap[FID];
   if (!MacroArgsCache)
     computeMacroArgsCache(MacroArgsCache, FID);
@@ -1810,6 +1907,7 @@ bool SourceManager::isBeforeInTranslationUnit(SourceLocation LHS,
 
   // If we are comparing a source location with multiple locations in the same
   // file, we get a big win by caching the result.
+  CacheLock Lock(CacheMutex);
   if (IsBeforeInTUCache.isCacheValid(LOffs.first, ROffs.first))
     return IsBeforeInTUCache.getCachedResult(LOffs.second, ROffs.second);
 
@@ -1862,6 +1960,29 @@ bool SourceManager::isBeforeInTranslationUnit(SourceLocation LHS,
   return LOffs.first < ROffs.first;
 }
 
+/// \brief Read the contents of the file described by \p Entry, if any.
+static void loadFileBuffer(const SLocEntry &Entry, DiagnosticsEngine &Diag,
+                           const SourceManager &SM) {
+  if (!Entry.isFile())
+    return;
+  if (const ContentCache *Content = Entry.getFile().getContentCache())
+    Content->getBuffer(Diag, SM);
+}
+
+void SourceManager::enableConcurrentQueries() {
+  // Entries from an external source and the contents of files are loaded
+  // on first use; do that now, while no other thread can get there first.
+  for (unsigned I = 0, N = LoadedSLocEntryTable.size(); I != N; ++I)
+    loadFileBuffer(getLoadedSLocEntry(I), Diag, *this);
+  for (unsigned I = 0, N = LocalSLocEntryTable.size(); I != N; ++I)
+    loadFileBuffer(LocalSLocEntryTable[I], Diag, *this);
+
+  // Lookups nest (getLineNumber() calls getFileID(), for example), so the
+  // mutex has to be recursive.
+  if (!CacheMutex)
+    CacheMutex = new llvm::sys::MutexImpl(/*recursive=*/true);
+}
+
 void SourceManager::PrintStats() const {
   llvm::errs() << "\n*** Source Manager Stats:\n";
   llvm::errs() << FileInfos.size() << " files mapped, " << MemBufferInfos.size()
@@ -1870,6 +1991,29 @@ void SourceManager::PrintStats() const {
                << llvm::capacity_in_bytes(LocalSLocEntryTable)
                << " bytes of capacity), "
                << NextLocalOffset << "B of Sloc address space used.\n";
+
+  // Break down the local address space used by macro expansions, which is
+  // what runs out first in heavily macro-generated code.
+  unsigned NumExpansions = 0, NumMacroArgExpansions = 0;
+  uint64_t ExpansionSpace = 0, MacroArgExpansionSpace = 0;
+  for (unsigned I = 0, N = LocalSLocEntryTable.size(); I != N; ++I) {
+    const SrcMgr::SLocEntry &Entry = LocalSLocEntryTable[I];
+    if (!Entry.isExpansion())
+      continue;
+    unsigned End = I + 1 == N ? NextLocalOffset
+                              : LocalSLocEntryTable[I + 1].getOffset();
+    if (Entry.getExpansion().isMacroArgExpansion()) {
+      ++NumMacroArgExpansions;
+      MacroArgExpansionSpace += End - Entry.getOffset();
+    } else {
+      ++NumExpansions;
+      ExpansionSpace += End - Entry.getOffset();
+    }
+  }
+  llvm::errs() << NumExpansions << " macro expansion SLocEntry's ("
+               << ExpansionSpace << "B of Sloc address space), "
+               << NumMacroArgExpansions << " macro argument SLocEntry's ("
+               << MacroArgExpansionSpace << "B of Sloc address space).\n";
   llvm::errs() << LoadedSLocEntryTable.size()
                << " loaded SLocEntries allocated, "
                << MaxLoadedOffset - CurrentLoadedOffset
@@ -1888,6 +2032,9 @@ void SourceManager::PrintStats() const {
                << NumMacroArgsComputed << " files with macro args computed.\n";
   llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
                << NumBinaryProbes << " binary.\n";
+  llvm::errs() << NumSlowFileIDLookups << " FileID lookups missed the "
+               << "last-lookup cache, " << NumRecentFileIDHits
+               << " of them hit the recent-lookup cache.\n";
 }
 
 ExternalSLocEntrySource::~ExternalSLocEntrySource() { }
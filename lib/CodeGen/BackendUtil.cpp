@@ -13,8 +13,16 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "llvm/Constants.h"
+#include "llvm/InlineAsm.h"
+#include "llvm/LLVMContext.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Bitcode/ReaderWriter.h"
@@ -23,7 +31,9 @@
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -35,11 +45,15 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
 using namespace clang;
 using namespace llvm;
 
 namespace {
 
+struct PartitionJob;
+
 class EmitAssemblyHelper {
   DiagnosticsEngine &Diags;
   const CodeGenOptions &CodeGenOpts;
@@ -49,6 +63,12 @@ class EmitAssemblyHelper {
 
   Timer CodeGenerationTime;
 
+  /// Per-phase breakdown of CodeGenerationTime, reported by -ftime-report.
+  TimerGroup PhaseTimers;
+  Timer PerFunctionTime;
+  Timer PerModuleTime;
+  Timer MachineCodeTime;
+
   mutable PassManager *CodeGenPasses;
   mutable PassManager *PerModulePasses;
   mutable FunctionPassManager *PerFunctionPasses;
@@ -80,10 +100,49 @@ private:
 
   void CreatePasses();
 
+  /// SetUpBackend - Look up the target for the module and apply the backend
+  /// options that are global to the process.
+  ///
+  /// \return The target, or null on failure.
+  const llvm::Target *SetUpBackend();
+
+  /// CreateTargetMachine - Create a TargetMachine for the module's target,
+  /// configured from the code generation options.
+  TargetMachine *CreateTargetMachine(const llvm::Target *TheTarget);
+
   /// AddEmitPasses - Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
-  bool AddEmitPasses(BackendAction Action, formatted_raw_ostream &OS);
+  bool AddEmitPasses(const llvm::Target *TheTarget, BackendAction Action,
+                     formatted_raw_ostream &OS);
+
+  /// InitPartitionJob - Prepare \p Job to generate code for \p Part.
+  void InitPartitionJob(PartitionJob &Job, Module *Part,
+                        const llvm::Target *TheTarget);
+
+  /// RunPartitionJobs - Generate code for \p Jobs and report their
+  /// diagnostics.
+  ///
+  /// \return True if every job succeeded.
+  bool RunPartitionJobs(std::vector<PartitionJob> &Jobs);
+
+  /// WritePartitionObjects - Write the object files of \p Jobs, starting at
+  /// \p First, to CodeGenOpts.ParallelCodeGenOutputs.
+  void WritePartitionObjects(const std::vector<PartitionJob> &Jobs,
+                             unsigned First);
+
+  /// EmitEmptyPartitions - Write an empty object file to each of
+  /// CodeGenOpts.ParallelCodeGenOutputs, for a module generated serially.
+  void EmitEmptyPartitions(const llvm::Target *TheTarget);
+
+  /// EmitPartitioned - Split the module into CodeGenOpts.ParallelCodeGen
+  /// partitions and generate an object file for each of them in a context of
+  /// its own. The first goes to \p OS and the others to
+  /// CodeGenOpts.ParallelCodeGenOutputs.
+  ///
+  /// \return False if the module cannot be split, in which case nothing has
+  /// been written and code should be generated serially.
+  bool EmitPartitioned(const llvm::Target *TheTarget, raw_ostream &OS);
 
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags,
@@ -93,6 +152,10 @@ public:
                      Module *M)
     : Diags(_Diags), CodeGenOpts(CGOpts), TargetOpts(TOpts), LangOpts(LOpts),
       TheModule(M), CodeGenerationTime("Code Generation Time"),
+      PhaseTimers("Clang backend phases"),
+      PerFunctionTime("Per-function optimization", PhaseTimers),
+      PerModuleTime("Per-module optimization", PhaseTimers),
+      MachineCodeTime("Machine code generation", PhaseTimers),
       CodeGenPasses(0), PerModulePasses(0), PerFunctionPasses(0) {}
 
   ~EmitAssemblyHelper() {
@@ -241,15 +304,13 @@ void EmitAssemblyHelper::CreatePasses() {
   PMBuilder.populateModulePassManager(*MPM);
 }
 
-bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
-                                       formatted_raw_ostream &OS) {
-  // Create the TargetMachine for generating code.
+const llvm::Target *EmitAssemblyHelper::SetUpBackend() {
   std::string Error;
   std::string Triple = TheModule->getTargetTriple();
   const llvm::Target *TheTarget = TargetRegistry::lookupTarget(Triple, Error);
   if (!TheTarget) {
     Diags.Report(diag::err_fe_unable_to_create_target) << Error;
-    return false;
+    return 0;
   }
 
   // FIXME: Expose these capabilities via actual APIs!!!! Aside from just
@@ -261,21 +322,6 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   TargetMachine::setFunctionSections(CodeGenOpts.FunctionSections);
   TargetMachine::setDataSections    (CodeGenOpts.DataSections);
 
-  // FIXME: Parse this earlier.
-  llvm::CodeModel::Model CM;
-  if (CodeGenOpts.CodeModel == "small") {
-    CM = llvm::CodeModel::Small;
-  } else if (CodeGenOpts.CodeModel == "kernel") {
-    CM = llvm::CodeModel::Kernel;
-  } else if (CodeGenOpts.CodeModel == "medium") {
-    CM = llvm::CodeModel::Medium;
-  } else if (CodeGenOpts.CodeModel == "large") {
-    CM = llvm::CodeModel::Large;
-  } else {
-    assert(CodeGenOpts.CodeModel.empty() && "Invalid code model!");
-    CM = llvm::CodeModel::Default;
-  }
-
   SmallVector<const char *, 16> BackendArgs;
   BackendArgs.push_back("clang"); // Fake program name.
   if (!CodeGenOpts.DebugPass.empty()) {
@@ -296,6 +342,26 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   llvm::cl::ParseCommandLineOptions(BackendArgs.size() - 1,
                                     BackendArgs.data());
 
+  return TheTarget;
+}
+
+TargetMachine *
+EmitAssemblyHelper::CreateTargetMachine(const llvm::Target *TheTarget) {
+  // FIXME: Parse this earlier.
+  llvm::CodeModel::Model CM;
+  if (CodeGenOpts.CodeModel == "small") {
+    CM = llvm::CodeModel::Small;
+  } else if (CodeGenOpts.CodeModel == "kernel") {
+    CM = llvm::CodeModel::Kernel;
+  } else if (CodeGenOpts.CodeModel == "medium") {
+    CM = llvm::CodeModel::Medium;
+  } else if (CodeGenOpts.CodeModel == "large") {
+    CM = llvm::CodeModel::Large;
+  } else {
+    assert(CodeGenOpts.CodeModel.empty() && "Invalid code model!");
+    CM = llvm::CodeModel::Default;
+  }
+
   std::string FeaturesStr;
   if (TargetOpts.Features.size()) {
     SubtargetFeatures Features;
@@ -377,9 +443,10 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   Options.PositionIndependentExecutable = LangOpts.PIELevel != 0;
   Options.SSPBufferSize = CodeGenOpts.SSPBufferSize;
 
-  TargetMachine *TM = TheTarget->createTargetMachine(Triple, TargetOpts.CPU,
-                                                     FeaturesStr, Options,
-                                                     RM, CM, OptLevel);
+  TargetMachine *TM =
+    TheTarget->createTargetMachine(TheModule->getTargetTriple(),
+                                   TargetOpts.CPU, FeaturesStr, Options,
+                                   RM, CM, OptLevel);
 
   if (CodeGenOpts.RelaxAll)
     TM->setMCRelaxAll(true);
@@ -392,6 +459,15 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   if (CodeGenOpts.NoExecStack)
     TM->setMCNoExecStack(true);
 
+  return TM;
+}
+
+bool EmitAssemblyHelper::AddEmitPasses(const llvm::Target *TheTarget,
+                                       BackendAction Action,
+                                       formatted_raw_ostream &OS) {
+  // Create the TargetMachine for generating code.
+  TargetMachine *TM = CreateTargetMachine(TheTarget);
+
   // Create the code generator passes.
   PassManager *PM = getCodeGenPasses();
 
@@ -427,10 +503,460 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   return true;
 }
 
+namespace {
+
+/// ModulePartitioner - Groups the definitions of a module that have to be
+/// generated together and spreads the groups over a number of partitions.
+///
+/// A definition stays with the local symbols it refers to, since those can't
+/// be declared in another module. Likewise aliases stay with their aliasee,
+/// block addresses with their function and all appending globals with each
+/// other.
+class ModulePartitioner {
+  Module &TheModule;
+  EquivalenceClasses<const GlobalValue*> Classes;
+  SmallPtrSet<const Constant*, 16> Visited;
+
+  /// The definitions of the module, in module order.
+  std::vector<GlobalValue*> Definitions;
+
+  bool AddUses(const GlobalValue *Def, const Value *V);
+
+public:
+  explicit ModulePartitioner(Module &M) : TheModule(M) {}
+
+  const std::vector<GlobalValue*> &getDefinitions() const {
+    return Definitions;
+  }
+
+  /// Partition - Assign every definition to one of at most \p N partitions.
+  /// The assignment only depends on the module and \p N.
+  ///
+  /// \return The number of partitions used, or 0 if the module can't be
+  /// split.
+  unsigned Partition(unsigned N,
+                     DenseMap<const GlobalValue*, unsigned> &PartitionOf);
+};
+
+/// HeavierGroup - Orders groups of definitions by decreasing weight.
+struct HeavierGroup {
+  const std::vector<unsigned> &Weights;
+
+  explicit HeavierGroup(const std::vector<unsigned> &W) : Weights(W) {}
+
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    return Weights[LHS] > Weights[RHS];
+  }
+};
+
+/// PartitionDiag - A diagnostic the code generator issued for a partition,
+/// kept until it can be reported through the module's own context.
+struct PartitionDiag {
+  std::string Message;
+  SourceMgr::DiagKind Kind;
+  unsigned LocCookie;
+};
+
+/// PartitionJob - The input and output of code generation for one partition.
+struct PartitionJob {
+  std::string Bitcode;
+  TargetMachine *TM;
+  bool SimplifyLibCalls;
+  bool ObjCARCContract;
+  bool DisableVerify;
+
+  std::string Output;
+  std::string Error;
+  bool InterfaceFailed;
+  std::vector<PartitionDiag> Diagnostics;
+
+  PartitionJob()
+    : TM(0), SimplifyLibCalls(true), ObjCARCContract(false), DisableVerify(false),
+      InterfaceFailed(false) {}
+};
+
+}
+
+/// AddUses - Record the symbols \p V refers to that have to be generated in
+/// the same partition as \p Def.
+///
+/// \return False if \p V may refer to any symbol.
+bool ModulePartitioner::AddUses(const GlobalValue *Def, const Value *V) {
+  if (isa<InlineAsm>(V))
+    return false;
+
+  if (const GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
+    if (GV->hasLocalLinkage())
+      Classes.unionSets(Def, GV);
+    return true;
+  }
+
+  if (const BlockAddress *BA = dyn_cast<BlockAddress>(V)) {
+    Classes.unionSets(Def, BA->getFunction());
+    return true;
+  }
+
+  const Constant *C = dyn_cast<Constant>(V);
+  if (!C || !Visited.insert(C))
+    return true;
+  for (User::const_op_iterator I = C->op_begin(), E = C->op_end(); I != E; ++I)
+    if (!AddUses(Def, *I))
+      return false;
+  return true;
+}
+
+unsigned ModulePartitioner::Partition(
+    unsigned N, DenseMap<const GlobalValue*, unsigned> &PartitionOf) {
+  // Module-level inline assembly may define or refer to any symbol.
+  if (!TheModule.getModuleInlineAsm().empty())
+    return 0;
+
+  for (Module::iterator I = TheModule.begin(), E = TheModule.end(); I != E; ++I)
+    if (!I->isDeclaration())
+      Definitions.push_back(I);
+  for (Module::global_iterator I = TheModule.global_begin(),
+         E = TheModule.global_end(); I != E; ++I)
+    if (!I->isDeclaration())
+      Definitions.push_back(I);
+  for (Module::alias_iterator I = TheModule.alias_begin(),
+         E = TheModule.alias_end(); I != E; ++I)
+    Definitions.push_back(I);
+
+  const GlobalValue *Appending = 0;
+  for (unsigned i = 0, e = Definitions.size(); i != e; ++i) {
+    GlobalValue *GV = Definitions[i];
+    Classes.insert(GV);
+    if (GV->hasAppendingLinkage()) {
+      if (Appending)
+        Classes.unionSets(Appending, GV);
+      else
+        Appending = GV;
+    }
+  }
+
+  for (unsigned i = 0, e = Definitions.size(); i != e; ++i) {
+    const GlobalValue *GV = Definitions[i];
+
+    Visited.clear();
+    if (const Function *F = dyn_cast<Function>(GV)) {
+      for (Function::const_iterator BB = F->begin(), BBE = F->end();
+           BB != BBE; ++BB) {
+        for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+             I != IE; ++I) {
+          for (User::const_op_iterator OI = I->op_begin(), OE = I->op_end();
+               OI != OE; ++OI)
+            if (!AddUses(F, *OI))
+              return 0;
+        }
+      }
+    } else if (const GlobalVariable *Var = dyn_cast<GlobalVariable>(GV)) {
+      if (!AddUses(Var, Var->getInitializer()))
+        return 0;
+    } else {
+      const GlobalAlias *GA = cast<GlobalAlias>(GV);
+      if (const GlobalValue *Aliasee = GA->getAliasedGlobal())
+        Classes.unionSets(GA, Aliasee);
+      if (!AddUses(GA, GA->getAliasee()))
+        return 0;
+    }
+  }
+
+  // Number the groups in module order and weigh them by size.
+  DenseMap<const GlobalValue*, unsigned> GroupOfLeader;
+  std::vector<unsigned> Weights;
+  std::vector<unsigned> GroupOf(Definitions.size());
+  for (unsigned i = 0, e = Definitions.size(); i != e; ++i) {
+    const GlobalValue *Leader = Classes.getLeaderValue(Definitions[i]);
+    std::pair<DenseMap<const GlobalValue*, unsigned>::iterator, bool> Entry =
+      GroupOfLeader.insert(std::make_pair(Leader, unsigned(Weights.size())));
+    if (Entry.second)
+      Weights.push_back(0);
+    GroupOf[i] = Entry.first->second;
+
+    if (const Function *F = dyn_cast<Function>(Definitions[i])) {
+      for (Function::const_iterator BB = F->begin(), BBE = F->end();
+           BB != BBE; ++BB)
+        Weights[GroupOf[i]] += BB->size();
+    } else {
+      Weights[GroupOf[i]] += 1;
+    }
+  }
+
+  if (Weights.size() < 2)
+    return 0;
+
+  // Hand out the heaviest groups first, each to the partition with the least
+  // work so far. Ties go to the earlier group and the lower partition.
+  std::vector<unsigned> Order(Weights.size());
+  for (unsigned i = 0, e = Order.size(); i != e; ++i)
+    Order[i] = i;
+  std::stable_sort(Order.begin(), Order.end(), HeavierGroup(Weights));
+
+  unsigned NumPartitions = std::min<unsigned>(N, Weights.size());
+  std::vector<unsigned> Load(NumPartitions);
+  std::vector<unsigned> PartitionOfGroup(Weights.size());
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    unsigned P = std::min_element(Load.begin(), Load.end()) - Load.begin();
+    PartitionOfGroup[Order[i]] = P;
+    Load[P] += Weights[Order[i]];
+  }
+
+  for (unsigned i = 0, e = Definitions.size(); i != e; ++i)
+    PartitionOf[Definitions[i]] = PartitionOfGroup[GroupOf[i]];
+  return NumPartitions;
+}
+
+/// getUnnamedDefinitionName - A name for the unnamed definition at \p Index
+/// in the definitions of \p M that no symbol of \p M uses yet.
+static std::string getUnnamedDefinitionName(const Module &M, unsigned Index) {
+  std::string Name = "__unnamed_" + utostr(Index);
+  for (unsigned Suffix = 1; M.getNamedValue(Name); ++Suffix)
+    Name = "__unnamed_" + utostr(Index) + "." + utostr(Suffix);
+  return Name;
+}
+
+/// ExtractPartition - Clone \p M, keeping the definitions assigned to
+/// partition \p Part and declaring everything else.
+static Module *
+ExtractPartition(const Module &M, const std::vector<GlobalValue*> &Definitions,
+                 const DenseMap<const GlobalValue*, unsigned> &PartitionOf,
+                 unsigned Part) {
+  ValueToValueMapTy VMap;
+  Module *New = CloneModule(&M, VMap);
+
+  std::vector<GlobalValue*> Dead;
+  for (unsigned i = 0, e = Definitions.size(); i != e; ++i) {
+    const GlobalValue *Orig = Definitions[i];
+    GlobalValue *GV = cast<GlobalValue>(VMap[Orig]);
+
+    // The partitions would each number unnamed symbols from zero, so give
+    // them the same name in every partition, one that no symbol of the
+    // module already has.
+    if (!GV->hasName())
+      GV->setName(getUnnamedDefinitionName(M, i));
+
+    if (PartitionOf.lookup(Orig) == Part)
+      continue;
+
+    if (Function *F = dyn_cast<Function>(GV)) {
+      F->deleteBody();
+    } else if (GlobalVariable *Var = dyn_cast<GlobalVariable>(GV)) {
+      Var->setInitializer(0);
+      Var->setLinkage(GlobalValue::ExternalLinkage);
+    } else {
+      // An alias can't refer to a declaration, so declare the alias itself.
+      GlobalAlias *GA = cast<GlobalAlias>(GV);
+      PointerType *Ty = GA->getType();
+      if (FunctionType *FTy = dyn_cast<FunctionType>(Ty->getElementType()))
+        GV = Function::Create(FTy, GlobalValue::ExternalLinkage, "", New);
+      else
+        GV = new GlobalVariable(*New, Ty->getElementType(), false,
+                                GlobalValue::ExternalLinkage, 0, "", 0,
+                                GlobalVariable::NotThreadLocal,
+                                Ty->getAddressSpace());
+      GV->takeName(GA);
+      GV->setVisibility(GA->getVisibility());
+      GA->replaceAllUsesWith(GV);
+      GA->eraseFromParent();
+    }
+
+    // Local symbols and appending globals are only needed by the partition
+    // that defines them.
+    if (Orig->hasLocalLinkage() || Orig->hasAppendingLinkage())
+      Dead.push_back(GV);
+  }
+
+  for (unsigned i = 0, e = Dead.size(); i != e; ++i) {
+    Dead[i]->removeDeadConstantUsers();
+    assert(Dead[i]->use_empty() && "Local symbol used across partitions!");
+    Dead[i]->eraseFromParent();
+  }
+
+  return New;
+}
+
+static void CollectPartitionDiag(const SMDiagnostic &D, void *Context,
+                                 unsigned LocCookie) {
+  PartitionDiag Diag = { D.getMessage().str(), D.getKind(), LocCookie };
+  static_cast<PartitionJob*>(Context)->Diagnostics.push_back(Diag);
+}
+
+/// GeneratePartition - Generate the object file for the partition in \p Job,
+/// in a context of its own. The context's diagnostics are collected
+/// in the job, since without a handler it would print them and exit.
+static void GeneratePartition(PartitionJob &Job) {
+  LLVMContext Context;
+  Context.setInlineAsmDiagnosticHandler(CollectPartitionDiag, &Job);
+  OwningPtr<MemoryBuffer> Buffer(MemoryBuffer::getMemBuffer(Job.Bitcode, "",
+                                                            false));
+  OwningPtr<Module> M(ParseBitcodeFile(Buffer.get(), Context, &Job.Error));
+  if (!M)
+    return;
+
+  raw_string_ostream OS(Job.Output);
+  formatted_raw_ostream FormattedOS(OS);
+
+  PassManager PM;
+  PM.add(new TargetData(M.get()));
+
+  TargetLibraryInfo *TLI = new TargetLibraryInfo();
+  if (!Job.SimplifyLibCalls)
+    TLI->disableAllFunctions();
+  PM.add(TLI);
+
+  if (Job.ObjCARCContract)
+    PM.add(createObjCARCContractPass());
+
+  if (Job.TM->addPassesToEmitFile(PM, FormattedOS,
+                                  TargetMachine::CGFT_ObjectFile,
+                                  Job.DisableVerify)) {
+    Job.InterfaceFailed = true;
+    return;
+  }
+
+  PM.run(*M);
+}
+
+/// CreateEmptyPartition - Create a module without definitions for the target
+/// of \p M, for partitions that got nothing to generate.
+static Module *CreateEmptyPartition(const Module &M) {
+  Module *New = new Module(M.getModuleIdentifier(), M.getContext());
+  New->setTargetTriple(M.getTargetTriple());
+  New->setDataLayout(M.getDataLayout());
+  return New;
+}
+
+void EmitAssemblyHelper::InitPartitionJob(PartitionJob &Job, Module *Part,
+                                          const llvm::Target *TheTarget) {
+  raw_string_ostream BitcodeOS(Job.Bitcode);
+  WriteBitcodeToFile(Part, BitcodeOS);
+  BitcodeOS.flush();
+
+  Job.TM = CreateTargetMachine(TheTarget);
+  Job.SimplifyLibCalls = CodeGenOpts.SimplifyLibCalls;
+  Job.ObjCARCContract = LangOpts.ObjCAutoRefCount &&
+                        CodeGenOpts.OptimizationLevel > 0;
+  Job.DisableVerify = !CodeGenOpts.VerifyModule;
+}
+
+bool EmitAssemblyHelper::RunPartitionJobs(std::vector<PartitionJob> &Jobs) {
+  // Each job only uses its own context and target machine, so the jobs are
+  // independent of each other. LLVM has no portable way to start threads that
+  // run at the same time, though, so they are generated one after another.
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    GeneratePartition(Jobs[i]);
+
+  // Hand the partitions' diagnostics to the module's own context, which
+  // reports them to the frontend.
+  LLVMContext &Ctx = TheModule->getContext();
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+    const std::vector<PartitionDiag> &PartDiags = Jobs[i].Diagnostics;
+    for (unsigned j = 0, je = PartDiags.size(); j != je; ++j) {
+      const PartitionDiag &D = PartDiags[j];
+      if (LLVMContext::InlineAsmDiagHandlerTy Handler =
+            Ctx.getInlineAsmDiagnosticHandler())
+        Handler(SMDiagnostic("", D.Kind, D.Message),
+                Ctx.getInlineAsmDiagnosticContext(), D.LocCookie);
+      else
+        Ctx.emitError(D.LocCookie, D.Message);
+    }
+  }
+
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+    if (!Jobs[i].Error.empty()) {
+      Diags.Report(diag::err_fe_error_backend) << Jobs[i].Error;
+      return false;
+    }
+    if (Jobs[i].InterfaceFailed) {
+      Diags.Report(diag::err_fe_unable_to_interface_with_target);
+      return false;
+    }
+  }
+  return true;
+}
+
+void EmitAssemblyHelper::WritePartitionObjects(
+    const std::vector<PartitionJob> &Jobs, unsigned First) {
+  const std::vector<std::string> &Outputs = CodeGenOpts.ParallelCodeGenOutputs;
+  for (unsigned i = 0, e = Outputs.size(); i != e; ++i) {
+    std::string Error;
+    raw_fd_ostream OS(Outputs[i].c_str(), Error, raw_fd_ostream::F_Binary);
+    if (!Error.empty()) {
+      Diags.Report(diag::err_fe_unable_to_open_output) << Outputs[i] << Error;
+      return;
+    }
+    OS << Jobs[First + i].Output;
+  }
+}
+
+void EmitAssemblyHelper::EmitEmptyPartitions(const llvm::Target *TheTarget) {
+  std::vector<PartitionJob> Jobs(CodeGenOpts.ParallelCodeGenOutputs.size());
+  OwningPtr<Module> Empty(CreateEmptyPartition(*TheModule));
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    InitPartitionJob(Jobs[i], Empty.get(), TheTarget);
+
+  if (RunPartitionJobs(Jobs))
+    WritePartitionObjects(Jobs, 0);
+
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    delete Jobs[i].TM;
+}
+
+bool EmitAssemblyHelper::EmitPartitioned(const llvm::Target *TheTarget,
+                                         raw_ostream &OS) {
+  // Every partition would describe itself as the whole compile unit.
+  if (CodeGenOpts.DebugInfo != CodeGenOptions::NoDebugInfo ||
+      TheModule->getNamedMetadata("llvm.dbg.cu"))
+    return false;
+
+  // Each partition's object file goes to an output of its own, which the
+  // driver combines; there may be no more partitions than outputs. The split
+  // only depends on the requested count, never on the host, so the output is
+  // the same everywhere.
+  unsigned NumOutputs = CodeGenOpts.ParallelCodeGenOutputs.size() + 1;
+  unsigned N = std::min(CodeGenOpts.ParallelCodeGen, NumOutputs);
+  if (N < 2)
+    return false;
+
+  ModulePartitioner Partitioner(*TheModule);
+  DenseMap<const GlobalValue*, unsigned> PartitionOf;
+  unsigned NumPartitions = Partitioner.Partition(N, PartitionOf);
+  if (NumPartitions < 2)
+    return false;
+
+  // Split the module here; each job reads its partition back into a context
+  // of its own, so that it shares nothing with the others.
+  std::vector<PartitionJob> Jobs(NumOutputs);
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+    OwningPtr<Module> Part(i < NumPartitions ?
+                           ExtractPartition(*TheModule,
+                                            Partitioner.getDefinitions(),
+                                            PartitionOf, i) :
+                           CreateEmptyPartition(*TheModule));
+    InitPartitionJob(Jobs[i], Part.get(), TheTarget);
+  }
+
+  if (RunPartitionJobs(Jobs)) {
+    OS << Jobs[0].Output;
+    WritePartitionObjects(Jobs, 1);
+  }
+
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    delete Jobs[i].TM;
+  return true;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : 0);
   llvm::formatted_raw_ostream FormattedOS;
 
+  const llvm::Target *TheTarget = 0;
+  // Only object files are split, and only if there are outputs for the
+  // partitions, which then have to be written even if the module isn't split.
+  // Assembly is always generated serially.
+  bool Partitioned = Action == Backend_EmitObj &&
+                     !CodeGenOpts.ParallelCodeGenOutputs.empty();
+
   CreatePasses();
   switch (Action) {
   case Backend_EmitNothing:
@@ -446,8 +972,14 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
     break;
 
   default:
+    TheTarget = SetUpBackend();
+    if (!TheTarget)
+      return;
+    // The module is only split once the IR passes have run.
+    if (Partitioned)
+      break;
     FormattedOS.setStream(*OS, formatted_raw_ostream::PRESERVE_STREAM);
-    if (!AddEmitPasses(Action, FormattedOS))
+    if (!AddEmitPasses(TheTarget, Action, FormattedOS))
       return;
   }
 
@@ -459,6 +991,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    TimeRegion PhaseRegion(llvm::TimePassesIsEnabled ? &PerFunctionTime : 0);
 
     PerFunctionPasses->doInitialization();
     for (Module::iterator I = TheModule->begin(),
@@ -470,11 +1003,27 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action, raw_ostream *OS) {
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    TimeRegion PhaseRegion(llvm::TimePassesIsEnabled ? &PerModuleTime : 0);
     PerModulePasses->run(*TheModule);
   }
 
+  if (Partitioned) {
+    {
+      PrettyStackTraceString CrashInfo("Partitioned code generation");
+      TimeRegion PhaseRegion(llvm::TimePassesIsEnabled ? &MachineCodeTime : 0);
+      if (EmitPartitioned(TheTarget, *OS))
+        return;
+      EmitEmptyPartitions(TheTarget);
+    }
+
+    FormattedOS.setStream(*OS, formatted_raw_ostream::PRESERVE_STREAM);
+    if (!AddEmitPasses(TheTarget, Action, FormattedOS))
+      return;
+  }
+
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeRegion PhaseRegion(llvm::TimePassesIsEnabled ? &MachineCodeTime : 0);
     CodeGenPasses->run(*TheModule);
   }
 }
@@ -408,8 +408,11 @@ CodeGenTypes::arrangeLLVMFunctionInfo(CanQualType resultType,
 
   void *insertPos = 0;
   CGFunctionInfo *FI = FunctionInfos.FindNodeOrInsertPos(ID, insertPos);
-  if (FI)
+  if (FI) {
+    ++NumFunctionInfoHits;
     return *FI;
+  }
+  ++NumFunctionInfoMisses;
 
   // Construct the function info.  We co-allocate the ArgInfos.
   FI = CGFunctionInfo::create(CC, info, resultType, argTypes, required);
@@ -1203,6 +1203,21 @@ llvm::DIType CGDebugInfo::getOrCreateRecordType(QualType RTy,
   return T;
 }
 
+/// EmitHomedClassType - Emit the full description of a class whose vtable or
+/// explicit instantiation definition is emitted in this translation unit.
+void CGDebugInfo::EmitHomedClassType(const CXXRecordDecl *RD) {
+  if (!CGM.getCodeGenOpts().HomeClassDebugInfo ||
+      CGM.getCodeGenOpts().DebugInfo != CodeGenOptions::LimitedDebugInfo)
+    return;
+
+  // The class may not be used in this unit at all, so retain it explicitly;
+  // this is the only unit that describes it.
+  llvm::DIType T = getOrCreateType(CGM.getContext().getRecordType(RD),
+                                   getOrCreateFile(RD->getLocation()));
+  if (T.Verify() && !T.isForwardDecl())
+    DBuilder.retainType(T);
+}
+
 /// getOrCreateInterfaceType - Emit an objective c interface type standalone
 /// debug info.
 llvm::DIType CGDebugInfo::getOrCreateInterfaceType(QualType D,
@@ -1213,10 +1228,50 @@ llvm::DIType CGDebugInfo::getOrCreateInterfaceType(QualType D,
   return T;
 }
 
+/// shouldOmitDefinition - Return true if another translation unit is
+/// guaranteed to describe this record in full, so that a forward declaration
+/// is enough here. Under -fhome-class-debug-info that is the case for
+/// dynamic classes whose key function is defined elsewhere, and for class
+/// template specializations with an explicit instantiation declaration.
+bool CGDebugInfo::shouldOmitDefinition(const RecordDecl *RD) {
+  if (!CGM.getCodeGenOpts().HomeClassDebugInfo ||
+      CGM.getCodeGenOpts().DebugInfo != CodeGenOptions::LimitedDebugInfo)
+    return false;
+
+  const CXXRecordDecl *CXXDecl = dyn_cast<CXXRecordDecl>(RD);
+  if (!CXXDecl || !(CXXDecl = CXXDecl->getDefinition()))
+    return false;
+
+  TemplateSpecializationKind TSK = CXXDecl->getTemplateSpecializationKind();
+  if (TSK == TSK_ExplicitInstantiationDeclaration)
+    return true;
+
+  // Every unit that uses an implicit instantiation emits its vtable, so
+  // there is no single home for it.
+  if (!CXXDecl->isDynamicClass() || TSK == TSK_ImplicitInstantiation ||
+      TSK == TSK_ExplicitInstantiationDefinition)
+    return false;
+
+  const CXXMethodDecl *KeyFunction =
+    CGM.getContext().getKeyFunction(CXXDecl);
+  return KeyFunction && !KeyFunction->hasBody();
+}
+
 /// CreateType - get structure or union type.
 llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty) {
   RecordDecl *RD = Ty->getDecl();
 
+  // If the definition is described by the unit that emits the vtable or the
+  // explicit instantiation, just refer to it. Reuse an earlier forward
+  // declaration so that repeated uses don't each create one.
+  if (shouldOmitDefinition(RD)) {
+    llvm::DIType T = getTypeOrNull(QualType(Ty, 0));
+    if (T.Verify() && T.isForwardDecl())
+      return T;
+    return createRecordFwdDecl(RD,
+                     createContextChain(cast<Decl>(RD->getDeclContext())));
+  }
+
   // Get overall information about the record type for the debug info.
   llvm::DIFile DefUnit = getOrCreateFile(RD->getLocation());
 
@@ -1715,25 +1770,36 @@ llvm::DIType CGDebugInfo::getOrCreateType(QualType Ty, llvm::DIFile Unit) {
 
   // Unwrap the type as needed for debug information.
   Ty = UnwrapTypeForDebugInfo(Ty);
-
-  llvm::DIType T = getCompletedTypeOrNull(Ty);
-
-  if (T.Verify())
-    return T;
+  void *Key = Ty.getAsOpaquePtr();
+
+  // Look in the completed type cache directly; the type has already been
+  // unwrapped, so there is no need to go through getCompletedTypeOrNull.
+  llvm::DenseMap<void *, llvm::WeakVH>::iterator CI =
+    CompletedTypeCache.find(Key);
+  if (CI != CompletedTypeCache.end())
+    if (llvm::Value *V = CI->second) {
+      llvm::DIType T(cast<llvm::MDNode>(V));
+      if (T.Verify())
+        return T;
+    }
 
   // Otherwise create the type.
   llvm::DIType Res = CreateTypeNode(Ty, Unit);
 
-  llvm::DIType TC = getTypeOrNull(Ty);
-  if (TC.Verify() && TC.isForwardDecl())
-    ReplaceMap.push_back(std::make_pair(Ty.getAsOpaquePtr(),
-                                        static_cast<llvm::Value*>(TC)));
-  
-  // And update the type cache.
-  TypeCache[Ty.getAsOpaquePtr()] = Res;
+  // Creating the type may have added entries to the cache, so look the slot
+  // up only now; a single lookup serves both the forward declaration check
+  // and the update.
+  llvm::WeakVH &Slot = TypeCache[Key];
+  if (llvm::Value *V = Slot) {
+    llvm::DIType TC(cast<llvm::MDNode>(V));
+    if (TC.Verify() && TC.isForwardDecl() &&
+        V != static_cast<llvm::MDNode *>(Res))
+      ReplaceMap.push_back(std::make_pair(Key, V));
+  }
+  Slot = Res;
 
   if (!Res.isForwardDecl())
-    CompletedTypeCache[Ty.getAsOpaquePtr()] = Res;
+    CompletedTypeCache[Key] = Res;
 
   return Res;
 }
@@ -96,6 +96,7 @@ class CGDebugInfo {
   llvm::DIType CreateType(const FunctionType *Ty, llvm::DIFile F);
   llvm::DIType CreateType(const RecordType *Ty);
   llvm::DIType CreateLimitedType(const RecordType *Ty);
+  bool shouldOmitDefinition(const RecordDecl *RD);
   llvm::DIType CreateType(const ObjCInterfaceType *Ty, llvm::DIFile F);
   llvm::DIType CreateType(const ObjCObjectType *Ty, llvm::DIFile F);
   llvm::DIType CreateType(const VectorType *Ty, llvm::DIFile F);
@@ -231,6 +232,11 @@ public:
   /// getOrCreateRecordType - Emit record type's standalone debug info. 
   llvm::DIType getOrCreateRecordType(QualType Ty, SourceLocation L);
 
+  /// EmitHomedClassType - Emit the full description of a class whose vtable
+  /// or explicit instantiation definition is emitted in this translation
+  /// unit, when other units only get a forward declaration of it.
+  void EmitHomedClassType(const CXXRecordDecl *RD);
+
   /// getOrCreateInterfaceType - Emit an objective c interface type standalone
   /// debug info.
   llvm::DIType getOrCreateInterfaceType(QualType Ty,
@@ -177,6 +177,10 @@ namespace clang {
       Gen->HandleVTable(RD, DefinitionRequired);
     }
 
+    virtual void PrintStats() {
+      Gen->PrintStats();
+    }
+
     static void InlineAsmDiagHandler(const llvm::SMDiagnostic &SM,void *Context,
                                      unsigned LocCookie) {
       SourceLocation Loc = SourceLocation::getFromRawEncoding(LocCookie);
@@ -209,6 +213,8 @@ static FullSourceLoc ConvertBackendLocation(const llvm::SMDiagnostic &D,
   llvm::MemoryBuffer::getMemBufferCopy(LBuf->getBuffer(),
                                        LBuf->getBufferIdentifier());
   FileID FID = CSM.createFileIDForMemBuffer(CBuf);
+  if (FID.isInvalid())
+    return FullSourceLoc();
 
   // Translate the offset into the file.
   unsigned Offset = D.getLoc().getPointer()  - LBuf->getBufferStart();
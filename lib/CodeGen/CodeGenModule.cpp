@@ -45,6 +45,7 @@
 #include "llvm/Target/TargetData.h"
 #include "llvm/Support/CallSite.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -117,6 +118,10 @@ CodeGenModule::CodeGenModule(ASTContext &C, const CodeGenOptions &CGO,
 
   Block.GlobalUniqueCount = 0;
 
+  NumMangledNameHits = NumMangledNameMisses = 0;
+  NumThunkNameHits = NumThunkNameMisses = 0;
+  NumRTTINameHits = NumRTTINameMisses = 0;
+
   if (C.getLangOpts().ObjCAutoRefCount)
     ARCData = new ARCEntrypoints();
   RRData = new RREntrypoints();
@@ -185,6 +190,20 @@ void CodeGenModule::Release() {
     DebugInfo->finalize();
 }
 
+void CodeGenModule::PrintStats() const {
+  llvm::errs() << "\n*** IR Generation Stats:\n";
+  llvm::errs() << "  " << NumMangledNameHits << "/"
+               << (NumMangledNameHits + NumMangledNameMisses)
+               << " mangled name lookups hit the cache\n";
+  llvm::errs() << "  " << NumThunkNameHits << "/"
+               << (NumThunkNameHits + NumThunkNameMisses)
+               << " thunk name lookups hit the cache\n";
+  llvm::errs() << "  " << NumRTTINameHits << "/"
+               << (NumRTTINameHits + NumRTTINameMisses)
+               << " RTTI name lookups hit the cache\n";
+  Types.PrintStats();
+}
+
 void CodeGenModule::UpdateCompletedType(const TagDecl *TD) {
   // Make sure that this type is translated.
   Types.UpdateCompletedType(TD);
@@ -369,8 +388,11 @@ StringRef CodeGenModule::getMangledName(GlobalDecl GD) {
   const NamedDecl *ND = cast<NamedDecl>(GD.getDecl());
 
   StringRef &Str = MangledDeclNames[GD.getCanonicalDecl()];
-  if (!Str.empty())
+  if (!Str.empty()) {
+    ++NumMangledNameHits;
     return Str;
+  }
+  ++NumMangledNameMisses;
 
   if (!getCXXABI().getMangleContext().shouldMangleDeclName(ND)) {
     IdentifierInfo *II = ND->getIdentifier();
@@ -394,12 +416,56 @@ StringRef CodeGenModule::getMangledName(GlobalDecl GD) {
 
   // Allocate space for the mangled name.
   Out.flush();
-  size_t Length = Buffer.size();
-  char *Name = MangledNamesAllocator.Allocate<char>(Length);
-  std::copy(Buffer.begin(), Buffer.end(), Name);
-  
-  Str = StringRef(Name, Length);
-  
+  Str = copyMangledName(Buffer.str());
+  return Str;
+}
+
+StringRef CodeGenModule::copyMangledName(StringRef Name) {
+  char *Copy = MangledNamesAllocator.Allocate<char>(Name.size());
+  std::copy(Name.begin(), Name.end(), Copy);
+  return StringRef(Copy, Name.size());
+}
+
+StringRef CodeGenModule::getMangledThunkName(GlobalDecl GD,
+                                             const ThunkInfo &Thunk) {
+  StringRef &Str =
+    MangledThunkNames[std::make_pair(GD.getCanonicalDecl().getAsOpaquePtr(),
+                                     Thunk)];
+  if (!Str.empty()) {
+    ++NumThunkNameHits;
+    return Str;
+  }
+  ++NumThunkNameMisses;
+
+  const CXXMethodDecl *MD = cast<CXXMethodDecl>(GD.getDecl());
+  SmallString<256> Buffer;
+  llvm::raw_svector_ostream Out(Buffer);
+  if (const CXXDestructorDecl *DD = dyn_cast<CXXDestructorDecl>(MD))
+    getCXXABI().getMangleContext().mangleCXXDtorThunk(DD, GD.getDtorType(),
+                                                      Thunk.This, Out);
+  else
+    getCXXABI().getMangleContext().mangleThunk(MD, Thunk, Out);
+  Out.flush();
+
+  Str = copyMangledName(Buffer.str());
+  return Str;
+}
+
+StringRef CodeGenModule::getMangledRTTIName(QualType Ty) {
+  StringRef &Str =
+    MangledRTTINames[Context.getCanonicalType(Ty).getAsOpaquePtr()];
+  if (!Str.empty()) {
+    ++NumRTTINameHits;
+    return Str;
+  }
+  ++NumRTTINameMisses;
+
+  SmallString<256> Buffer;
+  llvm::raw_svector_ostream Out(Buffer);
+  getCXXABI().getMangleContext().mangleCXXRTTIName(Ty, Out);
+  Out.flush();
+
+  Str = copyMangledName(Buffer.str());
   return Str;
 }
 
@@ -714,8 +780,9 @@ void CodeGenModule::EmitDeferred() {
       continue;
     }
 
-    GlobalDecl D = DeferredDeclsToEmit.back();
+    DeferredGlobal G = DeferredDeclsToEmit.back();
     DeferredDeclsToEmit.pop_back();
+    GlobalDecl D = G.GD;
 
     // Check to see if we've already emitted this.  This is necessary
     // for a couple of reasons: first, decls can end up in the
@@ -724,9 +791,14 @@ void CodeGenModule::EmitDeferred() {
     // function acquiring a strong function redefinition).  Just
     // ignore these cases.
     //
-    // TODO: That said, looking this up multiple times is very wasteful.
-    StringRef Name = getMangledName(D);
-    llvm::GlobalValue *CGRef = GetGlobalValue(Name);
+    // The global recorded when the decl was queued is normally still the
+    // one for its mangled name; only fall back to looking the name up if it
+    // has since been replaced (e.g. by a bitcast after a type change) or
+    // erased.
+    llvm::GlobalValue *CGRef =
+      dyn_cast_or_null<llvm::GlobalValue>(static_cast<llvm::Value *>(G.GV));
+    if (!CGRef)
+      CGRef = GetGlobalValue(getMangledName(D));
     assert(CGRef && "Deferred decl wasn't referenced?");
 
     if (!CGRef->isDeclaration())
@@ -918,8 +990,8 @@ void CodeGenModule::EmitGlobal(GlobalDecl GD) {
   // If the value has already been used, add it directly to the
   // DeferredDeclsToEmit list.
   StringRef MangledName = getMangledName(GD);
-  if (GetGlobalValue(MangledName))
-    DeferredDeclsToEmit.push_back(GD);
+  if (llvm::GlobalValue *GV = GetGlobalValue(MangledName))
+    addDeferredDeclToEmit(GV, GD);
   else {
     // Otherwise, remember that we saw a deferred decl with this name.  The
     // first use of the mangled name will cause it to move into
@@ -1093,7 +1165,7 @@ CodeGenModule::GetOrCreateLLVMFunction(StringRef MangledName,
   if (DDI != DeferredDecls.end()) {
     // Move the potentially referenced deferred decl to the DeferredDeclsToEmit
     // list, and remove it from DeferredDecls (since we don't need it anymore).
-    DeferredDeclsToEmit.push_back(DDI->second);
+    addDeferredDeclToEmit(F, DDI->second);
     DeferredDecls.erase(DDI);
 
   // Otherwise, there are cases we have to worry about where we're
@@ -1115,10 +1187,10 @@ CodeGenModule::GetOrCreateLLVMFunction(StringRef MangledName,
       if (isa<CXXRecordDecl>(FD->getLexicalDeclContext())) {
         if (FD->isImplicit() && !ForVTable) {
           assert(FD->isUsed() && "Sema didn't mark implicit function as used!");
-          DeferredDeclsToEmit.push_back(D.getWithDecl(FD));
+          addDeferredDeclToEmit(F, D.getWithDecl(FD));
           break;
         } else if (FD->doesThisDeclarationHaveABody()) {
-          DeferredDeclsToEmit.push_back(D.getWithDecl(FD));
+          addDeferredDeclToEmit(F, D.getWithDecl(FD));
           break;
         }
       }
@@ -1210,6 +1282,13 @@ CodeGenModule::GetOrCreateLLVMGlobal(StringRef MangledName,
     return llvm::ConstantExpr::getBitCast(Entry, Ty);
   }
 
+  unsigned AddrSpace = GetGlobalVarAddressSpace(D, Ty->getAddressSpace());
+  llvm::GlobalVariable *GV =
+    new llvm::GlobalVariable(getModule(), Ty->getElementType(), false,
+                             llvm::GlobalValue::ExternalLinkage,
+                             0, MangledName, 0,
+                             llvm::GlobalVariable::NotThreadLocal, AddrSpace);
+
   // This is the first use or definition of a mangled name.  If there is a
   // deferred decl with this name, remember that we need to emit it at the end
   // of the file.
@@ -1217,17 +1296,10 @@ CodeGenModule::GetOrCreateLLVMGlobal(StringRef MangledName,
   if (DDI != DeferredDecls.end()) {
     // Move the potentially referenced deferred decl to the DeferredDeclsToEmit
     // list, and remove it from DeferredDecls (since we don't need it anymore).
-    DeferredDeclsToEmit.push_back(DDI->second);
+    addDeferredDeclToEmit(GV, DDI->second);
     DeferredDecls.erase(DDI);
   }
 
-  unsigned AddrSpace = GetGlobalVarAddressSpace(D, Ty->getAddressSpace());
-  llvm::GlobalVariable *GV =
-    new llvm::GlobalVariable(getModule(), Ty->getElementType(), false,
-                             llvm::GlobalValue::ExternalLinkage,
-                             0, MangledName, 0,
-                             llvm::GlobalVariable::NotThreadLocal, AddrSpace);
-
   // Handle things which are present even on external declarations.
   if (D) {
     // FIXME: This code is overly simple and should be merged with other global
@@ -2590,6 +2662,17 @@ void CodeGenModule::EmitTopLevelDecl(Decl *D) {
     // Nothing to do.
     break;
 
+  case Decl::ClassTemplateSpecialization: {
+    // An explicit instantiation definition is the home of the specialization's
+    // debug info, even if the specialization was completed earlier.
+    const ClassTemplateSpecializationDecl *Spec
+      = cast<ClassTemplateSpecializationDecl>(D);
+    if (CGDebugInfo *DI = getModuleDebugInfo())
+      if (Spec->getSpecializationKind() == TSK_ExplicitInstantiationDefinition)
+        DI->EmitHomedClassType(Spec);
+    break;
+  }
+
   // Objective-C Decls
 
   // Forward declarations, no (immediate) code generation.
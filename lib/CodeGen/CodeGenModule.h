@@ -28,6 +28,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/ValueHandle.h"
+#include <map>
 
 namespace llvm {
   class Module;
@@ -251,8 +252,18 @@ class CodeGenModule : public CodeGenTypeCache {
 
   /// DeferredDeclsToEmit - This is a list of deferred decls which we have seen
   /// that *are* actually referenced.  These get code generated when the module
-  /// is done.
-  std::vector<GlobalDecl> DeferredDeclsToEmit;
+  /// is done.  Each entry remembers the global value that caused it to be
+  /// queued so that EmitDeferred doesn't have to look the mangled name up
+  /// again; the handle is dropped if that value is replaced or erased.
+  struct DeferredGlobal {
+    DeferredGlobal(llvm::GlobalValue *GV, GlobalDecl GD) : GV(GV), GD(GD) {}
+    llvm::WeakVH GV;
+    GlobalDecl GD;
+  };
+  std::vector<DeferredGlobal> DeferredDeclsToEmit;
+  void addDeferredDeclToEmit(llvm::GlobalValue *GV, GlobalDecl GD) {
+    DeferredDeclsToEmit.push_back(DeferredGlobal(GV, GD));
+  }
 
   /// LLVMUsed - List of global values which are required to be
   /// present in the object file; bitcast to i8*. This is used for
@@ -271,6 +282,24 @@ class CodeGenModule : public CodeGenTypeCache {
   /// MangledDeclNames - A map of canonical GlobalDecls to their mangled names.
   llvm::DenseMap<GlobalDecl, StringRef> MangledDeclNames;
   llvm::BumpPtrAllocator MangledNamesAllocator;
+
+  /// MangledThunkNames - A map from a canonical GlobalDecl and a thunk
+  /// adjustment to the thunk's mangled name. A thunk is referenced from every
+  /// vtable and construction vtable that contains it.
+  std::map<std::pair<void *, ThunkInfo>, StringRef> MangledThunkNames;
+
+  /// MangledRTTINames - A map of canonical types to the mangled names of
+  /// their RTTI type name objects (_ZTS).
+  llvm::DenseMap<void *, StringRef> MangledRTTINames;
+
+  /// Hit and miss counts for the name caches above, for -print-stats.
+  unsigned NumMangledNameHits, NumMangledNameMisses;
+  unsigned NumThunkNameHits, NumThunkNameMisses;
+  unsigned NumRTTINameHits, NumRTTINameMisses;
+
+  /// copyMangledName - Copy a freshly mangled name into storage that lives
+  /// as long as this module.
+  StringRef copyMangledName(StringRef Name);
   
   /// Global annotations.
   std::vector<llvm::Constant*> Annotations;
@@ -365,6 +394,9 @@ public:
   /// Release - Finalize LLVM code generation.
   void Release();
 
+  /// PrintStats - Print hit and miss counts for the IR generation caches.
+  void PrintStats() const;
+
   /// getObjCRuntime() - Return a reference to the configured
   /// Objective-C runtime.
   CGObjCRuntime &getObjCRuntime() {
@@ -815,6 +847,8 @@ public:
                               unsigned &CallingConv);
 
   StringRef getMangledName(GlobalDecl GD);
+  StringRef getMangledThunkName(GlobalDecl GD, const ThunkInfo &Thunk);
+  StringRef getMangledRTTIName(QualType Ty);
   void getBlockMangledName(GlobalDecl GD, MangleBuffer &Buffer,
                            const BlockDecl *BD);
 
@@ -23,6 +23,7 @@
 #include "clang/AST/RecordLayout.h"
 #include "llvm/DerivedTypes.h"
 #include "llvm/Module.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetData.h"
 using namespace clang;
 using namespace CodeGen;
@@ -34,6 +35,10 @@ CodeGenTypes::CodeGenTypes(CodeGenModule &CGM)
     TheCXXABI(CGM.getCXXABI()),
     CodeGenOpts(CGM.getCodeGenOpts()), CGM(CGM) {
   SkippedLayout = false;
+  NumTypeCacheHits = NumTypeCacheMisses = 0;
+  NumRecordTypeHits = NumRecordTypeMisses = 0;
+  NumRecordLayoutHits = NumRecordLayoutMisses = 0;
+  NumFunctionInfoHits = NumFunctionInfoMisses = 0;
 }
 
 CodeGenTypes::~CodeGenTypes() {
@@ -291,8 +296,11 @@ llvm::Type *CodeGenTypes::ConvertType(QualType T) {
   // See if type is already cached.
   llvm::DenseMap<const Type *, llvm::Type *>::iterator TCI = TypeCache.find(Ty);
   // If type is found in map then use it. Otherwise, convert type T.
-  if (TCI != TypeCache.end())
+  if (TCI != TypeCache.end()) {
+    ++NumTypeCacheHits;
     return TCI->second;
+  }
+  ++NumTypeCacheMisses;
 
   // If we don't have it in the cache, convert it now.
   llvm::Type *ResultType = 0;
@@ -585,8 +593,11 @@ llvm::StructType *CodeGenTypes::ConvertRecordDeclType(const RecordDecl *RD) {
   // If this is still a forward declaration, or the LLVM type is already
   // complete, there's nothing more to do.
   RD = RD->getDefinition();
-  if (RD == 0 || !RD->isCompleteDefinition() || !Ty->isOpaque())
+  if (RD == 0 || !RD->isCompleteDefinition() || !Ty->isOpaque()) {
+    ++NumRecordTypeHits;
     return Ty;
+  }
+  ++NumRecordTypeMisses;
   
   // If converting this type would cause us to infinitely loop, don't do it!
   if (!isSafeToConvert(RD, *this)) {
@@ -637,7 +648,11 @@ CodeGenTypes::getCGRecordLayout(const RecordDecl *RD) {
   const Type *Key = Context.getTagDeclType(RD).getTypePtr();
 
   const CGRecordLayout *Layout = CGRecordLayouts.lookup(Key);
-  if (!Layout) {
+  if (Layout)
+    ++NumRecordLayoutHits;
+  else {
+    ++NumRecordLayoutMisses;
+
     // Compute the type information.
     ConvertRecordDeclType(RD);
 
@@ -674,3 +689,18 @@ bool CodeGenTypes::isZeroInitializable(QualType T) {
 bool CodeGenTypes::isZeroInitializable(const CXXRecordDecl *RD) {
   return getCGRecordLayout(RD).isZeroInitializable();
 }
+
+void CodeGenTypes::PrintStats() const {
+  llvm::errs() << "  " << NumTypeCacheHits << "/"
+               << (NumTypeCacheHits + NumTypeCacheMisses)
+               << " non-record type conversions hit the cache\n";
+  llvm::errs() << "  " << NumRecordTypeHits << "/"
+               << (NumRecordTypeHits + NumRecordTypeMisses)
+               << " record type conversions needed no layout\n";
+  llvm::errs() << "  " << NumRecordLayoutHits << "/"
+               << (NumRecordLayoutHits + NumRecordLayoutMisses)
+               << " CGRecordLayout lookups hit the cache\n";
+  llvm::errs() << "  " << NumFunctionInfoHits << "/"
+               << (NumFunctionInfoHits + NumFunctionInfoMisses)
+               << " function info arrangements hit the cache\n";
+}
@@ -97,6 +97,12 @@ class CodeGenTypes {
   /// a recursive struct conversion, set this to true.
   bool SkippedLayout;
 
+  /// Hit and miss counts for the caches above, for -print-stats.
+  unsigned NumTypeCacheHits, NumTypeCacheMisses;
+  unsigned NumRecordTypeHits, NumRecordTypeMisses;
+  unsigned NumRecordLayoutHits, NumRecordLayoutMisses;
+  unsigned NumFunctionInfoHits, NumFunctionInfoMisses;
+
   SmallVector<const RecordDecl *, 8> DeferredRecords;
   
 private:
@@ -143,6 +149,9 @@ public:
 
   const CGRecordLayout &getCGRecordLayout(const RecordDecl*);
 
+  /// PrintStats - Print hit and miss counts for the type conversion caches.
+  void PrintStats() const;
+
   /// UpdateCompletedType - When we find the full definition for a TagDecl,
   /// replace the 'opaque' type we previously made for it if applicable.
   void UpdateCompletedType(const TagDecl *TD);
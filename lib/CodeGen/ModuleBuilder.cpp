@@ -114,6 +114,11 @@ namespace {
 
       Builder->EmitVTable(RD, DefinitionRequired);
     }
+
+    virtual void PrintStats() {
+      if (Builder)
+        Builder->PrintStats();
+    }
   };
 }
 
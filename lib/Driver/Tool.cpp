@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Driver/Tool.h"
+#include "llvm/Support/ErrorHandling.h"
 
 using namespace clang::driver;
 
@@ -19,3 +20,10 @@ Tool::Tool(const char *_Name, const char *_ShortName,
 
 Tool::~Tool() {
 }
+
+void Tool::ConstructRelocatableLinkJob(Compilation &C, const JobAction &JA,
+                                       const InputInfo &Output,
+                                       const InputInfoList &Inputs,
+                                       const ArgList &TCArgs) const {
+  llvm_unreachable("Tool can't construct a relocatable link!");
+}
@@ -400,6 +400,10 @@ void Clang::AddPreprocessingOptions(Compilation &C,
     CmdArgs.push_back("-fmodule-cache-path");
     CmdArgs.push_back(Args.MakeArgString(DefaultModuleCache));
   }
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_interval);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_after);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_cache_max_size);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_cache_stats);
   
   // Parse additional include paths from environment variables.
   // FIXME: We should probably sink the logic for handling these from the
@@ -1359,6 +1363,16 @@ static bool ContainsCompileAction(const Action *A) {
   return false;
 }
 
+/// \brief Get the link tool of \p TC if it can combine the partitions of an
+/// object file generated with -fparallel-codegen, or null.
+static const Tool *getRelocatableLinker(const Compilation &C,
+                                        const ToolChain &TC) {
+  ActionList NoInputs;
+  LinkJobAction LinkJA(NoInputs, types::TY_Image);
+  const Tool &Linker = TC.SelectTool(C, LinkJA, NoInputs);
+  return Linker.hasRelocatableLink() ? &Linker : 0;
+}
+
 /// \brief Check if -relax-all should be passed to the internal assembler.
 /// This is done by default when compiling non-assembler source with -O0.
 static bool UseRelaxAll(Compilation &C, const ArgList &Args) {
@@ -1968,13 +1982,16 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
 
   // Use the last option from "-g" group. "-gline-tables-only" is
   // preserved, all other debug options are substituted with "-g".
+  bool EmitDebugInfo = false;
   Args.ClaimAllArgs(options::OPT_g_Group);
   if (Arg *A = Args.getLastArg(options::OPT_g_Group)) {
     if (A->getOption().matches(options::OPT_gline_tables_only)) {
       CmdArgs.push_back("-gline-tables-only");
+      EmitDebugInfo = true;
     } else if (!A->getOption().matches(options::OPT_g0) &&
                !A->getOption().matches(options::OPT_ggdb0)) {
       CmdArgs.push_back("-g");
+      EmitDebugInfo = true;
     }
   }
 
@@ -1984,6 +2001,16 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddAllArgs(CmdArgs, options::OPT_ffunction_sections);
   Args.AddAllArgs(CmdArgs, options::OPT_fdata_sections);
 
+  unsigned ParallelCodeGen = 0;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    if (StringRef(A->getValue(Args)).getAsInteger(10, ParallelCodeGen) ||
+        ParallelCodeGen == 0)
+      D.Diag(diag::err_drv_invalid_int_value)
+        << A->getAsString(Args) << A->getValue(Args);
+    else
+      A->render(Args, CmdArgs);
+  }
+
   Args.AddAllArgs(CmdArgs, options::OPT_finstrument_functions);
 
   if (Args.hasArg(options::OPT_ftest_coverage) ||
@@ -2231,11 +2258,18 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(A->getValue(Args));
   }
 
+  Args.AddLastArg(CmdArgs, options::OPT_ftemplate_backtrace_fold);
+
   if (Arg *A = Args.getLastArg(options::OPT_fconstexpr_backtrace_limit_EQ)) {
     CmdArgs.push_back("-fconstexpr-backtrace-limit");
     CmdArgs.push_back(A->getValue(Args));
   }
 
+  if (Arg *A = Args.getLastArg(options::OPT_fdiagnostics_note_byte_limit_EQ)) {
+    CmdArgs.push_back("-fdiagnostics-note-byte-limit");
+    CmdArgs.push_back(A->getValue(Args));
+  }
+
   // Pass -fmessage-length=.
   CmdArgs.push_back("-fmessage-length");
   if (Arg *A = Args.getLastArg(options::OPT_fmessage_length_EQ)) {
@@ -2267,6 +2301,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fheinous_gnu_extensions);
   Args.AddLastArg(CmdArgs, options::OPT_flimit_debug_info);
   Args.AddLastArg(CmdArgs, options::OPT_fno_limit_debug_info);
+  Args.AddLastArg(CmdArgs, options::OPT_fhome_class_debug_info);
   Args.AddLastArg(CmdArgs, options::OPT_fno_operator_names);
   Args.AddLastArg(CmdArgs, options::OPT_faltivec);
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_show_template_tree);
@@ -2804,7 +2839,30 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       (*it)->render(Args, CmdArgs);
   }
 
-  if (Output.getType() == types::TY_Dependencies) {
+  // With -fparallel-codegen, the partitions of an object file are written to
+  // files of their own and combined by the toolchain's linker. The module
+  // isn't split if it has debug info, so don't ask for partitions then.
+  const Tool *RelocatableLinker = 0;
+  if (ParallelCodeGen > 1 && !EmitDebugInfo && isa<AssembleJobAction>(JA) &&
+      Output.getType() == types::TY_Object && Output.isFilename() &&
+      StringRef(Output.getFilename()) != "-")
+    RelocatableLinker = getRelocatableLinker(C, getToolChain());
+
+  InputInfoList PartitionObjects;
+  if (RelocatableLinker) {
+    for (unsigned i = 0; i != ParallelCodeGen; ++i) {
+      const char *TmpPath = C.getArgs().MakeArgString(
+        D.GetTemporaryPath("cc", types::getTypeTempSuffix(types::TY_Object)));
+      C.addTempFile(TmpPath);
+      PartitionObjects.push_back(InputInfo(TmpPath, types::TY_Object,
+                                           Output.getBaseInput()));
+      if (i != 0)
+        CmdArgs.push_back("-parallel-codegen-output");
+      else
+        CmdArgs.push_back("-o");
+      CmdArgs.push_back(TmpPath);
+    }
+  } else if (Output.getType() == types::TY_Dependencies) {
     // Handled with other dependency code.
   } else if (Output.isFilename()) {
     CmdArgs.push_back("-o");
@@ -2848,6 +2906,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
 
   C.addCommand(new Command(JA, *this, Exec, CmdArgs));
 
+  if (RelocatableLinker)
+    RelocatableLinker->ConstructRelocatableLinkJob(C, JA, Output,
+                                                   PartitionObjects, Args);
+
   if (Arg *A = Args.getLastArg(options::OPT_pg))
     if (Args.hasArg(options::OPT_fomit_frame_pointer))
       D.Diag(diag::err_drv_argument_not_allowed_with)
@@ -5624,6 +5686,29 @@ static void AddLibgcc(llvm::Triple Triple, const Driver &D,
     CmdArgs.push_back("-lgcc");
 }
 
+/// \brief Get the GNU ld emulation for the architecture of \p TC.
+static const char *getLinuxEmulation(const ToolChain &TC) {
+  if (TC.getArch() == llvm::Triple::x86)
+    return "elf_i386";
+  else if (TC.getArch() == llvm::Triple::arm
+           ||  TC.getArch() == llvm::Triple::thumb)
+    return "armelf_linux_eabi";
+  else if (TC.getArch() == llvm::Triple::ppc)
+    return "elf32ppclinux";
+  else if (TC.getArch() == llvm::Triple::ppc64)
+    return "elf64ppc";
+  else if (TC.getArch() == llvm::Triple::mips)
+    return "elf32btsmip";
+  else if (TC.getArch() == llvm::Triple::mipsel)
+    return "elf32ltsmip";
+  else if (TC.getArch() == llvm::Triple::mips64)
+    return "elf64btsmip";
+  else if (TC.getArch() == llvm::Triple::mips64el)
+    return "elf64ltsmip";
+  else
+    return "elf_x86_64";
+}
+
 void linuxtools::Link::ConstructJob(Compilation &C, const JobAction &JA,
                                     const InputInfo &Output,
                                     const InputInfoList &Inputs,
@@ -5667,25 +5752,7 @@ void linuxtools::Link::ConstructJob(Compilation &C, const JobAction &JA,
   }
 
   CmdArgs.push_back("-m");
-  if (ToolChain.getArch() == llvm::Triple::x86)
-    CmdArgs.push_back("elf_i386");
-  else if (ToolChain.getArch() == llvm::Triple::arm
-           ||  ToolChain.getArch() == llvm::Triple::thumb)
-    CmdArgs.push_back("armelf_linux_eabi");
-  else if (ToolChain.getArch() == llvm::Triple::ppc)
-    CmdArgs.push_back("elf32ppclinux");
-  else if (ToolChain.getArch() == llvm::Triple::ppc64)
-    CmdArgs.push_back("elf64ppc");
-  else if (ToolChain.getArch() == llvm::Triple::mips)
-    CmdArgs.push_back("elf32btsmip");
-  else if (ToolChain.getArch() == llvm::Triple::mipsel)
-    CmdArgs.push_back("elf32ltsmip");
-  else if (ToolChain.getArch() == llvm::Triple::mips64)
-    CmdArgs.push_back("elf64btsmip");
-  else if (ToolChain.getArch() == llvm::Triple::mips64el)
-    CmdArgs.push_back("elf64ltsmip");
-  else
-    CmdArgs.push_back("elf_x86_64");
+  CmdArgs.push_back(getLinuxEmulation(ToolChain));
 
   if (Args.hasArg(options::OPT_static)) {
     if (ToolChain.getArch() == llvm::Triple::arm
@@ -5840,6 +5907,32 @@ void linuxtools::Link::ConstructJob(Compilation &C, const JobAction &JA,
   C.addCommand(new Command(JA, *this, ToolChain.Linker.c_str(), CmdArgs));
 }
 
+void linuxtools::Link::ConstructRelocatableLinkJob(Compilation &C,
+                                                   const JobAction &JA,
+                                                   const InputInfo &Output,
+                                                   const InputInfoList &Inputs,
+                                                   const ArgList &Args) const {
+  const toolchains::Linux& ToolChain =
+    static_cast<const toolchains::Linux&>(getToolChain());
+  const Driver &D = ToolChain.getDriver();
+
+  ArgStringList CmdArgs;
+  if (!D.SysRoot.empty())
+    CmdArgs.push_back(Args.MakeArgString("--sysroot=" + D.SysRoot));
+
+  CmdArgs.push_back("-m");
+  CmdArgs.push_back(getLinuxEmulation(ToolChain));
+  CmdArgs.push_back("-r");
+  CmdArgs.push_back("-o");
+  CmdArgs.push_back(Output.getFilename());
+
+  for (InputInfoList::const_iterator
+         it = Inputs.begin(), ie = Inputs.end(); it != ie; ++it)
+    CmdArgs.push_back(it->getFilename());
+
+  C.addCommand(new Command(JA, *this, ToolChain.Linker.c_str(), CmdArgs));
+}
+
 void minix::Assemble::ConstructJob(Compilation &C, const JobAction &JA,
                                    const InputInfo &Output,
                                    const InputInfoList &Inputs,
@@ -491,12 +491,18 @@ namespace linuxtools {
 
     virtual bool hasIntegratedCPP() const { return false; }
     virtual bool isLinkJob() const { return true; }
+    virtual bool hasRelocatableLink() const { return true; }
 
     virtual void ConstructJob(Compilation &C, const JobAction &JA,
                               const InputInfo &Output,
                               const InputInfoList &Inputs,
                               const ArgList &TCArgs,
                               const char *LinkingOutput) const;
+    virtual void ConstructRelocatableLinkJob(Compilation &C,
+                                             const JobAction &JA,
+                                             const InputInfo &Output,
+                                             const InputInfoList &Inputs,
+                                             const ArgList &TCArgs) const;
   };
 }
   /// minix -- Directly call GNU Binutils assembler and linker
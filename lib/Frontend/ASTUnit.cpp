@@ -14,6 +14,7 @@
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTConsumer.h"
+#include "clang/AST/DeclLookups.h"
 #include "clang/AST/DeclVisitor.h"
 #include "clang/AST/TypeOrdering.h"
 #include "clang/AST/StmtVisitor.h"
@@ -25,7 +26,9 @@
 #include "clang/Frontend/Utils.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
+#include "clang/Sema/SemaConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/Basic/TargetInfo.h"
@@ -42,7 +45,12 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/RWMutex.h"
+#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/ThreadLocal.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 #include <sys/stat.h>
@@ -216,10 +224,12 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     NumWarningsInPreamble(0),
     ShouldCacheCodeCompletionResults(false),
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
+    IncrementalFunctionBodies(false), ConcurrentQueries(false),
     CompletionCacheTopLevelHashValue(0),
     PreambleTopLevelHashValue(0),
-    CurrentTopLevelHashValue(0),
-    UnsafeToFree(false) { 
+    CurrentTopLevelHashValue(0), PreambleGeneration(0),
+    FunctionBodiesPreambleHash(0), LazyFunctionBodyRangesSorted(true),
+    ReadOnlyCheckDepth(0), UnsafeToFree(false) { 
   if (getenv("LIBCLANG_OBJTRACKING")) {
     llvm::sys::AtomicIncrement(&ActiveASTUnitObjects);
     fprintf(stderr, "+++ %d translation units\n", ActiveASTUnitObjects);
@@ -227,6 +237,11 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
 }
 
 ASTUnit::~ASTUnit() {
+  if (ConcurrentQueries && WantTiming) {
+    llvm::errs() << "Concurrent queries on " << getMainFileName() << ":\n";
+    ConcurrentQueryLocks.printStatistics(llvm::errs());
+  }
+
   clearFileLevelDecls();
 
   // Clean up the temporary files and the preamble file.
@@ -866,16 +881,20 @@ void AddTopLevelDeclarationToHash(Decl *D, unsigned &Hash) {
   }  
 }
 
-class TopLevelDeclTrackerConsumer : public ASTConsumer {
+class TopLevelDeclTrackerConsumer : public SemaConsumer {
   ASTUnit &Unit;
   unsigned &Hash;
+  Sema *TheSema;
   
 public:
   TopLevelDeclTrackerConsumer(ASTUnit &_Unit, unsigned &Hash)
-    : Unit(_Unit), Hash(Hash) {
+    : Unit(_Unit), Hash(Hash), TheSema(0) {
     Hash = 0;
   }
 
+  void InitializeSema(Sema &S) { TheSema = &S; }
+  void ForgetSema() { TheSema = 0; }
+
   void handleTopLevelDecl(Decl *D) {
     if (!D)
       return;
@@ -915,6 +934,12 @@ public:
     for (DeclGroupRef::iterator it = D.begin(), ie = D.end(); it != ie; ++it)
       handleTopLevelDecl(*it);
   }
+
+  bool shouldParseFunctionBodyLazily(FunctionDecl *FD, SourceRange BodyRange) {
+    if (!TheSema)
+      return false;
+    return Unit.shouldParseFunctionBodyLazily(*TheSema, FD, BodyRange);
+  }
 };
 
 class TopLevelDeclTrackerAction : public ASTFrontendAction {
@@ -1108,6 +1133,8 @@ bool ASTUnit::Parse(llvm::MemoryBuffer *OverrideMainBuffer) {
   // Clear out old caches and data.
   TopLevelDecls.clear();
   clearFileLevelDecls();
+  LazyFunctionBodyRanges.clear();
+  LazyFunctionBodyRangesSorted = true;
   CleanTemporaryFiles();
 
   if (!OverrideMainBuffer) {
@@ -1153,6 +1180,9 @@ bool ASTUnit::Parse(llvm::MemoryBuffer *OverrideMainBuffer) {
   if (!Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0]))
     goto error;
 
+  if (IncrementalFunctionBodies)
+    matchFunctionBodies();
+
   if (OverrideMainBuffer) {
     std::string ModName = getPreambleFile(this);
     TranslateStoredDiagnostics(Clang->getModuleManager(), ModName,
@@ -1167,6 +1197,12 @@ bool ASTUnit::Parse(llvm::MemoryBuffer *OverrideMainBuffer) {
   
   Act->EndSourceFile();
 
+  if (IncrementalFunctionBodies)
+    finishFunctionBodies();
+
+  if (ConcurrentQueries)
+    prepareForConcurrentQueries();
+
   FailedParseDiagnostics.clear();
 
   return false;
@@ -1178,6 +1214,13 @@ error:
     SavedMainFileBuffer = 0;
   }
 
+  // Nothing of this parse can be trusted by the next one.
+  FunctionBodies.clear();
+  FunctionBodiesMainFileText.clear();
+  FunctionBodyDependencies.clear();
+  FunctionBodyDiagnostics.clear();
+  ReusedFunctionBodies.clear();
+
   // Keep the ownership of the data in the ASTUnit because the client may
   // want to see the diagnostics.
   transferASTDataFromCompilerInstance(*Clang);
@@ -1187,6 +1230,596 @@ error:
   return true;
 }
 
+//----------------------------------------------------------------------------//
+// Incremental function bodies
+//----------------------------------------------------------------------------//
+
+/// \brief Find the offset of the brace that closes the one at offset \p Begin
+/// of \p Text, the contents of \p FID, or ~0U if there is none.
+static unsigned findClosingBrace(SourceManager &SM, FileID FID,
+                                 const LangOptions &LangOpts, StringRef Text,
+                                 unsigned Begin) {
+  Lexer RawLex(SM.getLocForStartOfFile(FID), LangOpts, Text.begin(),
+               Text.begin() + Begin, Text.end());
+  unsigned Depth = 0;
+  Token Tok;
+  do {
+    RawLex.LexFromRawLexer(Tok);
+    if (Tok.is(tok::l_brace))
+      ++Depth;
+    else if (Tok.is(tok::r_brace) && --Depth == 0)
+      return SM.getFileOffset(Tok.getLocation());
+  } while (Tok.isNot(tok::eof));
+  return ~0U;
+}
+
+/// \brief Find the function body of the last parse that contains \p Loc, and
+/// the offset of \p Loc from its opening brace.
+bool ASTUnit::getFunctionBodyOffset(SourceLocation Loc, unsigned &Body,
+                                    unsigned &Offset) {
+  if (Loc.isInvalid())
+    return false;
+
+  std::pair<FileID, unsigned> LocInfo
+    = getSourceManager().getDecomposedExpansionLoc(Loc);
+  if (LocInfo.first != getSourceManager().getMainFileID())
+    return false;
+
+  // Find the first body that does not end before the location.
+  unsigned Lo = 0, Hi = FunctionBodies.size();
+  while (Lo != Hi) {
+    unsigned Mid = Lo + (Hi - Lo) / 2;
+    if (FunctionBodies[Mid].End < LocInfo.second)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+  if (Lo == FunctionBodies.size() || FunctionBodies[Lo].Begin > LocInfo.second)
+    return false;
+
+  Body = Lo;
+  Offset = LocInfo.second - FunctionBodies[Lo].Begin;
+  return true;
+}
+
+/// \brief Save the diagnostics reported inside the function bodies of the
+/// last parse, relative to their bodies, so that the next parse can carry
+/// them over for the bodies it does not parse again.
+void ASTUnit::saveFunctionBodyDiagnostics() {
+  FunctionBodyDiagnostics.clear();
+  if (FunctionBodies.empty() || !SourceMgr)
+    return;
+
+  unsigned Body = ~0U;
+  for (stored_diag_iterator D = stored_diag_afterDriver_begin(),
+                         DEnd = stored_diag_end();
+       D != DEnd; ++D) {
+    // Notes go with the diagnostic they follow.
+    unsigned Offset;
+    if (D->getLevel() != DiagnosticsEngine::Note &&
+        !getFunctionBodyOffset(D->getLocation(), Body, Offset))
+      Body = ~0U;
+
+    // Any other body the diagnostic points into, e.g. with a note attached to
+    // a diagnostic at file scope, has to be parsed again to report it again.
+    SmallVector<SourceLocation, 4> Locs;
+    Locs.push_back(D->getLocation());
+    for (StoredDiagnostic::range_iterator R = D->range_begin(),
+                                       REnd = D->range_end();
+         R != REnd; ++R) {
+      Locs.push_back(R->getBegin());
+      Locs.push_back(R->getEnd());
+    }
+    for (StoredDiagnostic::fixit_iterator F = D->fixit_begin(),
+                                       FEnd = D->fixit_end();
+         F != FEnd; ++F) {
+      Locs.push_back(F->RemoveRange.getBegin());
+      Locs.push_back(F->RemoveRange.getEnd());
+    }
+    for (unsigned I = 0, N = Locs.size(); I != N; ++I) {
+      unsigned LocBody;
+      if (getFunctionBodyOffset(Locs[I], LocBody, Offset) && LocBody != Body)
+        FunctionBodies[LocBody].DiagnosticsAreLocal = false;
+    }
+
+    if (Body == ~0U || !FunctionBodies[Body].DiagnosticsAreLocal)
+      continue;
+
+    FunctionBodyDiagnostic Saved;
+    Saved.Body = Body;
+    Saved.Level = D->getLevel();
+    Saved.ID = D->getID();
+    Saved.Message = D->getMessage();
+
+    // Everything the diagnostic points at has to be inside the same body,
+    // otherwise the body will have to be parsed again.
+    unsigned LocBody;
+    bool Local = getFunctionBodyOffset(D->getLocation(), LocBody,
+                                       Saved.Offset) && LocBody == Body;
+    for (StoredDiagnostic::range_iterator R = D->range_begin(),
+                                       REnd = D->range_end();
+         Local && R != REnd; ++R) {
+      FunctionBodyRange Range;
+      unsigned BeginBody, EndBody;
+      Range.IsTokenRange = R->isTokenRange();
+      Local = getFunctionBodyOffset(R->getBegin(), BeginBody, Range.Begin) &&
+              getFunctionBodyOffset(R->getEnd(), EndBody, Range.End) &&
+              BeginBody == Body && EndBody == Body;
+      Saved.Ranges.push_back(Range);
+    }
+    for (StoredDiagnostic::fixit_iterator F = D->fixit_begin(),
+                                       FEnd = D->fixit_end();
+         Local && F != FEnd; ++F) {
+      FunctionBodyRange Range;
+      unsigned BeginBody, EndBody;
+      Range.IsTokenRange = F->RemoveRange.isTokenRange();
+      Local = F->InsertFromRange.isInvalid() &&
+              getFunctionBodyOffset(F->RemoveRange.getBegin(), BeginBody,
+                                    Range.Begin) &&
+              getFunctionBodyOffset(F->RemoveRange.getEnd(), EndBody,
+                                    Range.End) &&
+              BeginBody == Body && EndBody == Body;
+      Saved.FixIts.push_back(std::make_pair(Range, F->CodeToInsert));
+    }
+
+    if (!Local) {
+      FunctionBodies[Body].DiagnosticsAreLocal = false;
+      continue;
+    }
+    FunctionBodyDiagnostics.push_back(Saved);
+  }
+}
+
+/// \brief Match the function bodies of the last parse against the main file
+/// about to be parsed.
+///
+/// The text between the bodies has to be exactly the same as before, so that
+/// all declarations, and therefore the meaning of every body, stay the same.
+/// Bodies whose text did not change either can then be left lazy.
+void ASTUnit::matchFunctionBodies() {
+  ParsedFunctionBodies.clear();
+  UnchangedFunctionBodies.clear();
+  ReusedFunctionBodies.clear();
+  if (FunctionBodies.empty())
+    return;
+
+  // If anything besides the main file changed, the bodies of the last parse
+  // may mean something else now, and so may what they use; parse them all.
+  if (functionBodyDependenciesChanged())
+    return;
+
+  SourceManager &SM = getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+  bool Invalid = false;
+  StringRef Text = SM.getBufferData(MainFID, &Invalid);
+  if (Invalid)
+    return;
+
+  StringRef OldText = FunctionBodiesMainFileText;
+  std::vector<std::pair<unsigned, unsigned> > Unchanged;
+  unsigned Pos = 0, OldPos = 0;
+  for (unsigned I = 0, N = FunctionBodies.size(); I != N; ++I) {
+    const FunctionBodyInfo &Old = FunctionBodies[I];
+    unsigned Begin = Pos + (Old.Begin - OldPos);
+    if (Begin >= Text.size() || Text[Begin] != '{' ||
+        Text.slice(Pos, Begin) != OldText.slice(OldPos, Old.Begin))
+      return;
+
+    unsigned End = findClosingBrace(SM, MainFID, *LangOpts, Text, Begin);
+    if (End == ~0U)
+      return;
+    if (Old.DiagnosticsAreLocal && Old.UsesAreLocal &&
+        Text.slice(Begin, End + 1) == OldText.slice(Old.Begin, Old.End + 1))
+      Unchanged.push_back(std::make_pair(Begin, I));
+
+    Pos = End + 1;
+    OldPos = Old.End + 1;
+  }
+  if (Text.substr(Pos) != OldText.substr(OldPos))
+    return;
+
+  UnchangedFunctionBodies.swap(Unchanged);
+}
+
+bool ASTUnit::shouldParseFunctionBodyLazily(Sema &S, FunctionDecl *FD,
+                                            SourceRange BodyRange) {
+  if (!IncrementalFunctionBodies) {
+    addLazyFunctionBody(FD, BodyRange);
+    return true;
+  }
+
+  // Only bodies in the main file are tracked; parse any others right away.
+  SourceManager &SM = getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+  if (!BodyRange.getBegin().isFileID() || !BodyRange.getEnd().isFileID() ||
+      SM.getFileID(BodyRange.getBegin()) != MainFID ||
+      SM.getFileID(BodyRange.getEnd()) != MainFID)
+    return false;
+
+  FunctionBodyInfo Body;
+  Body.FD = FD;
+  Body.Begin = SM.getFileOffset(BodyRange.getBegin());
+  Body.End = SM.getFileOffset(BodyRange.getEnd());
+  Body.ReusedFrom = ~0U;
+  Body.DiagnosticsAreLocal = true;
+  Body.UsesAreLocal = true;
+
+  std::vector<std::pair<unsigned, unsigned> >::iterator I
+    = std::lower_bound(UnchangedFunctionBodies.begin(),
+                       UnchangedFunctionBodies.end(),
+                       std::make_pair(Body.Begin, 0U));
+  if (I != UnchangedFunctionBodies.end() && I->first == Body.Begin &&
+      Body.End - Body.Begin ==
+        FunctionBodies[I->second].End - FunctionBodies[I->second].Begin) {
+    Body.ReusedFrom = I->second;
+
+    // Sema won't see what the body uses; remember it from the last parse.
+    const FunctionBodyInfo &Old = FunctionBodies[I->second];
+    Body.UsedDecls = Old.UsedDecls;
+    Body.ReferencedDecls = Old.ReferencedDecls;
+    for (std::vector<std::string>::const_iterator
+           D = Old.UsedDecls.begin(), DEnd = Old.UsedDecls.end();
+         D != DEnd; ++D)
+      S.LazyFunctionBodyUses[*D] = true;
+    for (std::vector<std::string>::const_iterator
+           D = Old.ReferencedDecls.begin(), DEnd = Old.ReferencedDecls.end();
+         D != DEnd; ++D)
+      S.LazyFunctionBodyUses.GetOrCreateValue(*D, false);
+  }
+
+  ParsedFunctionBodies.push_back(Body);
+  if (Body.ReusedFrom == ~0U)
+    return false;
+  addLazyFunctionBody(FD, BodyRange);
+  return true;
+}
+
+/// \brief Remember that the parse may leave the body of \p FD, spanning
+/// \p BodyRange, lazy.
+void ASTUnit::addLazyFunctionBody(FunctionDecl *FD, SourceRange BodyRange) {
+  SourceManager &SM = getSourceManager();
+  SourceRange Range(SM.getExpansionLoc(BodyRange.getBegin()),
+                    SM.getExpansionRange(BodyRange.getEnd()).second);
+  if (!LazyFunctionBodyRanges.empty() &&
+      !SM.isBeforeInTranslationUnit(
+         LazyFunctionBodyRanges.back().first.getEnd(), Range.getBegin()))
+    LazyFunctionBodyRangesSorted = false;
+  LazyFunctionBodyRanges.push_back(std::make_pair(Range, FD));
+}
+
+static void sortAndUnique(std::vector<std::string> &Keys) {
+  std::sort(Keys.begin(), Keys.end());
+  Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+}
+
+/// \brief Take over what Sema recorded while parsing the body \p Body, for
+/// the parses that leave it lazy.
+void ASTUnit::collectFunctionBodyUses(FunctionBodyInfo &Body) {
+  Body.UsedDecls.clear();
+  Body.ReferencedDecls.clear();
+  Body.UsesAreLocal = false;
+  if (!TheSema)
+    return;
+  llvm::DenseMap<const FunctionDecl *, Sema::FunctionBodyUses>::iterator Uses
+    = TheSema->RecordedFunctionBodyUses.find(Body.FD);
+  if (Uses == TheSema->RecordedFunctionBodyUses.end())
+    return;
+
+  Body.UsedDecls.swap(Uses->second.UsedDecls);
+  Body.ReferencedDecls.swap(Uses->second.ReferencedDecls);
+  Body.UsesAreLocal = !Uses->second.HasNonLocalEffects;
+  sortAndUnique(Body.UsedDecls);
+  sortAndUnique(Body.ReferencedDecls);
+}
+
+/// \brief Compute a hash identifying the precompiled preamble the function
+/// bodies of the main file were parsed with.
+unsigned ASTUnit::hashFunctionBodiesPreamble() {
+  return llvm::HashString(getPreambleFile(this), PreambleGeneration);
+}
+
+/// \brief Describe the current state of the file \p Name, taking the remapped
+/// files and buffers of the invocation into account.
+///
+/// \returns false if the file can't be found.
+bool ASTUnit::getFunctionBodyDependency(StringRef Name,
+                                        FunctionBodyDependency &Dep) {
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  for (PreprocessorOptions::remapped_file_buffer_iterator
+         R = PPOpts.remapped_file_buffer_begin(),
+         REnd = PPOpts.remapped_file_buffer_end();
+       R != REnd; ++R) {
+    if (R->first != Name)
+      continue;
+    Dep.Size = R->second->getBufferSize();
+    Dep.ModTime = 0;
+    Dep.BufferHash = llvm::HashString(R->second->getBuffer());
+    return true;
+  }
+
+  std::string Path = Name;
+  for (PreprocessorOptions::remapped_file_iterator
+         R = PPOpts.remapped_file_begin(), REnd = PPOpts.remapped_file_end();
+       R != REnd; ++R) {
+    if (R->first == Name)
+      Path = R->second;
+  }
+
+  struct stat StatBuf;
+  if (FileMgr->getNoncachedStatValue(Path, StatBuf))
+    return false;
+  Dep.Size = StatBuf.st_size;
+  Dep.ModTime = StatBuf.st_mtime;
+  Dep.BufferHash = 0;
+  return true;
+}
+
+/// \brief Remember the files the parse read besides the main file and the
+/// precompiled preamble, so that the next parse can tell whether they changed
+/// before it decides which bodies to reuse.
+///
+/// \returns false if one of them can't be found anymore.
+bool ASTUnit::recordFunctionBodyDependencies() {
+  FunctionBodyDependencies.clear();
+  FunctionBodiesPreambleHash = hashFunctionBodiesPreamble();
+
+  SourceManager &SM = getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  for (unsigned I = 0, N = SM.local_sloc_entry_size(); I != N; ++I) {
+    const SrcMgr::SLocEntry &Entry = SM.getLocalSLocEntry(I);
+    if (!Entry.isFile())
+      continue;
+
+    const SrcMgr::ContentCache *Content = Entry.getFile().getContentCache();
+    if (!Content || !Content->OrigEntry || Content->OrigEntry == MainFile)
+      continue;
+
+    StringRef Name = Content->OrigEntry->getName();
+    if (FunctionBodyDependencies.count(Name))
+      continue;
+    FunctionBodyDependency Dep;
+    if (!getFunctionBodyDependency(Name, Dep))
+      return false;
+    FunctionBodyDependencies[Name] = Dep;
+  }
+  return true;
+}
+
+/// \brief Determine whether the preamble, or any file other than the main
+/// file that the last parse read, changed since.
+bool ASTUnit::functionBodyDependenciesChanged() {
+  if (hashFunctionBodiesPreamble() != FunctionBodiesPreambleHash)
+    return true;
+
+  for (llvm::StringMap<FunctionBodyDependency>::iterator
+         D = FunctionBodyDependencies.begin(),
+         DEnd = FunctionBodyDependencies.end();
+       D != DEnd; ++D) {
+    FunctionBodyDependency Current;
+    if (!getFunctionBodyDependency(D->first(), Current) ||
+        Current != D->second)
+      return true;
+  }
+  return false;
+}
+
+/// \brief Carry over the diagnostics of the function bodies the parse left
+/// lazy, and remember the bodies of this parse for the next one.
+void ASTUnit::finishFunctionBodies() {
+  SourceManager &SM = getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+
+  std::vector<unsigned> NewBegin(FunctionBodies.size(), ~0U);
+  unsigned NumReused = 0;
+  for (std::vector<FunctionBodyInfo>::iterator
+         B = ParsedFunctionBodies.begin(), BEnd = ParsedFunctionBodies.end();
+       B != BEnd; ++B) {
+    // The parser parses a body it left lazy before any later declaration
+    // that may change its meaning; that body reported its diagnostics anew.
+    if (B->ReusedFrom != ~0U && !B->FD->hasUnparsedCachedBody())
+      B->ReusedFrom = ~0U;
+    if (B->ReusedFrom == ~0U) {
+      collectFunctionBodyUses(*B);
+      continue;
+    }
+    NewBegin[B->ReusedFrom] = B->Begin;
+    ReusedFunctionBodies.insert(B->FD);
+    ++NumReused;
+  }
+
+  SourceLocation MainStart = SM.getLocForStartOfFile(MainFID);
+  SmallVector<StoredDiagnostic, 4> Reused;
+  for (std::vector<FunctionBodyDiagnostic>::iterator
+         D = FunctionBodyDiagnostics.begin(),
+         DEnd = FunctionBodyDiagnostics.end();
+       D != DEnd; ++D) {
+    if (NewBegin[D->Body] == ~0U)
+      continue;
+
+    SourceLocation BodyStart = MainStart.getLocWithOffset(NewBegin[D->Body]);
+    SmallVector<CharSourceRange, 4> Ranges;
+    for (std::vector<FunctionBodyRange>::iterator R = D->Ranges.begin(),
+                                               REnd = D->Ranges.end();
+         R != REnd; ++R) {
+      SourceRange Range(BodyStart.getLocWithOffset(R->Begin),
+                        BodyStart.getLocWithOffset(R->End));
+      Ranges.push_back(CharSourceRange(Range, R->IsTokenRange));
+    }
+    SmallVector<FixItHint, 2> FixIts;
+    for (std::vector<std::pair<FunctionBodyRange, std::string> >::iterator
+           F = D->FixIts.begin(), FEnd = D->FixIts.end();
+         F != FEnd; ++F) {
+      SourceRange Range(BodyStart.getLocWithOffset(F->first.Begin),
+                        BodyStart.getLocWithOffset(F->first.End));
+      FixItHint FixIt;
+      FixIt.RemoveRange = CharSourceRange(Range, F->first.IsTokenRange);
+      FixIt.CodeToInsert = F->second;
+      FixIts.push_back(FixIt);
+    }
+    Reused.push_back(
+      StoredDiagnostic(D->Level, D->ID, D->Message,
+                       FullSourceLoc(BodyStart.getLocWithOffset(D->Offset), SM),
+                       Ranges, FixIts));
+  }
+  FunctionBodyDiagnostics.clear();
+
+  // Merge the carried-over diagnostics into those of this parse in source
+  // order, keeping each note after the diagnostic it belongs to.
+  if (!Reused.empty()) {
+    SmallVector<StoredDiagnostic, 4> Merged(StoredDiagnostics.begin(),
+                                            stored_diag_afterDriver_begin());
+    unsigned R = 0, NumReusedDiags = Reused.size();
+    for (stored_diag_iterator D = stored_diag_afterDriver_begin(),
+                           DEnd = stored_diag_end();
+         D != DEnd; ++D) {
+      if (D->getLevel() != DiagnosticsEngine::Note &&
+          D->getLocation().isValid()) {
+        while (R != NumReusedDiags &&
+               SM.isBeforeInTranslationUnit(Reused[R].getLocation(),
+                                            D->getLocation())) {
+          do
+            Merged.push_back(Reused[R++]);
+          while (R != NumReusedDiags &&
+                 Reused[R].getLevel() == DiagnosticsEngine::Note);
+        }
+      }
+      Merged.push_back(*D);
+    }
+    Merged.append(Reused.begin() + R, Reused.end());
+    StoredDiagnostics.swap(Merged);
+  }
+
+  // Remember the bodies in source order, along with the text around them.
+  std::sort(ParsedFunctionBodies.begin(), ParsedFunctionBodies.end());
+  for (std::vector<FunctionBodyInfo>::iterator
+         B = ParsedFunctionBodies.begin(), BEnd = ParsedFunctionBodies.end();
+       B != BEnd; ++B)
+    B->FD = 0;
+  FunctionBodiesMainFileText = SM.getBufferData(MainFID);
+  FunctionBodies.swap(ParsedFunctionBodies);
+  if (!recordFunctionBodyDependencies())
+    FunctionBodies.clear();
+  ParsedFunctionBodies.clear();
+  UnchangedFunctionBodies.clear();
+
+  if (WantTiming)
+    llvm::errs() << "Reused " << NumReused << " of " << FunctionBodies.size()
+                 << " function bodies of " << getMainFileName() << "\n";
+}
+
+bool ASTUnit::parseLazyFunctionBody(FunctionDecl *FD) {
+  if (!TheSema)
+    return false;
+
+  // The diagnostics of a reused body were carried over from the parse that
+  // recorded it; don't report them again.
+  DiagnosticsEngine &Diags = getDiagnostics();
+  bool OldSuppress = Diags.getSuppressAllDiagnostics();
+  if (ReusedFunctionBodies.count(FD))
+    Diags.setSuppressAllDiagnostics(true);
+  bool Parsed = TheSema->ParseLazyFunctionBody(FD);
+  Diags.setSuppressAllDiagnostics(OldSuppress);
+  return Parsed;
+}
+
+/// \brief Collect the functions declared by \p D, or in the namespaces and
+/// classes it declares, whose bodies are still waiting to be parsed.
+static void collectLazyFunctionBodies(Decl *D,
+                                      SmallVectorImpl<FunctionDecl *> &Lazy) {
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    if (FD->hasUnparsedCachedBody())
+      Lazy.push_back(FD);
+    return;
+  }
+
+  DeclContext *DC = dyn_cast<DeclContext>(D);
+  if (!DC || isa<ObjCContainerDecl>(DC))
+    return;
+  for (DeclContext::decl_iterator I = DC->noload_decls_begin(),
+                                  E = DC->noload_decls_end(); I != E; ++I)
+    collectLazyFunctionBodies(*I, Lazy);
+}
+
+/// \brief Determine whether the AST may have lazy bodies, and may be modified
+/// by parsing them now.
+bool ASTUnit::canParseLazyFunctionBodies() const {
+  if (!TheSema || isMainFileAST() || !Invocation ||
+      !Invocation->getFrontendOpts().LazyFunctionBodies ||
+      LazyFunctionBodyRanges.empty())
+    return false;
+
+  // A query that reads the AST is going on.
+  return ReadOnlyCheckDepth == 0;
+}
+
+void ASTUnit::parseLazyFunctionBodies(Decl *D) {
+  if (!D || !canParseLazyFunctionBodies())
+    return;
+  ConcurrencyCheck Check(*this);
+
+  // Collect first; parsing a body adds declarations to the contexts we walk.
+  SmallVector<FunctionDecl *, 16> LazyBodies;
+  collectLazyFunctionBodies(D, LazyBodies);
+  for (unsigned I = 0, N = LazyBodies.size(); I != N; ++I)
+    parseLazyFunctionBody(LazyBodies[I]);
+}
+
+namespace {
+/// \brief Compares lazy bodies, and a lazy body with a location, by where
+/// the bodies end.
+class LazyBodyEndCompare {
+  BeforeThanCompare<SourceLocation> Before;
+
+public:
+  explicit LazyBodyEndCompare(SourceManager &SM) : Before(SM) { }
+
+  bool operator()(const std::pair<SourceRange, FunctionDecl *> &Body,
+                  SourceLocation Loc) {
+    return Before(Body.first.getEnd(), Loc);
+  }
+  bool operator()(const std::pair<SourceRange, FunctionDecl *> &LHS,
+                  const std::pair<SourceRange, FunctionDecl *> &RHS) {
+    return Before(LHS.first.getEnd(), RHS.first.getEnd());
+  }
+};
+}
+
+void ASTUnit::parseLazyFunctionBodies(SourceRange Range) {
+  if (!canParseLazyFunctionBodies())
+    return;
+  ConcurrencyCheck Check(*this);
+
+  SourceManager &SM = getSourceManager();
+  LazyBodyEndCompare Compare(SM);
+  if (!LazyFunctionBodyRangesSorted) {
+    std::sort(LazyFunctionBodyRanges.begin(), LazyFunctionBodyRanges.end(),
+              Compare);
+    LazyFunctionBodyRangesSorted = true;
+  }
+
+  // The bodies don't overlap, so those ending at or after the start of the
+  // range are sorted by their starts too.
+  typedef std::vector<std::pair<SourceRange, FunctionDecl *> >::iterator
+    iterator;
+  iterator Begin = LazyFunctionBodyRanges.begin();
+  iterator End = LazyFunctionBodyRanges.end();
+  if (Range.isValid()) {
+    SourceLocation RangeBegin = SM.getExpansionLoc(Range.getBegin());
+    SourceLocation RangeEnd = SM.getExpansionRange(Range.getEnd()).second;
+    Begin = std::lower_bound(Begin, End, RangeBegin, Compare);
+    iterator I = Begin;
+    while (I != End && !SM.isBeforeInTranslationUnit(RangeEnd,
+                                                     I->first.getBegin()))
+      ++I;
+    End = I;
+  }
+
+  // Parsing a body doesn't add lazy ones, so the iterators stay valid.
+  for (iterator I = Begin; I != End; ++I)
+    if (I->second->hasUnparsedCachedBody())
+      parseLazyFunctionBody(I->second);
+}
+
 /// \brief Simple function to retrieve a path for a preamble precompiled header.
 static std::string GetPreamblePCHPath() {
   // FIXME: This is lame; sys::Path should provide this function (in particular,
@@ -1525,6 +2158,8 @@ llvm::MemoryBuffer *ASTUnit::getMainBufferWithPrecompiledPreamble(
   FrontendOpts.ProgramAction = frontend::GeneratePCH;
   // FIXME: Generate the precompiled header into memory?
   FrontendOpts.OutputFile = PreamblePCHPath;
+  // Bodies cached for lazy parsing would not survive serialization.
+  FrontendOpts.LazyFunctionBodies = false;
   PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
   PreprocessorOpts.PrecompiledPreambleBytes.second = false;
   
@@ -1617,6 +2252,7 @@ llvm::MemoryBuffer *ASTUnit::getMainBufferWithPrecompiledPreamble(
   
   // Keep track of the preamble we precompiled.
   setPreambleFile(this, FrontendOpts.OutputFile);
+  ++PreambleGeneration;
   NumWarningsInPreamble = getDiagnostics().getNumWarnings();
   
   // Keep track of all of the files that the source manager knows about,
@@ -1926,6 +2562,9 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
                                       bool IncludeBriefCommentsInCodeCompletion,
                                       bool AllowPCHWithCompilerErrors,
                                       bool SkipFunctionBodies,
+                                      bool LazyFunctionBodies,
+                                      bool IncrementalFunctionBodies,
+                                      bool ConcurrentQueries,
                                       bool UserFilesAreVolatile,
                                       OwningPtr<ASTUnit> *ErrAST) {
   if (!Diags.getPtr()) {
@@ -1970,7 +2609,14 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
   // Override the resources path.
   CI->getHeaderSearchOpts().ResourceDir = ResourceFilesPath;
 
+  // Parsing a body on demand modifies the AST, which concurrent queries
+  // cannot do; they get every body up front instead.
+  if (ConcurrentQueries)
+    LazyFunctionBodies = IncrementalFunctionBodies = false;
+
   CI->getFrontendOpts().SkipFunctionBodies = SkipFunctionBodies;
+  CI->getFrontendOpts().LazyFunctionBodies = LazyFunctionBodies ||
+                                             IncrementalFunctionBodies;
 
   // Create the AST unit.
   OwningPtr<ASTUnit> AST;
@@ -1987,6 +2633,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
   AST->IncludeBriefCommentsInCodeCompletion
     = IncludeBriefCommentsInCodeCompletion;
   AST->UserFilesAreVolatile = UserFilesAreVolatile;
+  AST->IncrementalFunctionBodies = IncrementalFunctionBodies;
+  AST->ConcurrentQueries = ConcurrentQueries;
   AST->NumStoredDiagnosticsFromDriver = StoredDiagnostics.size();
   AST->StoredDiagnostics.swap(StoredDiagnostics);
   AST->Invocation = CI;
@@ -2018,6 +2666,11 @@ bool ASTUnit::Reparse(RemappedFile *RemappedFiles, unsigned NumRemappedFiles) {
   SimpleTimer ParsingTimer(WantTiming);
   ParsingTimer.setOutput("Reparsing " + getMainFileName());
 
+  // Save the diagnostics of function bodies while the source manager they
+  // refer to is still around; building the preamble below drops them.
+  if (IncrementalFunctionBodies)
+    saveFunctionBodyDiagnostics();
+
   // Remap files.
   PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
   PPOpts.DisableStatCache = true;
@@ -2507,6 +3160,10 @@ CXSaveError ASTUnit::Save(StringRef File) {
 }
 
 bool ASTUnit::serialize(raw_ostream &OS) {
+  // The AST file has no notion of a lazy body; a body that was never parsed
+  // would be written as if the function had none.
+  parseLazyFunctionBodies();
+
   bool hasErrors = getDiagnostics().hasErrorOccurred();
 
   SmallString<128> Buffer;
@@ -2819,3 +3476,212 @@ void ASTUnit::ConcurrencyState::start() {}
 void ASTUnit::ConcurrencyState::finish() {}
 
 #endif
+
+//===----------------------------------------------------------------------===//
+// Concurrent queries
+//===----------------------------------------------------------------------===//
+
+ASTUnit::ConcurrentQueryState::ConcurrentQueryState()
+  : AccessMutex(new llvm::sys::RWMutexImpl()),
+    LazyStateMutex(new llvm::sys::MutexImpl(/*recursive=*/true)),
+    StatisticsMutex(new llvm::sys::MutexImpl(/*recursive=*/false)),
+    Readers(0), Writers(0) {
+}
+
+ASTUnit::ConcurrentQueryState::~ConcurrentQueryState() {
+  delete AccessMutex;
+  delete LazyStateMutex;
+  delete StatisticsMutex;
+}
+
+void ASTUnit::ConcurrentQueryState::recordWait(LockStatistics &Stats,
+                                               uint64_t Microseconds) {
+  StatisticsMutex->acquire();
+  ++Stats.Contended;
+  Stats.WaitMicroseconds += Microseconds;
+  StatisticsMutex->release();
+}
+
+// The reader and writer counts only tell whether an acquisition is likely to
+// block; a thread that slips in between the check and the acquisition is not
+// counted. That is good enough to see whether contention matters, without
+// timing every acquisition.
+
+void ASTUnit::ConcurrentQueryState::startShared() {
+  llvm::sys::AtomicIncrement(&Shared.Acquisitions);
+  if (llvm::sys::AtomicAdd(&Writers, 0) == 0) {
+    AccessMutex->reader_acquire();
+  } else {
+    llvm::sys::TimeValue Start = llvm::sys::TimeValue::now();
+    AccessMutex->reader_acquire();
+    recordWait(Shared, (llvm::sys::TimeValue::now() - Start).usec());
+  }
+  llvm::sys::AtomicIncrement(&Readers);
+}
+
+void ASTUnit::ConcurrentQueryState::finishShared() {
+  llvm::sys::AtomicDecrement(&Readers);
+  AccessMutex->reader_release();
+}
+
+void ASTUnit::ConcurrentQueryState::startExclusive() {
+  llvm::sys::AtomicIncrement(&Exclusive.Acquisitions);
+  if (llvm::sys::AtomicIncrement(&Writers) == 1 &&
+      llvm::sys::AtomicAdd(&Readers, 0) == 0) {
+    AccessMutex->writer_acquire();
+  } else {
+    llvm::sys::TimeValue Start = llvm::sys::TimeValue::now();
+    AccessMutex->writer_acquire();
+    recordWait(Exclusive, (llvm::sys::TimeValue::now() - Start).usec());
+  }
+}
+
+void ASTUnit::ConcurrentQueryState::finishExclusive() {
+  llvm::sys::AtomicDecrement(&Writers);
+  AccessMutex->writer_release();
+}
+
+void ASTUnit::ConcurrentQueryState::lockLazyState() {
+  llvm::sys::AtomicIncrement(&LazyState.Acquisitions);
+  if (LazyStateMutex->tryacquire())
+    return;
+
+  llvm::sys::TimeValue Start = llvm::sys::TimeValue::now();
+  LazyStateMutex->acquire();
+  recordWait(LazyState, (llvm::sys::TimeValue::now() - Start).usec());
+}
+
+void ASTUnit::ConcurrentQueryState::unlockLazyState() {
+  LazyStateMutex->release();
+}
+
+/// \brief The innermost ReadOnlyCheck of each thread that has concurrent
+/// queries enabled; each check links to the one enclosing it.
+static llvm::ManagedStatic<llvm::sys::ThreadLocal<const ASTUnit::ReadOnlyCheck> >
+  ActiveReadOnlyChecks;
+
+ASTUnit::ReadOnlyCheck::ReadOnlyCheck(ASTUnit &Self)
+  : Self(Self), Outer(0), HoldsSharedLock(false) {
+  if (!Self.ConcurrentQueries) {
+    Self.ConcurrencyCheckValue.start();
+    ++Self.ReadOnlyCheckDepth;
+    return;
+  }
+
+  // Taking the shared lock again while this thread already holds it would
+  // deadlock as soon as another thread waits for exclusive access.
+  Outer = ActiveReadOnlyChecks->get();
+  HoldsSharedLock = true;
+  for (const ReadOnlyCheck *Check = Outer; Check; Check = Check->Outer)
+    if (&Check->Self == &Self) {
+      HoldsSharedLock = false;
+      break;
+    }
+
+  if (HoldsSharedLock)
+    Self.ConcurrentQueryLocks.startShared();
+  ActiveReadOnlyChecks->set(this);
+}
+
+ASTUnit::ReadOnlyCheck::~ReadOnlyCheck() {
+  if (!Self.ConcurrentQueries) {
+    --Self.ReadOnlyCheckDepth;
+    Self.ConcurrencyCheckValue.finish();
+    return;
+  }
+
+  ActiveReadOnlyChecks->set(Outer);
+  if (HoldsSharedLock)
+    Self.ConcurrentQueryLocks.finishShared();
+}
+
+void ASTUnit::ConcurrentQueryState::printLockStatistics(raw_ostream &OS,
+                                                       StringRef Name,
+                                                const LockStatistics &Stats) {
+  OS << "  " << Name << ": " << Stats.Acquisitions << " acquisitions, "
+     << Stats.Contended << " waited, " << Stats.WaitMicroseconds
+     << " us waiting\n";
+}
+
+void ASTUnit::ConcurrentQueryState::printStatistics(raw_ostream &OS) const {
+  printLockStatistics(OS, "shared access", Shared);
+  printLockStatistics(OS, "exclusive access", Exclusive);
+  printLockStatistics(OS, "lazy state", LazyState);
+}
+
+/// \brief Load or build everything within \p DC that read-only queries would
+/// otherwise load or build the first time they look at it.
+static void completeDeclContext(ASTContext &Ctx, DeclContext *DC) {
+  // Building the lookup table also pulls in the visible declarations that
+  // are stored in the preamble.
+  if (!DC->isTransparentContext() && !DC->isFunctionOrMethod())
+    DC->lookups_begin();
+
+  for (DeclContext::decl_iterator D = DC->decls_begin(),
+                               DEnd = DC->decls_end();
+       D != DEnd; ++D) {
+    // The types of declarations are created when they are first referenced.
+    if (TypeDecl *TD = dyn_cast<TypeDecl>(*D)) {
+      if (!isa<TemplateTypeParmDecl>(TD))
+        Ctx.getTypeDeclType(TD);
+    } else if (ObjCInterfaceDecl *ID = dyn_cast<ObjCInterfaceDecl>(*D)) {
+      Ctx.getObjCInterfaceType(ID);
+    } else if (ClassTemplateDecl *CTD = dyn_cast<ClassTemplateDecl>(*D)) {
+      for (ClassTemplateDecl::spec_iterator S = CTD->spec_begin(),
+                                         SEnd = CTD->spec_end();
+           S != SEnd; ++S)
+        S->getLinkage();
+    } else if (FunctionTemplateDecl *FTD = dyn_cast<FunctionTemplateDecl>(*D)) {
+      for (FunctionTemplateDecl::spec_iterator S = FTD->spec_begin(),
+                                            SEnd = FTD->spec_end();
+           S != SEnd; ++S)
+        S->getLinkage();
+    }
+
+    // Linkage is cached in bits that share a word with other Decl fields,
+    // so compute it while nothing else can look at the declaration.
+    if (NamedDecl *ND = dyn_cast<NamedDecl>(*D))
+      ND->getLinkage();
+
+    // Everything else below is only deserialized on demand.
+    if (CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(*D)) {
+      if (RD->hasDefinition()) {
+        RD->bases_begin();
+        RD->vbases_begin();
+      }
+    } else if (CXXConstructorDecl *Ctor = dyn_cast<CXXConstructorDecl>(*D)) {
+      Ctor->init_begin();
+    }
+    (*D)->getBody();
+
+    if (DeclContext *Inner = dyn_cast<DeclContext>(*D))
+      completeDeclContext(Ctx, Inner);
+  }
+}
+
+/// \brief Build the state that read-only queries would otherwise build on
+/// first use, so that they can run on several threads at once.
+///
+/// What this does not cover is either guarded by LazyStateGuard (the
+/// identifier table and the last range query of the preprocessing record) or
+/// by the SourceManager itself.
+void ASTUnit::prepareForConcurrentQueries() {
+  SimpleTimer Timer(WantTiming);
+  Timer.setOutput("Preparing concurrent queries for " + getMainFileName());
+
+  getSourceManager().enableConcurrentQueries();
+
+  // Macros and preprocessed entities from the preamble.
+  PP->macro_begin();
+  if (PreprocessingRecord *PPRec = PP->getPreprocessingRecord()) {
+    for (PreprocessingRecord::iterator E = PPRec->begin(),
+                                    EEnd = PPRec->end();
+         E != EEnd; ++E)
+      (void)*E;
+  }
+
+  if (!TopLevelDeclsInPreamble.empty())
+    RealizeTopLevelDeclsFromPreamble();
+  completeDeclContext(getASTContext(),
+                      getASTContext().getTranslationUnitDecl());
+}
@@ -32,6 +32,7 @@
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/Statistic.h"
@@ -44,11 +45,16 @@
 #include "llvm/Support/system_error.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Config/config.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
 
 using namespace clang;
 
 CompilerInstance::CompilerInstance()
-  : Invocation(new CompilerInvocation()), ModuleManager(0) {
+  : Invocation(new CompilerInvocation()), ModuleManager(0),
+    HaveConsideredModuleCachePruning(false), NumModuleCacheHits(0),
+    NumModuleCacheMisses(0), ModuleBuildTime(0) {
 }
 
 CompilerInstance::~CompilerInstance() {
@@ -228,6 +234,8 @@ void CompilerInstance::createFileManager() {
 
 void CompilerInstance::createSourceManager(FileManager &FileMgr) {
   SourceMgr = new SourceManager(getDiagnostics(), FileMgr);
+  if (unsigned Limit = getFrontendOpts().SourceLocationLimit)
+    SourceMgr->setLocalSLocSpaceLimit(Limit);
 }
 
 // Preprocessor
@@ -317,7 +325,8 @@ void CompilerInstance::createPCHExternalASTSource(StringRef Path,
                                           AllowPCHWithCompilerErrors,
                                           getPreprocessor(), getASTContext(),
                                           DeserializationListener,
-                                          Preamble));
+                                          Preamble,
+                                      getPreprocessorOpts().LazyPCHValidation));
   ModuleManager = static_cast<ASTReader*>(Source.get());
   getASTContext().setExternalSource(Source);
 }
@@ -331,7 +340,8 @@ CompilerInstance::createPCHExternalASTSource(StringRef Path,
                                              Preprocessor &PP,
                                              ASTContext &Context,
                                              void *DeserializationListener,
-                                             bool Preamble) {
+                                             bool Preamble,
+                                             bool LazyPCHValidation) {
   OwningPtr<ASTReader> Reader;
   Reader.reset(new ASTReader(PP, Context,
                              Sysroot.empty() ? "" : Sysroot.c_str(),
@@ -340,6 +350,7 @@ CompilerInstance::createPCHExternalASTSource(StringRef Path,
 
   Reader->setDeserializationListener(
             static_cast<ASTDeserializationListener *>(DeserializationListener));
+  Reader->setValidateInputFilesLazily(LazyPCHValidation);
   switch (Reader->ReadAST(Path,
                           Preamble ? serialization::MK_Preamble
                                    : serialization::MK_PCH)) {
@@ -620,9 +631,8 @@ bool CompilerInstance::InitializeSourceManager(StringRef InputFile,
     SourceMgr.overrideFileContents(File, SB.take());
   }
 
-  assert(!SourceMgr.getMainFileID().isInvalid() &&
-         "Couldn't establish MainFileID!");
-  return true;
+  // The source manager has reported why if it couldn't enter the file.
+  return !SourceMgr.getMainFileID().isInvalid();
 }
 
 // High-Level Operations
@@ -660,8 +670,10 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowTimers)
     createFrontendTimer();
 
-  if (getFrontendOpts().ShowStats)
+  if (getFrontendOpts().ShowStats) {
     llvm::EnableStatistics();
+    ASTContext::EnableAllocationStatistics();
+  }
 
   for (unsigned i = 0, e = getFrontendOpts().Inputs.size(); i != e; ++i) {
     // Reset the ID tables if we are reusing the SourceManager.
@@ -698,6 +710,14 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     OS << "\n";
   }
 
+  if (getFrontendOpts().ShowModuleCacheStats) {
+    OS << "*** Module Cache Stats:\n";
+    OS << "  " << NumModuleCacheHits << " module cache hits\n";
+    OS << "  " << NumModuleCacheMisses << " module cache misses\n";
+    OS << "  " << llvm::format("%.4f", ModuleBuildTime)
+       << " seconds spent building modules\n";
+  }
+
   return !getDiagnostics().getClient()->getNumErrors();
 }
 
@@ -733,6 +753,10 @@ static void doCompileMapModule(void *UserData) {
 static void compileModule(CompilerInstance &ImportingInstance,
                           Module *Module,
                           StringRef ModuleFileName) {
+  // Time spent on module builds and lock contention shows up in
+  // -ftime-report.
+  bool ShowTimers = ImportingInstance.getFrontendOpts().ShowTimers;
+
   llvm::LockFileManager Locked(ModuleFileName);
   switch (Locked) {
   case llvm::LockFileManager::LFS_Error:
@@ -742,12 +766,24 @@ static void compileModule(CompilerInstance &ImportingInstance,
     // We're responsible for building the module ourselves. Do so below.
     break;
 
-  case llvm::LockFileManager::LFS_Shared:
+  case llvm::LockFileManager::LFS_Shared: {
     // Someone else is responsible for building the module. Wait for them to
     // finish.
-    Locked.waitForUnlock();
+    {
+      llvm::NamedRegionTimer T("Waiting for another module build",
+                               "Clang module builds", ShowTimers);
+      Locked.waitForUnlock();
+    }
+
+    // If they succeeded, use their module file rather than building the same
+    // module again. Otherwise (e.g., the owner crashed or the lock timed
+    // out), fall back to building it ourselves.
+    bool Exists;
+    if (!llvm::sys::fs::exists(ModuleFileName, Exists) && Exists)
+      return;
     break;
   }
+  }
 
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
@@ -776,6 +812,7 @@ static void compileModule(CompilerInstance &ImportingInstance,
   FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
   FrontendOpts.OutputFile = ModuleFileName.str();
   FrontendOpts.DisableFree = false;
+  FrontendOpts.ShowModuleCacheStats = false;
   FrontendOpts.Inputs.clear();
   InputKind IK = getSourceInputKindFromOptions(*Invocation->getLangOpts());
 
@@ -830,7 +867,16 @@ static void compileModule(CompilerInstance &ImportingInstance,
   const unsigned ThreadStackSize = 8 << 20;
   llvm::CrashRecoveryContext CRC;
   CompileModuleMapData Data = { Instance, CreateModuleAction };
-  CRC.RunSafelyOnThread(&doCompileMapModule, &Data, ThreadStackSize);
+  {
+    // Modules imported while building this one are built by nested calls,
+    // whose time is already included here; only the outermost build runs
+    // the timer, which must not be started again while it is running.
+    bool IsOutermostBuild
+      = ImportingInstance.getPreprocessorOpts().ModuleBuildPath.empty();
+    llvm::NamedRegionTimer T("Building modules", "Clang module builds",
+                             ShowTimers && IsOutermostBuild);
+    CRC.RunSafelyOnThread(&doCompileMapModule, &Data, ThreadStackSize);
+  }
   
   // Delete the temporary module map file.
   // FIXME: Even though we're executing under crash protection, it would still
@@ -840,6 +886,114 @@ static void compileModule(CompilerInstance &ImportingInstance,
     llvm::sys::Path(TempModuleMapFileName).eraseFromDisk();
 }
 
+namespace {
+  /// \brief A module file in the module cache, as seen while pruning it.
+  struct CachedModuleFile {
+    std::string Path;
+    uint64_t Size;
+    time_t AccessTime;
+
+    bool operator<(const CachedModuleFile &Other) const {
+      return AccessTime < Other.AccessTime;
+    }
+  };
+}
+
+/// \brief Prune the module cache of module files that haven't been accessed in
+/// a long time, and of the least recently used module files if the cache is
+/// larger than its size limit.
+///
+/// This is done at most once per pruning interval, which is tracked by the
+/// modification time of a timestamp file at the root of the cache.
+static void pruneModuleCache(const HeaderSearchOptions &HSOpts) {
+  struct stat StatBuf;
+  SmallString<128> TimestampFile;
+  TimestampFile = HSOpts.ModuleCachePath;
+  llvm::sys::path::append(TimestampFile, "modules.timestamp");
+
+  // Try to stat() the timestamp file.
+  if (::stat(TimestampFile.c_str(), &StatBuf)) {
+    // If the timestamp file wasn't there, create one now.
+    if (errno == ENOENT) {
+      bool Existed;
+      llvm::sys::fs::create_directories(HSOpts.ModuleCachePath, Existed);
+      std::string ErrorInfo;
+      llvm::raw_fd_ostream Out(TimestampFile.c_str(), ErrorInfo,
+                               llvm::raw_fd_ostream::F_Binary);
+    }
+    return;
+  }
+
+  // Check whether the timestamp is older than our pruning interval. If not,
+  // do nothing.
+  time_t TimestampModTime = StatBuf.st_mtime;
+  time_t CurrentTime = time(0);
+  if (CurrentTime - TimestampModTime <= time_t(HSOpts.ModuleCachePruneInterval))
+    return;
+
+  // Write a new timestamp file so that nobody else attempts to prune. There
+  // is a benign race here if two instances notice at the same time that the
+  // timestamp is out of date.
+  {
+    std::string ErrorInfo;
+    llvm::raw_fd_ostream Out(TimestampFile.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+  }
+
+  // The module files that survive the age check, for the size check below.
+  std::vector<CachedModuleFile> Remaining;
+  uint64_t RemainingSize = 0;
+
+  // Walk each of the per-configuration directories in the module cache.
+  llvm::error_code EC;
+  SmallString<128> ModuleCachePathNative;
+  llvm::sys::path::native(HSOpts.ModuleCachePath, ModuleCachePathNative);
+  for (llvm::sys::fs::directory_iterator Dir(ModuleCachePathNative.str(), EC),
+         DirEnd;
+       Dir != DirEnd && !EC; Dir.increment(EC)) {
+    bool IsDirectory;
+    if (llvm::sys::fs::is_directory(Dir->path(), IsDirectory) || !IsDirectory)
+      continue;
+
+    for (llvm::sys::fs::directory_iterator File(Dir->path(), EC), FileEnd;
+         File != FileEnd && !EC; File.increment(EC)) {
+      // We only care about module files.
+      if (llvm::sys::path::extension(File->path()) != ".pcm")
+        continue;
+
+      if (::stat(File->path().c_str(), &StatBuf))
+        continue;
+
+      // If the file has been used recently enough, keep it.
+      if (CurrentTime - StatBuf.st_atime <=
+            time_t(HSOpts.ModuleCachePruneAfter)) {
+        CachedModuleFile Cached = { File->path(), uint64_t(StatBuf.st_size),
+                                    StatBuf.st_atime };
+        Remaining.push_back(Cached);
+        RemainingSize += StatBuf.st_size;
+        continue;
+      }
+
+      bool Existed;
+      llvm::sys::fs::remove(File->path(), Existed);
+    }
+  }
+
+  // If the cache is still over budget, evict the least recently used module
+  // files until it fits.
+  uint64_t MaxSize = uint64_t(HSOpts.ModuleCacheMaxSize) << 20;
+  if (!MaxSize || RemainingSize <= MaxSize)
+    return;
+
+  std::sort(Remaining.begin(), Remaining.end());
+  for (unsigned I = 0, N = Remaining.size();
+       I != N && RemainingSize > MaxSize; ++I) {
+    bool Existed;
+    if (!llvm::sys::fs::remove(Remaining[I].Path, Existed) && Existed)
+      RemainingSize -= Remaining[I].Size;
+  }
+}
+
 Module *CompilerInstance::loadModule(SourceLocation ImportLoc, 
                                      ModuleIdPath Path,
                                      Module::NameVisibilityKind Visibility,
@@ -888,10 +1042,24 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
       return 0;
     }
     
+    // Give the module cache a chance to shed stale module files before we
+    // look into it for the first time. Only the outermost compilation does
+    // this, so a module build never prunes files its importer relies on.
+    if (!HaveConsideredModuleCachePruning) {
+      HaveConsideredModuleCachePruning = true;
+      const HeaderSearchOptions &HSOpts = getHeaderSearchOpts();
+      if (!HSOpts.ModuleCachePath.empty() &&
+          HSOpts.ModuleCachePruneInterval > 0 &&
+          getPreprocessorOpts().ModuleBuildPath.empty())
+        pruneModuleCache(HSOpts);
+    }
+
     const FileEntry *ModuleFile
       = getFileManager().getFile(ModuleFileName, /*OpenFile=*/false,
                                  /*CacheFailure=*/false);
     bool BuildingModule = false;
+    if (ModuleFile)
+      ++NumModuleCacheHits;
     if (!ModuleFile && Module) {
       // The module is not cached, but we have a module map from which we can
       // build the module.
@@ -917,7 +1085,11 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
       getDiagnostics().Report(ModuleNameLoc, diag::warn_module_build)
         << ModuleName;
       BuildingModule = true;
+      ++NumModuleCacheMisses;
+      llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(true);
       compileModule(*this, Module, ModuleFileName);
+      llvm::TimeRecord End = llvm::TimeRecord::getCurrentTime(false);
+      ModuleBuildTime += End.getWallTime() - Start.getWallTime();
       ModuleFile = FileMgr->getFile(ModuleFileName);
     }
 
@@ -941,6 +1113,7 @@ Module *CompilerInstance::loadModule(SourceLocation ImportLoc,
                                     Sysroot.empty() ? "" : Sysroot.c_str(),
                                     PPOpts.DisablePCHValidation,
                                     PPOpts.DisableStatCache);
+      ModuleManager->setValidateInputFilesLazily(PPOpts.LazyPCHValidation);
       if (hasASTConsumer()) {
         ModuleManager->setDeserializationListener(
           getASTConsumer().GetASTDeserializationListener());
@@ -196,6 +196,8 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
       Res.push_back("-fno-limit-debug-info");
       break;
   }
+  if (Opts.HomeClassDebugInfo)
+    Res.push_back("-fhome-class-debug-info");
   if (Opts.DisableLLVMOpts)
     Res.push_back("-disable-llvm-optzns");
   if (Opts.DisableRedZone)
@@ -283,6 +285,8 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
   }
   if (Opts.BoundsChecking > 0)
     Res.push_back("-fbounds-checking=" + llvm::utostr(Opts.BoundsChecking));
+  if (Opts.ParallelCodeGen > 1)
+    Res.push_back("-fparallel-codegen=" + llvm::utostr(Opts.ParallelCodeGen));
   if (Opts.NumRegisterParameters)
     Res.push_back("-mregparm", llvm::utostr(Opts.NumRegisterParameters));
   if (Opts.NoGlobalMerge)
@@ -309,6 +313,8 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts, ToArgsList &Res) {
     Res.push_back("-disable-llvm-verifier");
   for (unsigned i = 0, e = Opts.BackendOptions.size(); i != e; ++i)
     Res.push_back("-backend-option", Opts.BackendOptions[i]);
+  for (unsigned i = 0, e = Opts.ParallelCodeGenOutputs.size(); i != e; ++i)
+    Res.push_back("-parallel-codegen-output", Opts.ParallelCodeGenOutputs[i]);
 
   switch (Opts.DefaultTLSModel) {
   case CodeGenOptions::GeneralDynamicTLSModel:
@@ -397,6 +403,11 @@ static void DiagnosticOptsToArgs(const DiagnosticOptions &Opts,
                         != DiagnosticOptions::DefaultConstexprBacktraceLimit)
     Res.push_back("-fconstexpr-backtrace-limit",
                   llvm::utostr(Opts.ConstexprBacktraceLimit));
+  if (Opts.FoldTemplateBacktrace)
+    Res.push_back("-ftemplate-backtrace-fold");
+  if (Opts.NoteByteLimit)
+    Res.push_back("-fdiagnostics-note-byte-limit",
+                  llvm::utostr(Opts.NoteByteLimit));
 
   if (Opts.TabStop != DiagnosticOptions::DefaultTabStop)
     Res.push_back("-ftabstop", llvm::utostr(Opts.TabStop));
@@ -463,6 +474,7 @@ static const char *getActionName(frontend::ActionKind Kind) {
   case frontend::RunAnalysis:            return "-analyze";
   case frontend::MigrateSource:          return "-migrate";
   case frontend::RunPreprocessorOnly:    return "-Eonly";
+  case frontend::ScanDependencies:       return "-scan-deps";
   }
 
   llvm_unreachable("Unexpected language kind!");
@@ -494,6 +506,11 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts, ToArgsList &Res) {
     Res.push_back("-help");
   if (Opts.ShowStats)
     Res.push_back("-print-stats");
+  if (Opts.SourceLocationLimit)
+    Res.push_back("-source-location-limit",
+                  llvm::utostr(Opts.SourceLocationLimit));
+  if (Opts.ShowModuleCacheStats)
+    Res.push_back("-fmodules-cache-stats");
   if (Opts.ShowTimers)
     Res.push_back("-ftime-report");
   if (Opts.ShowVersion)
@@ -659,6 +676,16 @@ static void HeaderSearchOptsToArgs(const HeaderSearchOptions &Opts,
     Res.push_back("-resource-dir", Opts.ResourceDir);
   if (!Opts.ModuleCachePath.empty())
     Res.push_back("-fmodule-cache-path", Opts.ModuleCachePath);
+  HeaderSearchOptions Defaults;
+  if (Opts.ModuleCachePruneInterval != Defaults.ModuleCachePruneInterval)
+    Res.push_back("-fmodules-prune-interval=" +
+                  llvm::utostr(Opts.ModuleCachePruneInterval));
+  if (Opts.ModuleCachePruneAfter != Defaults.ModuleCachePruneAfter)
+    Res.push_back("-fmodules-prune-after=" +
+                  llvm::utostr(Opts.ModuleCachePruneAfter));
+  if (Opts.ModuleCacheMaxSize)
+    Res.push_back("-fmodules-cache-max-size=" +
+                  llvm::utostr(Opts.ModuleCacheMaxSize));
   if (!Opts.UseStandardSystemIncludes)
     Res.push_back("-nostdsysteminc");
   if (!Opts.UseStandardCXXIncludes)
@@ -1227,6 +1254,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
     else
       Opts.DebugInfo = CodeGenOptions::FullDebugInfo;
   }
+  Opts.HomeClassDebugInfo = Args.hasArg(OPT_fhome_class_debug_info);
 
   Opts.DisableLLVMOpts = Args.hasArg(OPT_disable_llvm_optzns);
   Opts.DisableRedZone = Args.hasArg(OPT_disable_red_zone);
@@ -1265,6 +1293,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
                        Args.hasArg(OPT_cl_fast_relaxed_math));
   Opts.NoZeroInitializedInBSS = Args.hasArg(OPT_mno_zero_initialized_in_bss);
   Opts.BackendOptions = Args.getAllArgValues(OPT_backend_option);
+  Opts.ParallelCodeGenOutputs =
+    Args.getAllArgValues(OPT_parallel_codegen_output);
   Opts.NumRegisterParameters = Args.getLastArgIntValue(OPT_mregparm, 0, Diags);
   Opts.NoGlobalMerge = Args.hasArg(OPT_mno_global_merge);
   Opts.NoExecStack = Args.hasArg(OPT_mno_exec_stack);
@@ -1283,6 +1313,14 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.TrapFuncName = Args.getLastArgValue(OPT_ftrap_function_EQ);
   Opts.BoundsChecking = Args.getLastArgIntValue(OPT_fbounds_checking_EQ, 0,
                                                 Diags);
+  if (Arg *A = Args.getLastArg(OPT_fparallel_codegen_EQ)) {
+    StringRef Val = A->getValue(Args);
+    if (Val.getAsInteger(10, Opts.ParallelCodeGen)) {
+      Diags.Report(diag::err_drv_invalid_value)
+        << A->getAsString(Args) << Val;
+      Success = false;
+    }
+  }
   Opts.UseInitArray = Args.hasArg(OPT_fuse_init_array);
 
   Opts.FunctionSections = Args.hasArg(OPT_ffunction_sections);
@@ -1445,6 +1483,9 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
     = Args.getLastArgIntValue(OPT_fconstexpr_backtrace_limit,
                          DiagnosticOptions::DefaultConstexprBacktraceLimit,
                          Diags);
+  Opts.FoldTemplateBacktrace = Args.hasArg(OPT_ftemplate_backtrace_fold);
+  Opts.NoteByteLimit = Args.getLastArgIntValue(OPT_fdiagnostics_note_byte_limit,
+                                               0, Diags);
   Opts.TabStop = Args.getLastArgIntValue(OPT_ftabstop,
                                     DiagnosticOptions::DefaultTabStop, Diags);
   if (Opts.TabStop == 0 || Opts.TabStop > DiagnosticOptions::MaxTabStop) {
@@ -1533,6 +1574,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Opts.ProgramAction = frontend::MigrateSource; break;
     case OPT_Eonly:
       Opts.ProgramAction = frontend::RunPreprocessorOnly; break;
+    case OPT_scan_deps:
+      Opts.ProgramAction = frontend::ScanDependencies; break;
     }
   }
 
@@ -1572,6 +1615,9 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
+  Opts.SourceLocationLimit
+    = Args.getLastArgIntValue(OPT_source_location_limit, 0, Diags);
+  Opts.ShowModuleCacheStats = Args.hasArg(OPT_fmodules_cache_stats);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
   Opts.ShowVersion = Args.hasArg(OPT_version);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
@@ -1693,7 +1739,8 @@ std::string CompilerInvocation::GetResourcesPath(const char *Argv0,
   return P.str();
 }
 
-static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
+static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
+                                  DiagnosticsEngine &Diags) {
   using namespace options;
   Opts.Sysroot = Args.getLastArgValue(OPT_isysroot, "/");
   Opts.Verbose = Args.hasArg(OPT_v);
@@ -1705,6 +1752,14 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.ResourceDir = Args.getLastArgValue(OPT_resource_dir);
   Opts.ModuleCachePath = Args.getLastArgValue(OPT_fmodule_cache_path);
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
+  Opts.ModuleCachePruneInterval
+    = Args.getLastArgIntValue(OPT_fmodules_prune_interval,
+                              Opts.ModuleCachePruneInterval, Diags);
+  Opts.ModuleCachePruneAfter
+    = Args.getLastArgIntValue(OPT_fmodules_prune_after,
+                              Opts.ModuleCachePruneAfter, Diags);
+  Opts.ModuleCacheMaxSize
+    = Args.getLastArgIntValue(OPT_fmodules_cache_max_size, 0, Diags);
   
   // Add -I..., -F..., and -index-header-map options in order.
   bool IsIndexHeaderMap = false;
@@ -2179,6 +2234,7 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
   Opts.UsePredefines = !Args.hasArg(OPT_undef);
   Opts.DetailedRecord = Args.hasArg(OPT_detailed_preprocessing_record);
   Opts.DisablePCHValidation = Args.hasArg(OPT_fno_validate_pch);
+  Opts.LazyPCHValidation = Args.hasArg(OPT_fpch_validate_input_files_lazily);
 
   Opts.DumpDeserializedPCHDecls = Args.hasArg(OPT_dump_deserialized_pch_decls);
   for (arg_iterator it = Args.filtered_begin(OPT_error_on_deserialized_pch_decl),
@@ -2341,7 +2397,7 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
   InputKind DashX = ParseFrontendArgs(Res.getFrontendOpts(), *Args, Diags);
   Success = ParseCodeGenArgs(Res.getCodeGenOpts(), *Args, DashX, Diags)
             && Success;
-  ParseHeaderSearchArgs(Res.getHeaderSearchOpts(), *Args);
+  ParseHeaderSearchArgs(Res.getHeaderSearchOpts(), *Args, Diags);
   if (DashX != IK_AST && DashX != IK_LLVM_IR) {
     ParseLangArgs(*Res.getLangOpts(), *Args, DashX, Diags);
     if (Res.getFrontendOpts().ProgramAction == frontend::RewriteObjC)
@@ -378,6 +378,7 @@ void FrontendAction::EndSourceFile() {
     CI.getPreprocessor().getIdentifierTable().PrintStats();
     CI.getPreprocessor().getHeaderSearchInfo().PrintStats();
     CI.getSourceManager().PrintStats();
+    CI.getDiagnostics().PrintStats();
     llvm::errs() << "\n";
   }
 
@@ -419,7 +420,8 @@ void ASTFrontendAction::ExecuteAction() {
     CI.createSema(getTranslationUnitKind(), CompletionConsumer);
 
   ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
-           CI.getFrontendOpts().SkipFunctionBodies);
+           CI.getFrontendOpts().SkipFunctionBodies,
+           CI.getFrontendOpts().LazyFunctionBodies);
 }
 
 void PluginASTAction::anchor() { }
@@ -17,6 +17,7 @@
 
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/SourceLocation.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 
 using namespace clang;
@@ -250,6 +251,14 @@ void MultiplexConsumer::HandleVTable(
     Consumers[i]->HandleVTable(RD, DefinitionRequired);
 }
 
+bool MultiplexConsumer::shouldParseFunctionBodyLazily(FunctionDecl *FD,
+                                                      SourceRange BodyRange) {
+  bool Lazy = true;
+  for (size_t i = 0, e = Consumers.size(); i != e; ++i)
+    Lazy = Consumers[i]->shouldParseFunctionBodyLazily(FD, BodyRange) && Lazy;
+  return Lazy;
+}
+
 ASTMutationListener *MultiplexConsumer::GetASTMutationListener() {
   return MutationListener.get();
 }
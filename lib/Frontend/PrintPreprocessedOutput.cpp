@@ -28,6 +28,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 using namespace clang;
 
 /// PrintMacroDefinition - Print a macro definition in a form that will be
@@ -500,6 +501,17 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
   Token PrevPrevTok, PrevTok;
   PrevPrevTok.startToken();
   PrevTok.startToken();
+
+  // The length of the spelling of each punctuator, or 0 for token kinds
+  // whose spelling varies. A punctuator token of exactly that length was
+  // spelled the usual way (not as a digraph, and without escaped newlines),
+  // so it can be printed without going back to the source buffer.
+  unsigned char SimpleSpellingLength[tok::NUM_TOKENS];
+  for (unsigned K = 0; K != tok::NUM_TOKENS; ++K) {
+    const char *Spelling = tok::getTokenSimpleSpelling(tok::TokenKind(K));
+    SimpleSpellingLength[K] = Spelling ? strlen(Spelling) : 0;
+  }
+
   while (1) {
     if (Callbacks->hasEmittedDirectiveOnThisLine()) {
       Callbacks->startNewLineIfNeeded();
@@ -523,6 +535,9 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
     } else if (Tok.isLiteral() && !Tok.needsCleaning() &&
                Tok.getLiteralData()) {
       OS.write(Tok.getLiteralData(), Tok.getLength());
+    } else if (SimpleSpellingLength[Tok.getKind()] == Tok.getLength() &&
+               Tok.getLength() != 0) {
+      OS.write(tok::getTokenSimpleSpelling(Tok.getKind()), Tok.getLength());
     } else if (Tok.getLength() < 256) {
       const char *TokPtr = Buffer;
       unsigned Len = PP.getSpelling(Tok, TokPtr);
@@ -28,7 +28,8 @@ TextDiagnosticPrinter::TextDiagnosticPrinter(raw_ostream &os,
                                              const DiagnosticOptions &diags,
                                              bool _OwnsOutputStream)
   : OS(os), DiagOpts(&diags),
-    OwnsOutputStream(_OwnsOutputStream) {
+    OwnsOutputStream(_OwnsOutputStream), DroppingNotes(false),
+    BytesPrintedForDiag(0) {
 }
 
 TextDiagnosticPrinter::~TextDiagnosticPrinter() {
@@ -110,6 +111,28 @@ void TextDiagnosticPrinter::HandleDiagnostic(DiagnosticsEngine::Level Level,
   // Default implementation (Warnings/errors count).
   DiagnosticConsumer::HandleDiagnostic(Level, Info);
 
+  // Once a diagnostic and its notes have taken up the allowed number of bytes,
+  // drop the rest of its notes, such as a very deep instantiation backtrace.
+  if (Level != DiagnosticsEngine::Note) {
+    DroppingNotes = false;
+    BytesPrintedForDiag = 0;
+  } else if (DroppingNotes) {
+    return;
+  } else if (DiagOpts->NoteByteLimit &&
+             BytesPrintedForDiag >= DiagOpts->NoteByteLimit) {
+    DroppingNotes = true;
+    uint64_t StartOfNote = OS.tell();
+    if (!Prefix.empty())
+      OS << Prefix << ": ";
+    TextDiagnostic::printDiagnosticLevel(OS, Level, DiagOpts->ShowColors);
+    TextDiagnostic::printDiagnosticMessage(OS, Level,
+      "(dropping remaining notes; use -fdiagnostics-note-byte-limit=0 to see "
+      "all)", OS.tell() - StartOfNote, DiagOpts->MessageLength,
+      DiagOpts->ShowColors);
+    OS.flush();
+    return;
+  }
+
   // Render the diagnostic message into a temporary buffer eagerly. We'll use
   // this later as we print out the diagnostic to the terminal.
   SmallString<100> OutStr;
@@ -137,6 +160,7 @@ void TextDiagnosticPrinter::HandleDiagnostic(DiagnosticsEngine::Level Level,
                                            OS.tell() - StartOfLocationInfo,
                                            DiagOpts->MessageLength,
                                            DiagOpts->ShowColors);
+    BytesPrintedForDiag += OS.tell() - StartOfLocationInfo;
     OS.flush();
     return;
   }
@@ -153,6 +177,7 @@ void TextDiagnosticPrinter::HandleDiagnostic(DiagnosticsEngine::Level Level,
                                               Info.getNumFixItHints()),
                            &Info.getSourceManager());
 
+  BytesPrintedForDiag += OS.tell() - StartOfLocationInfo;
   OS.flush();
 }
 
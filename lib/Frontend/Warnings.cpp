@@ -63,6 +63,7 @@ void clang::ProcessWarningOptions(DiagnosticsEngine &Diags,
     Diags.setErrorLimit(Opts.ErrorLimit);
   if (Opts.TemplateBacktraceLimit)
     Diags.setTemplateBacktraceLimit(Opts.TemplateBacktraceLimit);
+  Diags.setFoldTemplateBacktrace(Opts.FoldTemplateBacktrace);
   if (Opts.ConstexprBacktraceLimit)
     Diags.setConstexprBacktraceLimit(Opts.ConstexprBacktraceLimit);
 
@@ -1421,6 +1421,8 @@ bool ModuleMapParser::parseModuleMapFile() {
 bool ModuleMap::parseModuleMapFile(const FileEntry *File) {
   assert(Target != 0 && "Missing target information");
   FileID ID = SourceMgr->createFileID(File, SourceLocation(), SrcMgr::C_User);
+  if (ID.isInvalid())
+    return true;
   const llvm::MemoryBuffer *Buffer = SourceMgr->getBuffer(ID);
   if (!Buffer)
     return true;
@@ -419,6 +419,38 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
   }
 }
 
+void Preprocessor::SkipToNextDirective() {
+  if (!CurLexer || CurTokenLexer)
+    return;
+
+  // Enter raw mode to disable identifier lookup (and thus macro expansion),
+  // disabling warnings, etc.
+  CurPPLexer->LexingRawMode = true;
+  Token Tok;
+  while (1) {
+    // Remember where this token starts, so that we can give a directive back
+    // to the lexer to be handled normally.
+    const char *TokStart = CurLexer->BufferPtr;
+    bool WasAtStartOfLine = CurLexer->IsAtStartOfLine;
+    MultipleIncludeOpt SavedMIOpt = CurPPLexer->MIOpt;
+
+    CurLexer->Lex(Tok);
+
+    // Leave the end of the file for the lexer to handle normally, so that
+    // unterminated conditionals are diagnosed and the include stack popped.
+    if (Tok.is(tok::eof))
+      break;
+
+    if (Tok.is(tok::hash) && Tok.isAtStartOfLine()) {
+      CurLexer->BufferPtr = TokStart;
+      CurLexer->IsAtStartOfLine = WasAtStartOfLine;
+      CurPPLexer->MIOpt = SavedMIOpt;
+      break;
+    }
+  }
+  CurPPLexer->LexingRawMode = false;
+}
+
 void Preprocessor::PTHSkipExcludedConditionalBlock() {
 
   while (1) {
@@ -1511,7 +1543,8 @@ void Preprocessor::HandleIncludeDirective(SourceLocation HashLoc,
   if (IncludePos.isMacroID())
     IncludePos = SourceMgr.getExpansionRange(IncludePos).second;
   FileID FID = SourceMgr.createFileID(File, IncludePos, FileCharacter);
-  assert(!FID.isInvalid() && "Expected valid file ID");
+  if (FID.isInvalid())
+    return;
 
   // Finally, if all is good, enter the new file!
   EnterSourceFile(FID, CurDir, FilenameTok.getLocation());
@@ -71,6 +71,9 @@ PreprocessorLexer *Preprocessor::getCurrentFileLexer() const {
 void Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
                                    SourceLocation Loc) {
   assert(CurTokenLexer == 0 && "Cannot #include a file inside a macro!");
+  // The source manager has reported why it couldn't create the FileID.
+  if (FID.isInvalid())
+    return;
   ++NumEnteredSourceFiles;
 
   if (MaxIncludeStackDepth < IncludeMacroStack.size())
@@ -254,6 +254,11 @@ void Preprocessor::Handle_Pragma(Token &Tok) {
   CreateString(&StrVal[0], StrVal.size(), TmpTok);
   SourceLocation TokLoc = TmpTok.getLocation();
 
+  // If the source locations have run out, there is nothing to lex the
+  // pragma from; the fatal error has been reported already.
+  if (TokLoc.isInvalid())
+    return Lex(Tok);
+
   // Make and enter a lexer object so that we lex and expand the tokens just
   // like any others.
   Lexer *TL = Lexer::Create_PragmaLexer(TokLoc, PragmaLoc, RParenLoc,
@@ -442,10 +442,10 @@ void Preprocessor::EnterMainSourceFile() {
     llvm::MemoryBuffer::getMemBufferCopy(Predefines, "<built-in>");
   assert(SB && "Cannot create predefined source buffer");
   FileID FID = SourceMgr.createFileIDForMemBuffer(SB);
-  assert(!FID.isInvalid() && "Could not create FileID for predefines?");
 
-  // Start parsing the predefines.
-  EnterSourceFile(FID, 0, SourceLocation());
+  // Start parsing the predefines, unless the source locations have run out.
+  if (!FID.isInvalid())
+    EnterSourceFile(FID, 0, SourceLocation());
 }
 
 void Preprocessor::EndSourceFile() {
@@ -53,10 +53,15 @@ SourceLocation ScratchBuffer::getToken(const char *Buf, unsigned Len,
   // diagnostic points to one.
   CurBuffer[BytesUsed-1] = '\0';
 
+  // Without a location for the buffer, don't make one up by offsetting.
+  if (BufferStartLoc.isInvalid())
+    return SourceLocation();
   return BufferStartLoc.getLocWithOffset(BytesUsed-Len-1);
 }
 
 void ScratchBuffer::AllocScratchBuffer(unsigned RequestLen) {
+  bool FitsInChunk = RequestLen + 1 <= ScratchBufSize;
+
   // Only pay attention to the requested length if it is larger than our default
   // page size.  If it is, we allocate an entire chunk for it.  This is to
   // support gigantic tokens, which almost certainly won't happen. :)
@@ -66,7 +71,18 @@ void ScratchBuffer::AllocScratchBuffer(unsigned RequestLen) {
   llvm::MemoryBuffer *Buf =
     llvm::MemoryBuffer::getNewMemBuffer(RequestLen, "<scratch space>");
   FileID FID = SourceMgr.createFileIDForMemBuffer(Buf);
-  BufferStartLoc = SourceMgr.getLocForStartOfFile(FID);
+  if (FID.isInvalid()) {
+    // The source locations have run out, which is a fatal error. Start over
+    // in the current buffer if the token fits, so it still gets a valid
+    // location; the tokens it held before are only needed for diagnostics.
+    if (CurBuffer && FitsInChunk) {
+      BytesUsed = 1;
+      return;
+    }
+    BufferStartLoc = SourceLocation();
+  } else {
+    BufferStartLoc = SourceMgr.getLocForStartOfFile(FID);
+  }
   CurBuffer = const_cast<char*>(Buf->getBufferStart());
   BytesUsed = 1;
   CurBuffer[0] = '0';  // Start out with a \0 for cleanliness.
@@ -41,7 +41,8 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
                      ASTContext &Ctx, bool PrintStats,
                      TranslationUnitKind TUKind,
                      CodeCompleteConsumer *CompletionConsumer,
-                     bool SkipFunctionBodies) {
+                     bool SkipFunctionBodies,
+                     bool LazyFunctionBodies) {
 
   OwningPtr<Sema> S(new Sema(PP, Ctx, *Consumer,
                                    TUKind,
@@ -50,10 +51,11 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<Sema> CleanupSema(S.get());
   
-  ParseAST(*S.get(), PrintStats, SkipFunctionBodies);
+  ParseAST(*S.get(), PrintStats, SkipFunctionBodies, LazyFunctionBodies);
 }
 
-void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
+void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies,
+                     bool LazyFunctionBodies) {
   // Collect global stats on Decls/Stmts (until we have a module streamer).
   if (PrintStats) {
     Decl::EnableStatistics();
@@ -66,8 +68,15 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
 
   ASTConsumer *Consumer = &S.getASTConsumer();
 
+  // What Sema creates on its own, such as the implicit declarations made by
+  // Initialize(), is attributed to Sema; the declarations and statements of
+  // the parsed source are attributed to the parser below.
+  ASTContext::AllocationOwnerRAII SemaOwner(S.getASTContext(),
+                                            ASTContext::AO_Sema);
+
   OwningPtr<Parser> ParseOP(new Parser(S.getPreprocessor(), S,
-                                       SkipFunctionBodies));
+                                       SkipFunctionBodies,
+                                       LazyFunctionBodies));
   Parser &P = *ParseOP.get();
 
   PrettyStackTraceParserEntry CrashInfo(P);
@@ -89,17 +98,29 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   if (External)
     External->StartTranslationUnit(Consumer);
 
-  if (P.ParseTopLevelDecl(ADecl)) {
-    if (!External && !S.getLangOpts().CPlusPlus)
-      P.Diag(diag::ext_empty_translation_unit);
-  } else {
-    do {
-      // If we got a null return and something *was* parsed, ignore it.  This
-      // is due to a top-level semicolon, an action override, or a parse error
-      // skipping something.
-      if (ADecl && !Consumer->HandleTopLevelDecl(ADecl.get()))
-	return;
-    } while (!P.ParseTopLevelDecl(ADecl));
+  {
+    ASTContext::AllocationOwnerRAII ParseOwner(S.getASTContext(),
+                                               ASTContext::AO_Parse);
+    if (P.ParseTopLevelDecl(ADecl)) {
+      if (!External && !S.getLangOpts().CPlusPlus)
+        P.Diag(diag::ext_empty_translation_unit);
+    } else {
+      do {
+        // If we got a null return and something *was* parsed, ignore it.
+        // This is due to a top-level semicolon, an action override, or a
+        // parse error skipping something.
+        if (ADecl && !Consumer->HandleTopLevelDecl(ADecl.get()))
+          return;
+      } while (!P.ParseTopLevelDecl(ADecl));
+    }
+  }
+
+  // Function bodies cached in lazy mode are parsed on demand, which needs the
+  // parser; hand it over to Sema, which keeps it alive as long as the AST.
+  if (P.hasLazyFunctionBodies()) {
+    CleanupParser.unregister();
+    S.SetLazyBodyParser(&Parser::LazyBodyParserCallback,
+                        &Parser::LazyBodyParserCleanup, ParseOP.take());
   }
 
   // Process any TopLevelDecls generated by #pragma weak.
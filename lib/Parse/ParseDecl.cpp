@@ -1403,6 +1403,11 @@ Parser::DeclGroupPtrTy Parser::ParseDeclGroup(ParsingDeclSpec &DS,
     return DeclGroupPtrTy();
   }
 
+  // Parse the lazy bodies the declaration may change the meaning of before
+  // Sema sees it.
+  if (Context == Declarator::FileContext)
+    ParsePendingLazyBodies(D);
+
   // Save late-parsed attributes for now; they need to be parsed in the
   // appropriate function scope after the function Decl has been constructed.
   LateParsedAttrList LateParsedAttrs;
@@ -1501,6 +1506,8 @@ Parser::DeclGroupPtrTy Parser::ParseDeclGroup(ParsingDeclSpec &DS,
 
     ParseDeclarator(D);
     if (!D.isInvalidType()) {
+      if (Context == Declarator::FileContext)
+        ParsePendingLazyBodies(D);
       Decl *ThisDecl = ParseDeclarationAfterDeclarator(D);
       D.complete(ThisDecl);
       if (ThisDecl)
@@ -2920,6 +2927,8 @@ void Parser::ParseStructUnionBody(SourceLocation RecordLoc,
   PrettyDeclStackTraceEntry CrashInfo(Actions, TagDecl, RecordLoc,
                                       "parsing struct/union body");
 
+  ParsePendingLazyBodiesBeforeDefinition(TagDecl);
+
   BalancedDelimiterTracker T(*this, tok::l_brace);
   if (T.consumeOpen())
     return;
@@ -3310,6 +3319,8 @@ void Parser::ParseEnumSpecifier(SourceLocation StartLoc, DeclSpec &DS,
     return;
   }
 
+  ParsePendingLazyBodiesBeforeTag(Name, TUK, SS.isSet());
+
   bool Owned = false;
   bool IsDependent = false;
   const char *PrevSpec = 0;
@@ -3377,6 +3388,8 @@ void Parser::ParseEnumSpecifier(SourceLocation StartLoc, DeclSpec &DS,
 ///         identifier
 ///
 void Parser::ParseEnumBody(SourceLocation StartLoc, Decl *EnumDecl) {
+  ParsePendingLazyBodiesBeforeDefinition(EnumDecl);
+
   // Enter the scope of the enum body and start the definition.
   ParseScope EnumScope(this, Scope::DeclScope);
   Actions.ActOnTagStartDefinition(getCurScope(), EnumDecl);
@@ -3395,6 +3408,7 @@ void Parser::ParseEnumBody(SourceLocation StartLoc, Decl *EnumDecl) {
   // Parse the enumerator-list.
   while (Tok.is(tok::identifier)) {
     IdentifierInfo *Ident = Tok.getIdentifierInfo();
+    ParsePendingLazyBodies(Ident);
     SourceLocation IdentLoc = ConsumeToken();
 
     // If attributes exist after the enumerator, parse them.
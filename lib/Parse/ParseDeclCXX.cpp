@@ -79,6 +79,11 @@ Decl *Parser::ParseNamespace(unsigned Context,
     }
   }
 
+  // The name of a namespace or of a namespace alias. The members of a
+  // namespace are checked as they are declared.
+  if (Ident)
+    ParsePendingLazyBodies(Ident);
+
   // Read label attributes, if present.
   ParsedAttributes attrs(AttrFactory);
   if (Tok.is(tok::kw___attribute)) {
@@ -329,6 +334,13 @@ Decl *Parser::ParseUsingDirectiveOrDeclaration(unsigned Context,
                                              ParsedAttributesWithRange &attrs,
                                                Decl **OwnedType) {
   assert(Tok.is(tok::kw_using) && "Not using token");
+
+  // A using-directive changes the meaning of the names it makes visible,
+  // whichever those are. Treat the rarer using-declarations and
+  // alias-declarations the same.
+  if (Context == Declarator::FileContext)
+    ParsePendingLazyBodies(0);
+
   ObjCDeclContextSwitch ObjCDC(*this);
   
   // Eat 'using'.
@@ -1274,6 +1286,9 @@ void Parser::ParseClassSpecifier(tok::TokenKind TagTokKind,
     return;
   }
 
+  ParsePendingLazyBodiesBeforeTag(TemplateId ? TemplateId->Name : Name, TUK,
+                                  SS.isSet());
+
   // Create the tag portion of the class or class template.
   DeclResult TagOrTempResult = true; // invalid
   TypeResult TypeResult = true; // invalid
@@ -1906,6 +1921,10 @@ void Parser::ParseCXXClassMemberDeclaration(AccessSpecifier AS,
       return;
     }
 
+    // A friend may redeclare a function of the enclosing namespace.
+    if (DS.isFriendSpecified())
+      ParsePendingLazyBodies(DeclaratorInfo);
+
     ParseOptionalCXX0XVirtSpecifierSeq(VS);
 
     // If attributes exist after the declarator, but before an '{', parse them.
@@ -2248,6 +2267,8 @@ void Parser::ParseCXXMemberSpecification(SourceLocation RecordLoc,
   PrettyDeclStackTraceEntry CrashInfo(Actions, TagDecl, RecordLoc,
                                       "parsing struct/union/class body");
 
+  ParsePendingLazyBodiesBeforeDefinition(TagDecl);
+
   // Determine whether this is a non-nested class. Note that local
   // classes are *not* considered to be nested classes.
   bool NonNestedClass = true;
@@ -14,6 +14,9 @@
 
 #include "clang/Parse/Parser.h"
 #include "RAIIObjectsForParser.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Scope.h"
@@ -1922,6 +1925,47 @@ Decl *Parser::ParseFunctionStatementBody(Decl *Decl, ParseScope &BodyScope) {
     return Actions.ActOnFinishFunctionBody(Decl, 0);
   }
 
+  // In lazy-body mode, cache the tokens of the body and finish the function
+  // without one; ParseLazyFunctionBody() replays them on demand.
+  Sema::FunctionBodyUsesRAII RecordUses(Actions);
+  if (LazyFunctionBodies && canParseFunctionBodyLazily(Decl)) {
+    FunctionDecl *FD = cast<FunctionDecl>(Decl);
+    LazyParsedFunctionBody *LB = new LazyParsedFunctionBody(FD);
+    LB->FPFeatures = Actions.FPFeatures;
+    LB->OpenCLFeatures = Actions.OpenCLFeatures;
+    LB->Toks.push_back(Tok);
+    ConsumeBrace();
+    ConsumeAndStoreUntil(tok::r_brace, LB->Toks, /*StopAtSemi=*/false);
+
+    // A body cut off by the end of the file is parsed now, so that the
+    // error is reported.
+    SourceRange BodyRange(LBraceLoc, LB->Toks.back().getLocation());
+    if (LB->Toks.back().is(tok::r_brace) &&
+        !callsUndeclaredFunction(LB->Toks) &&
+        Actions.getASTConsumer().shouldParseFunctionBodyLazily(FD,
+                                                               BodyRange)) {
+      BodyScope.Exit();
+      Decl = Actions.ActOnFinishFunctionBody(Decl, 0);
+
+      assert(!LazyParsedBodyMap.count(FD) && "Function body cached twice");
+      LazyParsedBodyMap[FD] = LB;
+      FD->setHasUnparsedCachedBody();
+      addPendingLazyBody(LB);
+      return Decl;
+    }
+
+    // The consumer wants this body parsed now after all, e.g. because its
+    // text changed since an earlier parse. Replay the cached tokens in place,
+    // recording what the body uses so that a later parse can leave it lazy.
+    RecordUses.record(FD);
+    LB->Toks.push_back(Tok);
+    Token *Buffer = new Token[LB->Toks.size()];
+    std::copy(LB->Toks.begin(), LB->Toks.end(), Buffer);
+    PP.EnterTokenStream(Buffer, LB->Toks.size(), true, /*OwnsTokens=*/true);
+    delete LB;
+    ConsumeAnyToken();
+  }
+
   PrettyDeclStackTraceEntry CrashInfo(Actions, Decl, LBraceLoc,
                                       "parsing function body");
 
@@ -1997,6 +2041,285 @@ bool Parser::trySkippingFunctionBody() {
   return false;
 }
 
+bool Parser::canParseFunctionBodyLazily(Decl *D) {
+  FunctionDecl *FD = dyn_cast_or_null<FunctionDecl>(D);
+  if (!FD || PP.isCodeCompletionEnabled())
+    return false;
+
+  // Constant evaluation needs the bodies of constexpr functions, and template
+  // instantiation needs the bodies of patterns.
+  if (FD->isConstexpr() || FD->isDependentContext() ||
+      FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate)
+    return false;
+
+  // Cached bodies are replayed inside their enclosing namespaces and classes
+  // only, so anything nested in a function or an Objective-C container is
+  // parsed right away.
+  for (DeclContext *DC = FD->getLexicalParent(); DC;
+       DC = DC->getLexicalParent())
+    if (DC->isFunctionOrMethod() || isa<ObjCContainerDecl>(DC))
+      return false;
+
+  // The #pragma pack, ms_struct and visibility state changes the classes
+  // declared in a body, and is not kept for the replay. Sema keeps the pack
+  // stack once it was used, so this is conservative.
+  if (Actions.PackContext || Actions.MSStructPragmaOn || Actions.VisContext)
+    return false;
+
+  return true;
+}
+
+/// \brief Determine whether the cached body \p Toks may call a function that
+/// is not declared at this point.
+///
+/// Such a call implicitly declares the function in C, which has to happen at
+/// the body's position in the translation unit, so the body is parsed in
+/// place. Any identifier followed by '(' that names no visible declaration
+/// counts, even the name of a member or of a local variable.
+bool Parser::callsUndeclaredFunction(const CachedTokens &Toks) {
+  if (getLangOpts().CPlusPlus)
+    return false;
+
+  for (unsigned I = 0, N = Toks.size(); I + 1 < N; ++I) {
+    if (Toks[I].isNot(tok::identifier) || Toks[I + 1].isNot(tok::l_paren))
+      continue;
+
+    // A builtin other than a library function is declared the same wherever
+    // it is first used.
+    IdentifierInfo *II = Toks[I].getIdentifierInfo();
+    if (unsigned ID = II->getBuiltinID())
+      if (!Actions.Context.BuiltinInfo.isPredefinedLibFunction(ID))
+        continue;
+
+    if (!isDeclaredName(II, Decl::IDNS_Ordinary))
+      return true;
+  }
+  return false;
+}
+
+/// \brief Start tracking the cached body \p LB until it is parsed or the
+/// translation unit ends.
+void Parser::addPendingLazyBody(LazyParsedFunctionBody *LB) {
+  for (CachedTokens::iterator T = LB->Toks.begin(), TEnd = LB->Toks.end();
+       T != TEnd; ++T)
+    if (T->is(tok::identifier))
+      LB->Names.push_back(T->getIdentifierInfo());
+  std::sort(LB->Names.begin(), LB->Names.end());
+  LB->Names.erase(std::unique(LB->Names.begin(), LB->Names.end()),
+                  LB->Names.end());
+
+  for (SmallVectorImpl<IdentifierInfo*>::iterator N = LB->Names.begin(),
+                                                  NEnd = LB->Names.end();
+       N != NEnd; ++N)
+    ++PendingLazyBodyNames[*N];
+  PendingLazyBodies.push_back(LB);
+}
+
+/// \brief Determine whether a declaration of \p II in the identifier
+/// namespace \p IDNS is in scope.
+bool Parser::isDeclaredName(IdentifierInfo *II, unsigned IDNS) {
+  for (IdentifierResolver::iterator D = Actions.IdResolver.begin(II),
+                                    DEnd = Actions.IdResolver.end();
+       D != DEnd; ++D)
+    if ((*D)->isInIdentifierNamespace(IDNS))
+      return true;
+  return false;
+}
+
+/// \brief Parse the cached bodies that mention \p Name, or all of them if
+/// \p Name is null, in the order they were cached, before the parser hands
+/// Sema a declaration of \p Name.
+void Parser::ParsePendingLazyBodies(IdentifierInfo *Name) {
+  if (PendingLazyBodies.empty() ||
+      (Name && !PendingLazyBodyNames.count(Name)))
+    return;
+
+  // Declarations within a function are not visible to the other bodies. A C
+  // prototype has its own scope, and C lookup would find its parameters.
+  // While the parser may backtrack, it would cache the replayed tokens.
+  if (PP.isBacktrackEnabled())
+    return;
+  for (Scope *S = getCurScope(); S; S = S->getParent())
+    if ((S->getFlags() & Scope::FnScope) ||
+        (!getLangOpts().CPlusPlus && S->isFunctionPrototypeScope()))
+      return;
+
+  SmallVector<LazyParsedFunctionBody*, 4> ToParse;
+  SmallVector<LazyParsedFunctionBody*, 16> Remaining;
+  for (SmallVectorImpl<LazyParsedFunctionBody*>::iterator
+         B = PendingLazyBodies.begin(), BEnd = PendingLazyBodies.end();
+       B != BEnd; ++B) {
+    LazyParsedFunctionBody *LB = *B;
+    if (Name &&
+        !std::binary_search(LB->Names.begin(), LB->Names.end(), Name)) {
+      Remaining.push_back(LB);
+      continue;
+    }
+
+    for (SmallVectorImpl<IdentifierInfo*>::iterator N = LB->Names.begin(),
+                                                    NEnd = LB->Names.end();
+         N != NEnd; ++N) {
+      llvm::DenseMap<IdentifierInfo*, unsigned>::iterator Count
+        = PendingLazyBodyNames.find(*N);
+      if (--Count->second == 0)
+        PendingLazyBodyNames.erase(Count);
+    }
+    LB->Names.clear();
+    ToParse.push_back(LB);
+  }
+  PendingLazyBodies.swap(Remaining);
+
+  for (unsigned I = 0, N = ToParse.size(); I != N; ++I)
+    ParseLazyFunctionBody(ToParse[I]->D);
+}
+
+/// \brief Parse the cached bodies before the parser hands Sema the
+/// declarator \p D.
+void Parser::ParsePendingLazyBodies(Declarator &D) {
+  if (PendingLazyBodies.empty())
+    return;
+
+  // An operator, a conversion or a constructor may change the meaning of a
+  // body without being named in it.
+  if (D.getName().getKind() != UnqualifiedId::IK_Identifier)
+    ParsePendingLazyBodies(0);
+  else if (IdentifierInfo *II = D.getIdentifier())
+    ParsePendingLazyBodies(II);
+}
+
+/// \brief Parse the cached bodies before the parser hands Sema the use
+/// \p TUK of the tag \p Name.
+void Parser::ParsePendingLazyBodiesBeforeTag(IdentifierInfo *Name,
+                                             Sema::TagUseKind TUK,
+                                             bool IsQualified) {
+  // A qualified name refers to a tag declared before, and a reference to a
+  // tag in scope declares nothing. Their definitions are handled by
+  // ParsePendingLazyBodiesBeforeDefinition().
+  if (!Name || IsQualified || PendingLazyBodies.empty() ||
+      (TUK == Sema::TUK_Reference && isDeclaredName(Name, Decl::IDNS_Tag)))
+    return;
+  ParsePendingLazyBodies(Name);
+}
+
+/// \brief Parse all the cached bodies before the definition of the tag
+/// \p TagOrTemplate starts, if a body may use its type without naming it:
+/// through a typedef of a tag declared before, or through the members of an
+/// anonymous union, which are declared in the enclosing scope.
+void Parser::ParsePendingLazyBodiesBeforeDefinition(Decl *TagOrTemplate) {
+  if (PendingLazyBodies.empty() || !TagOrTemplate)
+    return;
+
+  TagDecl *Tag = dyn_cast<TagDecl>(TagOrTemplate);
+  if (ClassTemplateDecl *Template = dyn_cast<ClassTemplateDecl>(TagOrTemplate))
+    Tag = Template->getTemplatedDecl();
+  if (!Tag)
+    return;
+
+  if (TagOrTemplate->getPreviousDecl() || Tag->getPreviousDecl() ||
+      isa<ClassTemplateSpecializationDecl>(Tag) ||
+      (Tag->isUnion() && !Tag->getDeclName()))
+    ParsePendingLazyBodies(0);
+}
+
+void Parser::LazyBodyParserCallback(void *P, FunctionDecl *FD) {
+  ((Parser*)P)->ParseLazyFunctionBody(FD);
+}
+
+void Parser::LazyBodyParserCleanup(void *P) {
+  delete (Parser*)P;
+}
+
+/// \brief Parse a function body that was cached in lazy-body mode.
+///
+/// Like a late-parsed template, the body is parsed in its original scope:
+/// the enclosing namespaces and classes are reentered from the translation
+/// unit scope, whatever scope the parser is in. The body is parsed either
+/// right before the first declaration that may change its meaning, possibly
+/// in the middle of the enclosing declaration (see ParsePendingLazyBodies()),
+/// or on demand after the end of the translation unit, when no declaration
+/// can follow it any more, so it means what it would have meant if parsed in
+/// place. The pragma state of the body is restored for the parse.
+void Parser::ParseLazyFunctionBody(FunctionDecl *FD) {
+  LazyParsedFunctionBody *LB = LazyParsedBodyMap.lookup(FD);
+  if (!LB || !FD->hasUnparsedCachedBody())
+    return;
+  FD->setHasUnparsedCachedBody(false);
+
+  // Don't cache the body again while replaying it, and leave the state of a
+  // declaration being parsed outside of it. Sema forgets the translation
+  // unit scope at the end of the TU, so find it from the current scope.
+  Scope *TUScope = getCurScope();
+  while (TUScope->getParent())
+    TUScope = TUScope->getParent();
+  llvm::SaveAndRestore<bool> NotLazy(LazyFunctionBodies, false);
+  llvm::SaveAndRestore<bool> SavedGreaterThan(GreaterThanIsOperator, true);
+  llvm::SaveAndRestore<bool> SavedColon(ColonIsSacred, false);
+  llvm::SaveAndRestore<bool> SavedInMessage(InMessageExpression, false);
+  llvm::SaveAndRestore<unsigned> SavedDepth(TemplateParameterDepth, 0);
+  llvm::SaveAndRestore<Scope*> SavedCurScope(Actions.CurScope, TUScope);
+  llvm::SaveAndRestore<Scope*> SavedTUScope(Actions.TUScope, TUScope);
+  ASTContext::AllocationOwnerRAII AllocOwner(Actions.Context,
+                                             ASTContext::AO_Parse);
+
+  // Restore the pragma state of the body; canParseFunctionBodyLazily() made
+  // sure no #pragma pack, ms_struct or visibility was in effect there.
+  llvm::SaveAndRestore<FPOptions> SavedFP(Actions.FPFeatures, LB->FPFeatures);
+  llvm::SaveAndRestore<OpenCLOptions>
+    SavedOpenCL(Actions.OpenCLFeatures, LB->OpenCLFeatures);
+  llvm::SaveAndRestore<bool> SavedMSStruct(Actions.MSStructPragmaOn, false);
+  void *SavedPackContext = Actions.PackContext;
+  void *SavedVisContext = Actions.VisContext;
+  Actions.PackContext = Actions.VisContext = 0;
+
+  // To restore the context after parsing.
+  Sema::ContextRAII GlobalSavedContext(Actions,
+                                  Actions.Context.getTranslationUnitDecl());
+
+  // Reenter the enclosing namespaces and classes, outermost first.
+  SmallVector<DeclContext*, 4> DeclContextToReenter;
+  for (DeclContext *DC = FD->getLexicalParent();
+       DC && !DC->isTranslationUnit(); DC = DC->getLexicalParent())
+    DeclContextToReenter.push_back(DC);
+
+  SmallVector<ParseScope*, 4> DeclScopeStack;
+  for (SmallVector<DeclContext*, 4>::reverse_iterator
+         I = DeclContextToReenter.rbegin(), E = DeclContextToReenter.rend();
+       I != E; ++I) {
+    DeclScopeStack.push_back(new ParseScope(this, Scope::DeclScope));
+    Actions.PushDeclContext(Actions.getCurScope(), *I);
+  }
+
+  // Append the current token at the end of the new token stream so that it
+  // doesn't get lost.
+  LB->Toks.push_back(Tok);
+  PP.EnterTokenStream(LB->Toks.data(), LB->Toks.size(), true, false);
+
+  // Consume the previously pushed token.
+  ConsumeAnyToken();
+  assert(Tok.is(tok::l_brace) && "Lazy function body not starting with '{'");
+
+  ParseScope FnScope(this, Scope::FnScope|Scope::DeclScope);
+
+  // Recreate the containing function DeclContext.
+  Sema::ContextRAII FunctionSavedContext(Actions, Actions.getContainingDC(FD));
+
+  Actions.ActOnStartOfFunctionDef(getCurScope(), FD);
+  ParseFunctionStatementBody(FD, FnScope);
+
+  // Exit scopes.
+  FnScope.Exit();
+  for (SmallVector<ParseScope*, 4>::reverse_iterator
+         I = DeclScopeStack.rbegin(), E = DeclScopeStack.rend(); I != E; ++I)
+    delete *I;
+
+  if (Actions.PackContext)
+    Actions.FreePackedContext();
+  if (Actions.VisContext)
+    Actions.FreeVisContext();
+  Actions.PackContext = SavedPackContext;
+  Actions.VisContext = SavedVisContext;
+}
+
 /// ParseCXXTryBlock - Parse a C++ try-block.
 ///
 ///       try-block:
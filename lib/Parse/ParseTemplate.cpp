@@ -246,6 +246,9 @@ Parser::ParseSingleDeclarationAfterTemplate(
     return 0;
   }
 
+  if (Context == Declarator::FileContext)
+    ParsePendingLazyBodies(DeclaratorInfo);
+
   LateParsedAttrList LateParsedAttrs;
   if (DeclaratorInfo.isFunctionDeclarator())
     MaybeParseGNUAttributes(DeclaratorInfo, &LateParsedAttrs);
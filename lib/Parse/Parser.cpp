@@ -47,11 +47,13 @@ IdentifierInfo *Parser::getSEHExceptKeyword() {
   return Ident__except;
 }
 
-Parser::Parser(Preprocessor &pp, Sema &actions, bool SkipFunctionBodies)
+Parser::Parser(Preprocessor &pp, Sema &actions, bool SkipFunctionBodies,
+               bool LazyFunctionBodies)
   : PP(pp), Actions(actions), Diags(PP.getDiagnostics()),
     GreaterThanIsOperator(true), ColonIsSacred(false), 
     InMessageExpression(false), TemplateParameterDepth(0),
-    ParsingInObjCContainer(false), SkipFunctionBodies(SkipFunctionBodies) {
+    ParsingInObjCContainer(false), SkipFunctionBodies(SkipFunctionBodies),
+    LazyFunctionBodies(LazyFunctionBodies) {
   Tok.setKind(tok::eof);
   Actions.CurScope = 0;
   NumCachedScopes = 0;
@@ -425,6 +427,11 @@ Parser::~Parser() {
       it != LateParsedTemplateMap.end(); ++it)
     delete it->second;
 
+  // Free LazyParsedFunctionBody nodes.
+  for (LazyParsedBodyMapT::iterator it = LazyParsedBodyMap.begin();
+       it != LazyParsedBodyMap.end(); ++it)
+    delete it->second;
+
   // Remove the pragma handlers we installed.
   PP.RemovePragmaHandler(AlignHandler.get());
   AlignHandler.reset();
@@ -561,6 +568,21 @@ bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
 
   Result = DeclGroupPtrTy();
   if (Tok.is(tok::eof)) {
+    // No declaration can change the meaning of the cached bodies any more.
+    // Sema only learns what the bodies that stay lazy mention, for the
+    // checks for unused declarations.
+    if (!PP.isIncrementalProcessingEnabled()) {
+      for (llvm::DenseMap<IdentifierInfo*, unsigned>::iterator
+             N = PendingLazyBodyNames.begin(),
+             NEnd = PendingLazyBodyNames.end();
+           N != NEnd; ++N)
+        Actions.LazyFunctionBodyNames.insert(N->first);
+      for (unsigned I = 0, N = PendingLazyBodies.size(); I != N; ++I)
+        PendingLazyBodies[I]->Names.clear();
+      PendingLazyBodies.clear();
+      PendingLazyBodyNames.clear();
+    }
+
     // Late template parsing can begin.
     if (getLangOpts().DelayedTemplateParsing)
       Actions.SetLateTemplateParser(LateTemplateParserCallback, this);
@@ -668,6 +690,9 @@ Parser::ParseExternalDeclaration(ParsedAttributesWithRange &attrs,
     break;
   }
   case tok::at:
+    // An Objective-C declaration may change the meaning of a message send
+    // that doesn't name it.
+    ParsePendingLazyBodies(0);
     return ParseObjCAtDirectives();
   case tok::minus:
   case tok::plus:
@@ -676,6 +701,7 @@ Parser::ParseExternalDeclaration(ParsedAttributesWithRange &attrs,
       ConsumeToken();
       return DeclGroupPtrTy();
     }
+    ParsePendingLazyBodies(0);
     SingleDecl = ParseObjCMethodDefinition();
     break;
   case tok::code_completion:
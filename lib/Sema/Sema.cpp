@@ -91,6 +91,8 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     CurContext(0), OriginalLexicalContext(0),
     PackContext(0), MSStructPragmaOn(false), VisContext(0),
     ExprNeedsCleanups(false), LateTemplateParser(0), OpaqueParser(0),
+    LazyBodyParser(0), LazyBodyParserCleanup(0), OpaqueLazyBodyParser(0),
+    CurFunctionBodyUses(0),
     IdResolver(pp), StdInitializerList(0), CXXTypeInfoDecl(0), MSVCGuidDecl(0),
     NSNumberDecl(0),
     NSStringDecl(0), StringWithUTF8StringMethod(0),
@@ -185,6 +187,9 @@ void Sema::Initialize() {
 }
 
 Sema::~Sema() {
+  // The lazy-body parser refers back to us, so release it first.
+  if (LazyBodyParserCleanup)
+    LazyBodyParserCleanup(OpaqueLazyBodyParser);
   if (PackContext) FreePackedContext();
   if (VisContext) FreeVisContext();
   delete TheTargetAttributesSema;
@@ -507,6 +512,8 @@ void Sema::ActOnEndOfTranslationUnit() {
   assert(DelayedDiagnostics.getCurrentPool() == NULL
          && "reached end of translation unit with a pool attached?");
 
+  ASTContext::AllocationOwnerRAII SemaOwner(Context, ASTContext::AO_Sema);
+
   // If code completion is enabled, don't perform any end-of-translation-unit
   // work.
   if (PP.isCodeCompletionEnabled())
@@ -550,6 +557,9 @@ void Sema::ActOnEndOfTranslationUnit() {
     PerformPendingInstantiations();
   }
   
+  // The bodies left lazy don't mark what they use.
+  MarkLazyFunctionBodyUses();
+
   // Remove file scoped decls that turned out to be used.
   UnusedFileScopedDecls.erase(std::remove_if(UnusedFileScopedDecls.begin(0, 
                                                                          true),
@@ -745,6 +755,90 @@ void Sema::ActOnEndOfTranslationUnit() {
   TUScope = 0;
 }
 
+bool Sema::ParseLazyFunctionBody(FunctionDecl *FD) {
+  const FunctionDecl *Definition = 0;
+  if (!LazyBodyParser || !FD->isDefined(Definition) ||
+      !Definition->hasUnparsedCachedBody())
+    return false;
+
+  LazyBodyParser(OpaqueLazyBodyParser, const_cast<FunctionDecl*>(Definition));
+
+  // The body may use templates that have not been instantiated yet.
+  if (TUKind == TU_Complete)
+    PerformPendingInstantiations();
+
+  return Definition->getBody() != 0;
+}
+
+std::string Sema::getLazyFunctionBodyUseKey(const NamedDecl *D) {
+  PrintingPolicy Policy(D->getASTContext().getLangOpts());
+  Policy.AnonymousTagLocations = false;
+  std::string Key = D->getQualifiedNameAsString(Policy);
+  if (const ValueDecl *VD = dyn_cast<ValueDecl>(D))
+    VD->getType().getCanonicalType().getAsStringInternal(Key, Policy);
+  return Key;
+}
+
+void Sema::MarkLazyFunctionBodyUses() {
+  if (LazyFunctionBodyUses.empty() && LazyFunctionBodyNames.empty())
+    return;
+
+  for (UnusedFileScopedDeclsType::iterator
+         D = UnusedFileScopedDecls.begin(ExternalSource),
+         DEnd = UnusedFileScopedDecls.end();
+       D != DEnd; ++D) {
+    DeclaratorDecl *DD = const_cast<DeclaratorDecl *>(*D);
+    if (LazyFunctionBodyNames.count(DD->getIdentifier())) {
+      DD->setReferenced();
+      DD->setUsed();
+      continue;
+    }
+    if (LazyFunctionBodyUses.empty())
+      continue;
+    llvm::StringMap<bool>::iterator Use
+      = LazyFunctionBodyUses.find(getLazyFunctionBodyUseKey(*D));
+    if (Use == LazyFunctionBodyUses.end())
+      continue;
+    DD->setReferenced();
+    if (Use->second)
+      DD->setUsed();
+  }
+
+  SmallVector<const NamedDecl *, 4> UsedFields;
+  for (NamedDeclSetType::iterator F = UnusedPrivateFields.begin(),
+                               FEnd = UnusedPrivateFields.end();
+       F != FEnd; ++F) {
+    if (LazyFunctionBodyNames.count((*F)->getIdentifier()) ||
+        (!LazyFunctionBodyUses.empty() &&
+         LazyFunctionBodyUses.count(getLazyFunctionBodyUseKey(*F))))
+      UsedFields.push_back(*F);
+  }
+  for (unsigned I = 0, N = UsedFields.size(); I != N; ++I)
+    UnusedPrivateFields.remove(UsedFields[I]);
+}
+
+/// \brief Whether Sema checks for uses of \p D at the end of the translation
+/// unit, to warn about unused functions, variables and private fields.
+static bool isCheckedForUses(const NamedDecl *D) {
+  if (const FieldDecl *Field = dyn_cast<FieldDecl>(D))
+    return Field->getAccess() == AS_private;
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+    return FD->getLinkage() != ExternalLinkage;
+  if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+    return VD->isFileVarDecl() && VD->getLinkage() != ExternalLinkage;
+  return false;
+}
+
+void Sema::recordFunctionBodyUseSlow(const NamedDecl *D, bool Used) {
+  if (!isCheckedForUses(D))
+    return;
+  if (Used)
+    CurFunctionBodyUses->UsedDecls.push_back(getLazyFunctionBodyUseKey(D));
+  else
+    CurFunctionBodyUses->ReferencedDecls.push_back(
+      getLazyFunctionBodyUseKey(D));
+}
+
 
 //===----------------------------------------------------------------------===//
 // Helper functions.
@@ -2840,8 +2840,10 @@ struct BaseAndFieldInfo {
     AllToInit.push_back(Init);
 
     // Check whether this initializer makes the field "used".
-    if (Init->getInit() && Init->getInit()->HasSideEffects(S.Context))
+    if (Init->getInit() && Init->getInit()->HasSideEffects(S.Context)) {
       S.UnusedPrivateFields.remove(Init->getAnyMember());
+      S.recordFunctionBodyUse(Init->getAnyMember(), /*Used=*/true);
+    }
 
     return false;
   }
@@ -10774,6 +10776,9 @@ void Sema::MarkVTableUsed(SourceLocation Loc, CXXRecordDecl *Class,
     }
   }
 
+  // A lazy function body that was left unparsed would not use the vtable.
+  recordFunctionBodyNonLocalEffect();
+
   // Local classes need to have their virtual members marked
   // immediately. For all other classes, we mark their virtual members
   // at the end of the translation unit.
@@ -10206,12 +10206,38 @@ static bool IsPotentiallyEvaluatedContext(Sema &SemaRef) {
   llvm_unreachable("Invalid context");
 }
 
+/// \brief Whether odr-using \p Func for the first time does more than mark it
+/// used.
+static bool hasNonLocalUseEffects(FunctionDecl *Func) {
+  if (Func->isDefaulted() && !Func->isDeleted()) {
+    // Only trivial default constructors aren't defined when used.
+    CXXConstructorDecl *Constructor = dyn_cast<CXXConstructorDecl>(Func);
+    if (!Constructor || !Constructor->isDefaultConstructor() ||
+        !Constructor->isTrivial())
+      return true;
+  }
+  if (CXXConversionDecl *Conversion = dyn_cast<CXXConversionDecl>(Func))
+    if (Conversion->getParent()->isLambda())
+      return true;
+  for (FunctionDecl::redecl_iterator I = Func->redecls_begin(),
+                                     E = Func->redecls_end(); I != E; ++I)
+    if (I->isImplicitlyInstantiable())
+      return true;
+  const FunctionProtoType *FPT = Func->getType()->getAs<FunctionProtoType>();
+  if (FPT && isUnresolvedExceptionSpec(FPT->getExceptionSpecType()))
+    return true;
+  return !Func->isPure() && !Func->hasBody() &&
+         Func->getLinkage() != ExternalLinkage;
+}
+
 /// \brief Mark a function referenced, and check whether it is odr-used
 /// (C++ [basic.def.odr]p2, C99 6.9p3)
 void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func) {
   assert(Func && "No function?");
 
   Func->setReferenced();
+  if (CurFunctionBodyUses)
+    recordFunctionBodyUse(Func, IsPotentiallyEvaluatedContext(*this));
 
   // Don't mark this function as used multiple times, unless it's a constexpr
   // function which we need to instantiate.
@@ -10223,6 +10249,12 @@ void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func) {
   if (!IsPotentiallyEvaluatedContext(*this))
     return;
 
+  // Defining the function implicitly, instantiating it, resolving its
+  // exception specification or noting it as undefined all outlive the body
+  // that uses it. (Vtable uses are recorded by MarkVTableUsed.)
+  if (CurFunctionBodyUses && hasNonLocalUseEffects(Func))
+    recordFunctionBodyNonLocalEffect();
+
   // Note that this declaration has been used.
   if (CXXConstructorDecl *Constructor = dyn_cast<CXXConstructorDecl>(Func)) {
     if (Constructor->isDefaulted() && !Constructor->isDeleted()) {
@@ -10816,11 +10848,14 @@ QualType Sema::getCapturedDeclRefType(VarDecl *Var, SourceLocation Loc) {
 
 static void MarkVarDeclODRUsed(Sema &SemaRef, VarDecl *Var,
                                SourceLocation Loc) {
+  SemaRef.recordFunctionBodyUse(Var, /*Used=*/true);
+
   // Keep track of used but undefined variables.
   // FIXME: We shouldn't suppress this warning for static data members.
   if (Var->hasDefinition(SemaRef.Context) == VarDecl::DeclarationOnly &&
       Var->getLinkage() != ExternalLinkage &&
       !(Var->isStaticDataMember() && Var->hasInit())) {
+    SemaRef.recordFunctionBodyNonLocalEffect();
     SourceLocation &old = SemaRef.UndefinedInternals[Var->getCanonicalDecl()];
     if (old.isInvalid()) old = Loc;
   }
@@ -10878,6 +10913,7 @@ void Sema::CleanupVarDeclMarking() {
 static void DoMarkVarDeclReferenced(Sema &SemaRef, SourceLocation Loc,
                                     VarDecl *Var, Expr *E) {
   Var->setReferenced();
+  SemaRef.recordFunctionBodyUse(Var, /*Used=*/false);
 
   if (!IsPotentiallyEvaluatedContext(SemaRef))
     return;
@@ -10890,6 +10926,7 @@ static void DoMarkVarDeclReferenced(Sema &SemaRef, SourceLocation Loc,
     if (MSInfo->getTemplateSpecializationKind() == TSK_ImplicitInstantiation &&
         (!AlreadyInstantiated ||
          Var->isUsableInConstantExpressions(SemaRef.Context))) {
+      SemaRef.recordFunctionBodyNonLocalEffect();
       if (!AlreadyInstantiated) {
         // This is a modification of an existing AST node. Notify listeners.
         if (ASTMutationListener *L = SemaRef.getASTMutationListener())
@@ -10977,8 +11014,11 @@ void Sema::MarkAnyDeclReferenced(SourceLocation Loc, Decl *D) {
     MarkVariableReferenced(Loc, VD);
   else if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
     MarkFunctionReferenced(Loc, FD);
-  else
+  else {
     D->setReferenced();
+    if (NamedDecl *ND = dyn_cast<NamedDecl>(D))
+      recordFunctionBodyUse(ND, /*Used=*/false);
+  }
 }
 
 namespace {
@@ -1613,6 +1613,7 @@ BuildFieldReferenceExpr(Sema &S, Expr *BaseExpr, bool IsArrow,
   }
   
   S.UnusedPrivateFields.remove(Field);
+  S.recordFunctionBodyUse(Field, /*Used=*/true);
 
   ExprResult Base =
   S.PerformObjectMemberConversion(BaseExpr, SS.getScopeRep(),
@@ -174,7 +174,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                        SemaRef.InNonInstantiationSFINAEContext)
+                                        SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation,
                                     InstantiationRange);
@@ -197,7 +199,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                        SemaRef.InNonInstantiationSFINAEContext)
+                                        SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation,
                                     InstantiationRange);
@@ -221,7 +225,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation,
                                     InstantiationRange);
@@ -248,7 +254,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation, InstantiationRange);
   if (!Invalid) {
@@ -276,7 +284,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation, InstantiationRange);
   if (!Invalid) {
@@ -300,7 +310,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation, InstantiationRange);
   if (!Invalid) {
@@ -324,7 +336,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation, InstantiationRange);
   if (!Invalid) {
@@ -348,7 +362,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = CheckInstantiationDepth(PointOfInstantiation, InstantiationRange);
   if (!Invalid) {
@@ -372,7 +388,9 @@ InstantiatingTemplate(Sema &SemaRef, SourceLocation PointOfInstantiation,
                       SourceRange InstantiationRange)
   : SemaRef(SemaRef),
     SavedInNonInstantiationSFINAEContext(
-                                     SemaRef.InNonInstantiationSFINAEContext)
+                                     SemaRef.InNonInstantiationSFINAEContext),
+    SavedAllocationOwner(SemaRef.Context.setAllocationOwner(
+                           ASTContext::AO_TemplateInstantiation))
 {
   Invalid = false;
   
@@ -402,11 +420,23 @@ void Sema::InstantiatingTemplate::Clear() {
     SemaRef.ActiveTemplateInstantiations.pop_back();
     Invalid = true;
   }
+
+  // Clear() runs again from the destructor, by which time the owner may have
+  // been changed by someone else; only restore it once.
+  if (SavedAllocationOwner != ASTContext::NumAllocationOwners) {
+    SemaRef.Context.setAllocationOwner(
+      static_cast<ASTContext::AllocationOwner>(SavedAllocationOwner));
+    SavedAllocationOwner = ASTContext::NumAllocationOwners;
+  }
 }
 
 bool Sema::InstantiatingTemplate::CheckInstantiationDepth(
                                         SourceLocation PointOfInstantiation,
                                            SourceRange InstantiationRange) {
+  // Every instantiation is checked here. Its results outlive the function body
+  // that caused it, so that body can't be left lazy on a later parse.
+  SemaRef.recordFunctionBodyNonLocalEffect();
+
   assert(SemaRef.NonInstantiationEntries <=
                                    SemaRef.ActiveTemplateInstantiations.size());
   if ((SemaRef.ActiveTemplateInstantiations.size() - 
@@ -426,28 +456,46 @@ bool Sema::InstantiatingTemplate::CheckInstantiationDepth(
 /// \brief Prints the current instantiation stack through a series of
 /// notes.
 void Sema::PrintInstantiationStack() {
+  // Collect the contexts to print, innermost first. When requested, fold
+  // runs of contexts with the same point of instantiation, which is what
+  // recursive instantiation produces, into the first context of the run.
+  SmallVector<const ActiveTemplateInstantiation *, 16> Contexts;
+  SmallVector<unsigned, 16> NumFolded;
+  bool Fold = Diags.getFoldTemplateBacktrace();
+  for (SmallVector<ActiveTemplateInstantiation, 16>::reverse_iterator
+         Active = ActiveTemplateInstantiations.rbegin(),
+         ActiveEnd = ActiveTemplateInstantiations.rend();
+       Active != ActiveEnd; ++Active) {
+    if (Fold && !Contexts.empty() &&
+        Contexts.back()->Kind == Active->Kind &&
+        Contexts.back()->PointOfInstantiation == Active->PointOfInstantiation) {
+      ++NumFolded.back();
+      continue;
+    }
+    Contexts.push_back(&*Active);
+    NumFolded.push_back(0);
+  }
+
   // Determine which template instantiations to skip, if any.
-  unsigned SkipStart = ActiveTemplateInstantiations.size(), SkipEnd = SkipStart;
+  unsigned SkipStart = Contexts.size(), SkipEnd = SkipStart;
   unsigned Limit = Diags.getTemplateBacktraceLimit();
-  if (Limit && Limit < ActiveTemplateInstantiations.size()) {
+  if (Limit && Limit < Contexts.size()) {
     SkipStart = Limit / 2 + Limit % 2;
-    SkipEnd = ActiveTemplateInstantiations.size() - Limit / 2;
+    SkipEnd = Contexts.size() - Limit / 2;
   }
 
   // FIXME: In all of these cases, we need to show the template arguments
-  unsigned InstantiationIdx = 0;
-  for (SmallVector<ActiveTemplateInstantiation, 16>::reverse_iterator
-         Active = ActiveTemplateInstantiations.rbegin(),
-         ActiveEnd = ActiveTemplateInstantiations.rend();
-       Active != ActiveEnd;
-       ++Active, ++InstantiationIdx) {
+  for (unsigned InstantiationIdx = 0, N = Contexts.size();
+       InstantiationIdx != N; ++InstantiationIdx) {
+    const ActiveTemplateInstantiation *Active = Contexts[InstantiationIdx];
+
     // Skip this instantiation?
     if (InstantiationIdx >= SkipStart && InstantiationIdx < SkipEnd) {
       if (InstantiationIdx == SkipStart) {
         // Note that we're skipping instantiations.
         Diags.Report(Active->PointOfInstantiation,
                      diag::note_instantiation_contexts_suppressed)
-          << unsigned(ActiveTemplateInstantiations.size() - Limit);
+          << unsigned(Contexts.size() - Limit);
       }
       continue;
     }
@@ -607,6 +655,11 @@ void Sema::PrintInstantiationStack() {
         << Active->InstantiationRange;
       break;
     }
+
+    if (NumFolded[InstantiationIdx])
+      Diags.Report(Active->PointOfInstantiation,
+                   diag::note_instantiation_contexts_folded)
+        << NumFolded[InstantiationIdx];
   }
 }
 
@@ -1109,7 +1109,13 @@ ASTReader::ASTReadResult ASTReader::ReadSLocEntryRecord(int ID) {
       return Failure;
     }
 
-    if (!DisableValidation &&
+    if (!DisableValidation && ValidateInputFilesLazily && !OverriddenBuffer) {
+      // validateFileEntries() was skipped when the AST file was loaded, so
+      // this is the first time this file is checked against the file system.
+      if (!validateInputFile(Filename, File, (off_t)Record[4],
+                             (time_t)Record[5]))
+        Result = Failure;
+    } else if (!DisableValidation &&
         ((off_t)Record[4] != File->getSize()
 #if !defined(LLVM_ON_WIN32)
         // In our regression testing, the Windows file system seems to
@@ -1539,12 +1545,15 @@ void ASTReader::LoadMacroDefinition(IdentifierInfo *II) {
 namespace {
   /// \brief Visitor class used to look up identifirs in an AST file.
   class IdentifierLookupVisitor {
-    StringRef Name;
+    ASTIdentifierLookupTrait::internal_key_type Key;
+    unsigned NameHash;
     unsigned PriorGeneration;
     IdentifierInfo *Found;
   public:
     IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration) 
-      : Name(Name), PriorGeneration(PriorGeneration), Found() { }
+      : Key(Name.begin(), Name.size()),
+        NameHash(ASTIdentifierLookupTrait::ComputeHash(Key)),
+        PriorGeneration(PriorGeneration), Found() { }
     
     static bool visit(ModuleFile &M, void *UserData) {
       IdentifierLookupVisitor *This
@@ -1561,10 +1570,11 @@ namespace {
       
       ASTIdentifierLookupTrait Trait(IdTable->getInfoObj().getReader(),
                                      M, This->Found);
-                                     
-      std::pair<const char*, unsigned> Key(This->Name.begin(), 
-                                           This->Name.size());
-      ASTIdentifierLookupTable::iterator Pos = IdTable->find(Key, &Trait);
+
+      // Every module's identifier table uses the same hash function, so the
+      // hash computed once up front is valid for all of them.
+      ASTIdentifierLookupTable::iterator Pos
+        = IdTable->find_hashed(This->Key, This->NameHash, &Trait);
       if (Pos == IdTable->end())
         return false;
       
@@ -2064,6 +2074,9 @@ ASTReader::ReadASTBlock(ModuleFile &F) {
       llvm::tie(F.SLocEntryBaseID, F.SLocEntryBaseOffset) =
           SourceMgr.AllocateLoadedSLocEntries(F.LocalNumSLocEntries,
                                               SLocSpaceSize);
+      // The source manager has reported that the locations ran out.
+      if (F.SLocEntryBaseID == 0)
+        return Failure;
       // Make our entry in the range map. BaseID is negative and growing, so
       // we invert it. Because we invert it, though, we need the other end of
       // the range.
@@ -2493,45 +2506,9 @@ ASTReader::ASTReadResult ASTReader::validateFileEntries(ModuleFile &M) {
         return Failure;
       }
       
-      off_t StoredSize = (off_t)Record[4];
-      time_t StoredTime = (time_t)Record[5];
-
-      // Check if there was a request to override the contents of the file
-      // that was part of the precompiled header. Overridding such a file
-      // can lead to problems when lexing using the source locations from the
-      // PCH.
-      SourceManager &SM = getSourceManager();
-      if (SM.isFileOverridden(File)) {
-        Error(diag::err_fe_pch_file_overridden, Filename);
-        // After emitting the diagnostic, recover by disabling the override so
-        // that the original file will be used.
-        SM.disableFileContentsOverride(File);
-        // The FileEntry is a virtual file entry with the size of the contents
-        // that would override the original contents. Set it to the original's
-        // size/time.
-        FileMgr.modifyFileEntry(const_cast<FileEntry*>(File),
-                                StoredSize, StoredTime);
-      }
-
-      // The stat info from the FileEntry came from the cached stat
-      // info of the PCH, so we cannot trust it.
-      struct stat StatBuf;
-      if (::stat(File->getName(), &StatBuf) != 0) {
-        StatBuf.st_size = File->getSize();
-        StatBuf.st_mtime = File->getModificationTime();
-      }
-
-      if ((StoredSize != StatBuf.st_size
-#if !defined(LLVM_ON_WIN32)
-          // In our regression testing, the Windows file system seems to
-          // have inconsistent modification times that sometimes
-          // erroneously trigger this error-handling path.
-           || StoredTime != StatBuf.st_mtime
-#endif
-          )) {
-        Error(diag::err_fe_pch_file_modified, Filename);
+      if (!validateInputFile(Filename, File, (off_t)Record[4],
+                             (time_t)Record[5]))
         return IgnorePCH;
-      }
 
       break;
     }
@@ -2541,6 +2518,50 @@ ASTReader::ASTReadResult ASTReader::validateFileEntries(ModuleFile &M) {
   return Success;
 }
 
+bool ASTReader::validateInputFile(StringRef Filename, const FileEntry *File,
+                                  off_t StoredSize, time_t StoredTime) {
+  ++NumInputFilesValidated;
+
+  // Check if there was a request to override the contents of the file
+  // that was part of the precompiled header. Overridding such a file
+  // can lead to problems when lexing using the source locations from the
+  // PCH.
+  SourceManager &SM = getSourceManager();
+  if (SM.isFileOverridden(File)) {
+    Error(diag::err_fe_pch_file_overridden, Filename);
+    // After emitting the diagnostic, recover by disabling the override so
+    // that the original file will be used.
+    SM.disableFileContentsOverride(File);
+    // The FileEntry is a virtual file entry with the size of the contents
+    // that would override the original contents. Set it to the original's
+    // size/time.
+    FileMgr.modifyFileEntry(const_cast<FileEntry*>(File),
+                            StoredSize, StoredTime);
+  }
+
+  // The stat info from the FileEntry came from the cached stat
+  // info of the PCH, so we cannot trust it.
+  struct stat StatBuf;
+  if (::stat(File->getName(), &StatBuf) != 0) {
+    StatBuf.st_size = File->getSize();
+    StatBuf.st_mtime = File->getModificationTime();
+  }
+
+  if ((StoredSize != StatBuf.st_size
+#if !defined(LLVM_ON_WIN32)
+      // In our regression testing, the Windows file system seems to
+      // have inconsistent modification times that sometimes
+      // erroneously trigger this error-handling path.
+       || StoredTime != StatBuf.st_mtime
+#endif
+      )) {
+    Error(diag::err_fe_pch_file_modified, Filename);
+    return false;
+  }
+
+  return true;
+}
+
 void ASTReader::makeNamesVisible(const HiddenNames &Names) {
   for (unsigned I = 0, N = Names.size(); I != N; ++I) {
     if (Decl *D = Names[I].dyn_cast<Decl *>())
@@ -2830,8 +2851,12 @@ ASTReader::ASTReadResult ASTReader::ReadASTCore(StringRef FileName,
   TotalModulesSizeInBits += F.SizeInBits;
   GlobalBitOffsetsMap.insert(std::make_pair(F.GlobalBitOffset, &F));
 
-  // Make sure that the files this module was built against are still available.
-  if (!DisableValidation) {
+  TotalNumInputFiles += M->LocalNumSLocFileEntries;
+
+  // Make sure that the files this module was built against are still
+  // available. In lazy mode, each file is checked when its source location
+  // entry is first read instead.
+  if (!DisableValidation && !ValidateInputFilesLazily) {
     switch(validateFileEntries(*M)) {
     case Failure: return Failure;
     case IgnorePCH: return IgnorePCH;
@@ -3703,9 +3728,11 @@ void ASTReader::ReadPragmaDiagnosticMappings(DiagnosticsEngine &Diag) {
         diag::Mapping Map = (diag::Mapping)F.PragmaDiagMappings[Idx++];
         DiagnosticMappingInfo MappingInfo = Diag.makeMappingInfo(Map, Loc);
         Diag.GetCurDiagState()->setMappingInfo(DiagID, MappingInfo);
+        Diag.markLocationDependent(DiagID);
       }
     }
   }
+  Diag.DiagStateRangeCache.clear();
 }
 
 /// \brief Get the correct cursor and offset for loading a type.
@@ -3731,6 +3758,8 @@ QualType ASTReader::readTypeRecord(unsigned Index) {
   SavedStreamPosition SavedPosition(DeclsCursor);
 
   ReadingKindTracker ReadingKind(Read_Type, *this);
+  ASTContext::AllocationOwnerRAII AllocOwner(Context,
+                                         ASTContext::AO_Serialization);
 
   // Note that we are loading a type record.
   Deserializing AType(this);
@@ -5142,6 +5171,10 @@ void ASTReader::PrintStats() {
 
   std::fprintf(stderr, "  %u stat cache hits\n", NumStatHits);
   std::fprintf(stderr, "  %u stat cache misses\n", NumStatMisses);
+  if (TotalNumInputFiles)
+    std::fprintf(stderr, "  %u/%u input files validated (%f%%)\n",
+                 NumInputFilesValidated, TotalNumInputFiles,
+                 ((float)NumInputFilesValidated/TotalNumInputFiles * 100));
   if (unsigned TotalNumSLocEntries = getTotalNumSLocs())
     std::fprintf(stderr, "  %u/%u source location entries read (%f%%)\n",
                  NumSLocEntriesRead, TotalNumSLocEntries,
@@ -5355,6 +5388,7 @@ namespace clang { namespace serialization {
   class ReadMethodPoolVisitor {
     ASTReader &Reader;
     Selector Sel;
+    unsigned SelHash;
     unsigned PriorGeneration;
     llvm::SmallVector<ObjCMethodDecl *, 4> InstanceMethods;
     llvm::SmallVector<ObjCMethodDecl *, 4> FactoryMethods;
@@ -5362,7 +5396,9 @@ namespace clang { namespace serialization {
   public:
     ReadMethodPoolVisitor(ASTReader &Reader, Selector Sel, 
                           unsigned PriorGeneration)
-      : Reader(Reader), Sel(Sel), PriorGeneration(PriorGeneration) { }
+      : Reader(Reader), Sel(Sel),
+        SelHash(ASTSelectorLookupTrait::ComputeHash(Sel)),
+        PriorGeneration(PriorGeneration) { }
     
     static bool visit(ModuleFile &M, void *UserData) {
       ReadMethodPoolVisitor *This
@@ -5377,7 +5413,8 @@ namespace clang { namespace serialization {
 
       ASTSelectorLookupTable *PoolTable
         = (ASTSelectorLookupTable*)M.SelectorLookupTable;
-      ASTSelectorLookupTable::iterator Pos = PoolTable->find(This->Sel);
+      ASTSelectorLookupTable::iterator Pos
+        = PoolTable->find_hashed(This->Sel, This->SelHash);
       if (Pos == PoolTable->end())
         return false;
       
@@ -6452,11 +6489,12 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
     Consumer(0), ModuleMgr(FileMgr.getFileSystemOptions()),
     RelocatablePCH(false), isysroot(isysroot),
     DisableValidation(DisableValidation),
-    DisableStatCache(DisableStatCache),
+    DisableStatCache(DisableStatCache), ValidateInputFilesLazily(false),
     AllowASTWithCompilerErrors(AllowASTWithCompilerErrors), 
     CurrentGeneration(0), CurrSwitchCaseStmts(&SwitchCaseStmts),
     NumStatHits(0), NumStatMisses(0), 
-    NumSLocEntriesRead(0), TotalNumSLocEntries(0), 
+    NumSLocEntriesRead(0), NumInputFilesValidated(0), TotalNumInputFiles(0),
+    TotalNumSLocEntries(0), 
     NumStatementsRead(0), TotalNumStatements(0), NumMacrosRead(0), 
     TotalNumMacros(0), NumSelectorsRead(0), NumMethodPoolEntriesRead(0), 
     NumMethodPoolMisses(0), TotalNumMethodPoolEntries(0), 
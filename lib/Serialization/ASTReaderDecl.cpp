@@ -1901,6 +1901,8 @@ Decl *ASTReader::ReadDeclRecord(DeclID ID) {
   SavedStreamPosition SavedPosition(DeclsCursor);
 
   ReadingKindTracker ReadingKind(Read_Decl, *this);
+  ASTContext::AllocationOwnerRAII AllocOwner(Context,
+                                         ASTContext::AO_Serialization);
 
   // Note that we are loading a declaration record.
   Deserializing ADecl(this);
@@ -1084,7 +1084,7 @@ void ASTStmtReader::VisitMSDependentExistsStmt(MSDependentExistsStmt *S) {
 
 void ASTStmtReader::VisitCXXOperatorCallExpr(CXXOperatorCallExpr *E) {
   VisitCallExpr(E);
-  E->Operator = (OverloadedOperatorKind)Record[Idx++];
+  E->setOperator((OverloadedOperatorKind)Record[Idx++]);
   E->Range = Reader.ReadSourceRange(F, Record, Idx);
 }
 
@@ -1579,6 +1579,8 @@ Expr *ASTReader::ReadSubExpr() {
 Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
 
   ReadingKindTracker ReadingKind(Read_Stmt, *this);
+  ASTContext::AllocationOwnerRAII AllocOwner(Context,
+                                         ASTContext::AO_Serialization);
   llvm::BitstreamCursor &Cursor = F.DeclsCursor;
   
   // Map of offset to previously deserialized stmt. The offset points
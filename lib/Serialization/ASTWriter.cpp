@@ -2350,6 +2350,36 @@ public:
 };
 } // end anonymous namespace
 
+namespace {
+/// \brief Orders (key, ID) pairs by ID.
+///
+/// The writer's ID maps are keyed by pointer, so iterating them directly
+/// would make the order of entries in the on-disk hash tables (and thus the
+/// bytes of the AST file) depend on where things happened to be allocated.
+struct LessBySecond {
+  template<typename T>
+  bool operator()(const T &X, const T &Y) const {
+    return X.second < Y.second;
+  }
+};
+
+/// \brief Orders (identifier, value) pairs by the identifier's spelling.
+struct LessByIdentifierName {
+  template<typename T>
+  bool operator()(const T &X, const T &Y) const {
+    return X.first->getName() < Y.first->getName();
+  }
+};
+
+/// \brief Orders declarations by their source location.
+struct LessByDeclLocation {
+  bool operator()(const Decl *X, const Decl *Y) const {
+    return X->getLocation().getRawEncoding() <
+           Y->getLocation().getRawEncoding();
+  }
+};
+} // end anonymous namespace
+
 /// \brief Write ObjC data: selectors and the method pool.
 ///
 /// The method pool contains both instance and factory methods, stored
@@ -2370,8 +2400,12 @@ void ASTWriter::WriteSelectors(Sema &SemaRef) {
     // Create the on-disk hash table representation. We walk through every
     // selector we've seen and look it up in the method pool.
     SelectorOffsets.resize(NextSelectorID - FirstSelectorID);
-    for (llvm::DenseMap<Selector, SelectorID>::iterator
-             I = SelectorIDs.begin(), E = SelectorIDs.end();
+    typedef std::pair<Selector, SelectorID> SelectorAndID;
+    SmallVector<SelectorAndID, 64> Selectors(SelectorIDs.begin(),
+                                             SelectorIDs.end());
+    std::sort(Selectors.begin(), Selectors.end(), LessBySecond());
+    for (SmallVectorImpl<SelectorAndID>::iterator
+             I = Selectors.begin(), E = Selectors.end();
          I != E; ++I) {
       Selector S = I->first;
       Sema::GlobalMethodPool::iterator F = SemaRef.MethodPool.find(S);
@@ -2463,9 +2497,12 @@ void ASTWriter::WriteReferencedSelectorsPool(Sema &SemaRef) {
   // Note: this writes out all references even for a dependent AST. But it is
   // very tricky to fix, and given that @selector shouldn't really appear in
   // headers, probably not worth it. It's not a correctness issue.
-  for (DenseMap<Selector, SourceLocation>::iterator S =
-       SemaRef.ReferencedSelectors.begin(),
-       E = SemaRef.ReferencedSelectors.end(); S != E; ++S) {
+  typedef std::pair<Selector, SourceLocation> SelectorAndLoc;
+  SmallVector<SelectorAndLoc, 16> Selectors(SemaRef.ReferencedSelectors.begin(),
+                                            SemaRef.ReferencedSelectors.end());
+  std::stable_sort(Selectors.begin(), Selectors.end(), LessBySecond());
+  for (SmallVectorImpl<SelectorAndLoc>::iterator S = Selectors.begin(),
+       E = Selectors.end(); S != E; ++S) {
     Selector Sel = (*S).first;
     SourceLocation Loc = (*S).second;
     AddSelectorRef(Sel, Record);
@@ -2626,8 +2663,12 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     // Create the on-disk hash table representation. We only store offsets
     // for identifiers that appear here for the first time.
     IdentifierOffsets.resize(NextIdentID - FirstIdentID);
-    for (llvm::DenseMap<const IdentifierInfo *, IdentID>::iterator
-           ID = IdentifierIDs.begin(), IDEnd = IdentifierIDs.end();
+    typedef std::pair<const IdentifierInfo *, IdentID> IdentifierAndID;
+    SmallVector<IdentifierAndID, 256> Identifiers(IdentifierIDs.begin(),
+                                                  IdentifierIDs.end());
+    std::sort(Identifiers.begin(), Identifiers.end(), LessBySecond());
+    for (SmallVectorImpl<IdentifierAndID>::iterator
+           ID = Identifiers.begin(), IDEnd = Identifiers.end();
          ID != IDEnd; ++ID) {
       assert(ID->first && "NULL identifier in identifier table");
       if (!Chain || !ID->first->isFromAST() || 
@@ -3284,9 +3325,15 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   // the results at the end of the chain.
   RecordData WeakUndeclaredIdentifiers;
   if (!SemaRef.WeakUndeclaredIdentifiers.empty()) {
-    for (llvm::DenseMap<IdentifierInfo*,WeakInfo>::iterator
-         I = SemaRef.WeakUndeclaredIdentifiers.begin(),
-         E = SemaRef.WeakUndeclaredIdentifiers.end(); I != E; ++I) {
+    typedef std::pair<IdentifierInfo *, WeakInfo> WeakIdentifier;
+    SmallVector<WeakIdentifier, 4> WeakIdentifiers(
+                                    SemaRef.WeakUndeclaredIdentifiers.begin(),
+                                    SemaRef.WeakUndeclaredIdentifiers.end());
+    std::sort(WeakIdentifiers.begin(), WeakIdentifiers.end(),
+              LessByIdentifierName());
+    for (SmallVectorImpl<WeakIdentifier>::iterator
+         I = WeakIdentifiers.begin(), E = WeakIdentifiers.end();
+         I != E; ++I) {
       AddIdentifierRef(I->first, WeakUndeclaredIdentifiers);
       AddIdentifierRef(I->second.getAlias(), WeakUndeclaredIdentifiers);
       AddSourceLocation(I->second.getLocation(), WeakUndeclaredIdentifiers);
@@ -3298,15 +3345,20 @@ void ASTWriter::WriteASTCore(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   // declarations in this header file. Generally, this record will be
   // empty.
   RecordData LocallyScopedExternalDecls;
-  // FIXME: This is filling in the AST file in densemap order which is
-  // nondeterminstic!
+  SmallVector<NamedDecl *, 4> LocallyScopedExterns;
   for (llvm::DenseMap<DeclarationName, NamedDecl *>::iterator
          TD = SemaRef.LocallyScopedExternalDecls.begin(),
          TDEnd = SemaRef.LocallyScopedExternalDecls.end();
        TD != TDEnd; ++TD) {
     if (!TD->second->isFromASTFile())
-      AddDeclRef(TD->second, LocallyScopedExternalDecls);
+      LocallyScopedExterns.push_back(TD->second);
   }
+  // Emit them in source order rather than DenseMap order, so that the
+  // declaration IDs assigned here do not vary from run to run.
+  std::stable_sort(LocallyScopedExterns.begin(), LocallyScopedExterns.end(),
+                   LessByDeclLocation());
+  for (unsigned I = 0, N = LocallyScopedExterns.size(); I != N; ++I)
+    AddDeclRef(LocallyScopedExterns[I], LocallyScopedExternalDecls);
   
   // Build a record containing all of the ext_vector declarations.
   RecordData ExtVectorDecls;
@@ -139,6 +139,8 @@ void ASTDeclWriter::Visit(Decl *D) {
   // have been written. We want it last because we will not read it back when
   // retrieving it from the AST, we'll just lazily set the offset. 
   if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    assert(!FD->hasUnparsedCachedBody() &&
+           "lazy function bodies must be parsed before writing the AST");
     Record.push_back(FD->doesThisDeclarationHaveABody());
     if (FD->doesThisDeclarationHaveABody())
       Writer.AddStmt(FD->getBody());
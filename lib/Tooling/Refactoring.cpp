@@ -58,6 +58,8 @@ bool Replacement::apply(Rewriter &Rewrite) const {
   ID = Location.isValid() ?
     SM.getFileID(Location) :
     SM.createFileID(Entry, SourceLocation(), SrcMgr::C_User);
+  if (ID.isInvalid())
+    return false;
   // FIXME: We cannot check whether Offset + Length is in the file, as
   // the remapping API is not public in the RewriteBuffer.
   const SourceLocation Start =
@@ -0,0 +1,41 @@
+// REQUIRES: x86-registered-target
+
+// Check that the partitions of an object file are written to the outputs
+// given for them, each with its own definitions, and that the output doesn't
+// depend on the host.
+
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj -fparallel-codegen=2 %s -o %t.1.o -parallel-codegen-output %t.1.part.o
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj -fparallel-codegen=2 %s -o %t.2.o -parallel-codegen-output %t.2.part.o
+// RUN: cmp %t.1.o %t.2.o
+// RUN: cmp %t.1.part.o %t.2.part.o
+// RUN: llvm-nm %t.1.o | grep ' T ' | count 1
+// RUN: llvm-nm %t.1.part.o | grep ' T ' | count 1
+
+// Without outputs for the partitions, an object file is generated serially.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj -fparallel-codegen=2 %s -o %t.serial.o
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s -o %t.plain.o
+// RUN: cmp %t.serial.o %t.plain.o
+
+// Assembly is always generated serially.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -S -fparallel-codegen=2 %s -o %t.serial.s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -S %s -o %t.plain.s
+// RUN: cmp %t.serial.s %t.plain.s
+
+// If the module isn't split, the other outputs get empty object files.
+// RUN: rm -f %t.3.part.o
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj -fparallel-codegen=2 -g %s -o %t.3.o -parallel-codegen-output %t.3.part.o
+// RUN: llvm-nm %t.3.part.o | not grep ' T '
+
+int table[16];
+
+int sum(int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += table[i & 15] * i;
+  return s;
+}
+
+void fill(int n) {
+  for (int i = 0; i < n; ++i)
+    table[i & 15] = i;
+}
@@ -0,0 +1,47 @@
+// RUN: %clang_cc1 -emit-llvm -g -flimit-debug-info -fhome-class-debug-info -triple x86_64-apple-darwin %s -o %t
+// RUN: FileCheck -check-prefix=KEYHERE %s < %t
+// RUN: FileCheck -check-prefix=EXPLICIT %s < %t
+// RUN: FileCheck -check-prefix=FWD %s < %t
+// RUN: FileCheck -check-prefix=LATER %s < %t
+// RUN: not grep 'metadata !"KeyElsewhere", .*i64 128, i64 64' %t
+// RUN: not grep 'metadata !"Tmpl<int>", .*i64 32, i64 32' %t
+// RUN: %clang_cc1 -emit-llvm -g -flimit-debug-info -triple x86_64-apple-darwin %s -o - | FileCheck -check-prefix=NOHOME %s
+
+// Classes whose key function is defined in another translation unit, and
+// specializations with an explicit instantiation declaration, only get a
+// forward declaration; the unit that emits the vtable or the explicit
+// instantiation definition describes them in full.
+
+struct KeyElsewhere {
+  virtual void key();
+  int member;
+};
+
+struct KeyHere {
+  virtual void key();
+  int member;
+};
+void KeyHere::key() {}
+
+template <typename T> struct Tmpl { T member; };
+extern template struct Tmpl<int>;
+template struct Tmpl<long>;
+
+template <typename T> struct Later { T member; };
+extern template struct Later<short>;
+
+void f() {
+  KeyElsewhere a;
+  KeyHere b;
+  Tmpl<int> c;
+  Later<short> d;
+}
+
+// The explicit instantiation definition follows a use of the declaration.
+template struct Later<short>;
+
+// KEYHERE: metadata !"KeyHere", {{.*}}, i64 128, i64 64
+// EXPLICIT: metadata !"Tmpl<long>", {{.*}}, i64 64, i64 64
+// LATER: metadata !"Later<short>", {{.*}}, i64 16, i64 16
+// FWD: metadata !"KeyElsewhere", {{.*}}, i64 0, i64 0, i32 0, i32 4
+// NOHOME: metadata !"KeyElsewhere", {{.*}}, i64 128, i64 64
@@ -0,0 +1,33 @@
+// REQUIRES: x86-registered-target
+
+// Check that functions sharing a personality can go to different partitions,
+// each of which refers to the personality on its own.
+
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -fcxx-exceptions -fexceptions -O1 -emit-obj -fparallel-codegen=2 %s -o %t.o -parallel-codegen-output %t.part.o
+// RUN: llvm-nm %t.o | FileCheck %s
+// RUN: llvm-nm %t.part.o | FileCheck %s
+// RUN: llvm-nm %t.o | grep ' T ' | count 1
+// RUN: llvm-nm %t.part.o | grep ' T ' | count 1
+
+// CHECK-DAG: DW.ref.__gxx_personality_v0
+// CHECK-DAG: U __gxx_personality_v0
+// CHECK-DAG: T _Z{{5firsti|6secondi}}
+
+void may_throw(int);
+void cleanup(int);
+
+struct Guard {
+  int n;
+  Guard(int n) : n(n) {}
+  ~Guard() { cleanup(n); }
+};
+
+void first(int n) {
+  Guard g(n);
+  may_throw(n);
+}
+
+void second(int n) {
+  Guard g(n + 1);
+  may_throw(n * 2);
+}
@@ -0,0 +1,42 @@
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=4 -### -c %s 2> %t
+// RUN: FileCheck < %t %s
+
+// CHECK: "-fparallel-codegen=4"
+
+// The partitions of an object file are combined by a relocatable link, run
+// by the toolchain's linker.
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=2 -### -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=OBJ %s
+// OBJ: "-cc1" {{.*}}"-o" "[[PART0:[^"]*]]" "-parallel-codegen-output" "[[PART1:[^"]*]]"
+// OBJ: "{{[^"]*}}ld" "-m" "elf_x86_64" "-r" "-o" "{{[^"]*}}.o" "[[PART0]]" "[[PART1]]"
+
+// RUN: %clang -target i386-unknown-linux-gnu -fparallel-codegen=2 -### -c %s -o %t.o \
+// RUN:     --sysroot=%S/Inputs/basic_linux_tree 2>&1 \
+// RUN:   | FileCheck -check-prefix=SYSROOT %s
+// SYSROOT: "{{[^"]*}}ld" "--sysroot={{[^"]+}}" "-m" "elf_i386" "-r"
+
+// The module isn't split if it has debug info, and toolchains without a
+// relocatable link generate the object file serially.
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=2 -g -### -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=SERIAL %s
+// RUN: %clang -target x86_64-apple-darwin10 -fparallel-codegen=2 -### -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck -check-prefix=SERIAL %s
+// SERIAL-NOT: "-parallel-codegen-output"
+// SERIAL-NOT: "-r"
+
+// The number of partitions doesn't depend on the host.
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=64 -### -c %s -o %t.o 2>&1 \
+// RUN:   | grep -o '"-parallel-codegen-output"' | count 63
+
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=2 -### -S %s -o %t.s 2>&1 \
+// RUN:   | FileCheck -check-prefix=ASM %s
+// ASM-NOT: "-parallel-codegen-output"
+// ASM-NOT: "-r"
+
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=0 -### -c %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=ZERO %s
+// ZERO: invalid integral value '0' in '-fparallel-codegen=0'
+
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=foo -### -c %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=FOO %s
+// FOO: invalid integral value 'foo' in '-fparallel-codegen=foo'
@@ -0,0 +1,43 @@
+// REQUIRES: shell
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir
+// RUN: echo '#ifndef A_H' > %t.dir/a.h
+// RUN: echo '#define A_H' >> %t.dir/a.h
+// RUN: echo 'int a; /* #include "bogus.h"' >> %t.dir/a.h
+// RUN: echo '   */ const char *s = "#include \"bogus.h\"";' >> %t.dir/a.h
+// RUN: echo '#include "b.h"' >> %t.dir/a.h
+// RUN: echo '#endif' >> %t.dir/a.h
+// RUN: echo 'int b;' > %t.dir/b.h
+// RUN: echo 'int c;' > %t.dir/c.h
+// RUN: echo 'int d;' > %t.dir/d.h
+// RUN: cd %t.dir
+// RUN: %clang_cc1 -scan-deps -dependency-file %t.scan.d -MT out.o -I . %s
+// RUN: %clang_cc1 -Eonly -dependency-file %t.eonly.d -MT out.o -I . %s
+// RUN: diff %t.eonly.d %t.scan.d
+// RUN: FileCheck %s < %t.scan.d
+// RUN: not grep 'bogus.h' %t.scan.d
+// RUN: not grep 'd\.h' %t.scan.d
+
+// CHECK: out.o:
+// CHECK: scan-deps.c
+// CHECK: a.h
+// CHECK: b.h
+// CHECK: c.h
+
+#include "a.h"
+#include "a.h"
+
+#define HEADER(X) #X
+#define C_HEADER HEADER(c.h)
+
+int f(int x) { return x + HEADER(1)[0]; }
+
+#if defined(A_H) && __LINE__ > 0
+#  include C_HEADER
+#else
+#  include "d.h"
+#endif
+
+#if 0
+#include "bogus.h"
+#endif
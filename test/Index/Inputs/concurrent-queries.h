@@ -0,0 +1,2 @@
+typedef int HeaderInt;
+struct HeaderS { HeaderInt x; };
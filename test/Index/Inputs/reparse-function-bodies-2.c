@@ -0,0 +1,11 @@
+int g(int x);
+
+int f(int x) {
+  int unused;
+  return g(x);
+}
+
+int h(int x) {
+  int unused2;
+  return x;
+}
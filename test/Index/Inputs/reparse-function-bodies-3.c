@@ -0,0 +1,10 @@
+int g(int x);
+
+int f(int x) {
+  int unused;
+  return g(x);
+}
+
+long h(int x) {
+  return x;
+}
@@ -0,0 +1,15 @@
+static void undefined(void);
+static int helper(void) { return 0; }
+
+int f(void) {
+  undefined();
+  return 0;
+}
+
+int g(void) {
+  return helper();
+}
+
+int h(int x) {
+  return x;
+}
@@ -0,0 +1,11 @@
+static int helper(int x) { return x; }
+template <typename T> T twice(T x) { return helper(x) + helper(x); }
+
+int f(int x) {
+  return twice(x);
+}
+
+int h(int x) {
+  int unused2;
+  return x;
+}
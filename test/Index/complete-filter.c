@@ -0,0 +1,23 @@
+// Note: the run lines follow their respective tests, since line/column
+// matter in this test.
+
+int bar_global;
+void baz(void);
+#define BAZ_MACRO 1
+
+void test(int bad_param) {
+  
+}
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=ba c-index-test -code-completion-at=%s:9:3 %s | FileCheck -check-prefix=CHECK-PREFIX %s
+// RUN: env CINDEXTEST_COMPLETION_FILTER=bazx,ba c-index-test -code-completion-at=%s:9:3 %s | FileCheck -check-prefix=CHECK-PREFIX %s
+// CHECK-PREFIX: ParmDecl:{ResultType int}{TypedText bad_param} (34)
+// CHECK-PREFIX-NEXT: VarDecl:{ResultType int}{TypedText bar_global} (50)
+// CHECK-PREFIX-NEXT: FunctionDecl:{ResultType void}{TypedText baz}{LeftParen (}{RightParen )} (50)
+// CHECK-PREFIX-NEXT: macro definition:{TypedText BAZ_MACRO} (70)
+// CHECK-PREFIX-NEXT: Completion contexts:
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=bm CINDEXTEST_COMPLETION_FILTER_FUZZY=1 c-index-test -code-completion-at=%s:9:3 %s | FileCheck -check-prefix=CHECK-FUZZY %s
+// CHECK-FUZZY: ParmDecl:{ResultType int}{TypedText bad_param} (34)
+// CHECK-FUZZY-NEXT: macro definition:{TypedText BAZ_MACRO} (70)
+// CHECK-FUZZY-NEXT: Completion contexts:
@@ -0,0 +1,31 @@
+#include "concurrent-queries.h"
+
+typedef double Unused;
+struct S { HeaderInt a; };
+int f(HeaderInt v) { return v; }
+
+// RUN: env CINDEXTEST_CONCURRENT_QUERIES=1 CINDEXTEST_EDITING=1 LIBCLANG_TIMING=1 c-index-test -test-print-typekind %s -I %S/Inputs > %t.out 2> %t.err
+// RUN: FileCheck %s < %t.out
+// RUN: FileCheck -check-prefix=CHECK-STATS %s < %t.err
+// CHECK: TypedefDecl=HeaderInt:1:13 (Definition) typekind=Typedef [canonical=Int] [isPOD=1]
+// CHECK: FieldDecl=x:2:28 (Definition) typekind=Typedef [canonical=Int] [isPOD=1]
+// CHECK: TypedefDecl=Unused:3:16 (Definition) typekind=Typedef [canonical=Double] [isPOD=1]
+// CHECK: FieldDecl=a:4:22 (Definition) typekind=Typedef [canonical=Int] [isPOD=1]
+// CHECK: FunctionDecl=f:5:5 (Definition) typekind=FunctionProto [canonical=FunctionProto] [result=Int] [args= Typedef] [isPOD=0]
+// CHECK: ParmDecl=v:5:17 (Definition) typekind=Typedef [canonical=Int] [isPOD=1]
+// CHECK-STATS: Preparing concurrent queries for {{.*}}concurrent-queries.c
+// CHECK-STATS: Concurrent queries on {{.*}}concurrent-queries.c:
+// CHECK-STATS-NEXT: shared access: {{[0-9]+}} acquisitions, {{[0-9]+}} waited, {{[0-9]+}} us waiting
+// CHECK-STATS-NEXT: exclusive access: {{[0-9]+}} acquisitions, {{[0-9]+}} waited, {{[0-9]+}} us waiting
+// CHECK-STATS-NEXT: lazy state: {{[0-9]+}} acquisitions, {{[0-9]+}} waited, {{[0-9]+}} us waiting
+
+// RUN: env CINDEXTEST_CONCURRENT_QUERIES=1 CINDEXTEST_EDITING=1 c-index-test -test-annotate-tokens=%s:3:1:5:33 %s -I %S/Inputs | FileCheck -check-prefix=CHECK-TOKENS %s
+// CHECK-TOKENS: Keyword: "typedef" [3:1 - 3:8] TypedefDecl=Unused:3:16 (Definition)
+// CHECK-TOKENS: Identifier: "Unused" [3:16 - 3:22] TypedefDecl=Unused:3:16 (Definition)
+// CHECK-TOKENS: Identifier: "HeaderInt" [4:12 - 4:21] TypeRef=HeaderInt:1:13
+// CHECK-TOKENS: Identifier: "v" [5:29 - 5:30] DeclRefExpr=v:5:17
+
+// RUN: env CINDEXTEST_EDITING=1 c-index-test -test-concurrent-queries 4 %s -I %S/Inputs | FileCheck -check-prefix=CHECK-THREADS %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-concurrent-queries 4 %s -I %S/Inputs | FileCheck -check-prefix=CHECK-THREADS %s
+// CHECK-THREADS: round 0: 4 threads agree on {{[1-9][0-9]*}} cursors and {{[1-9][0-9]*}} tokens
+// CHECK-THREADS-NEXT: round 1: 4 threads agree on {{[1-9][0-9]*}} cursors and {{[1-9][0-9]*}} tokens
@@ -0,0 +1,19 @@
+// RUN: c-index-test -test-load-source local %s > %t.eager
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source local %s > %t.lazy
+// RUN: diff %t.eager %t.lazy
+// RUN: FileCheck %s < %t.lazy
+
+// Replayed at the end of the file, this body would call the definition below
+// instead of the implicitly declared function.
+int f(void) { return later(1); }
+
+int later(int x) { return x; }
+
+// CHECK: lazy-function-bodies-later-decls.c:8:22: CallExpr=later:8:22
+
+// The body uses the type through a typedef, so it is parsed before the type is
+// completed even though it doesn't mention its name.
+struct S;
+typedef struct S T;
+int usesT(T *p) { return p->x; }
+struct S { int x; };
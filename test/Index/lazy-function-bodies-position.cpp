@@ -0,0 +1,41 @@
+// RUN: c-index-test -test-load-source local %s > %t.eager
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source local %s > %t.lazy
+// RUN: diff %t.eager %t.lazy
+// RUN: FileCheck %s < %t.lazy
+
+// Parsed on demand, these bodies still only see the declarations before them.
+void f(long);
+namespace N { struct S {}; void g(S, long); }
+
+void use(N::S s) {
+  f(1);
+  g(s, 1);
+}
+
+void f(int);
+namespace N { void g(S, int); }
+
+struct A {
+  int m() { return n(); }
+  int n() { return 0; }
+};
+
+// D is incomplete in useD, so D* only converts to void*.
+struct Base {};
+struct D;
+void h(Base *);
+void h(void *);
+void useD(D *d) { h(d); }
+struct D : Base {};
+
+// The body is parsed from within P, but not in its scope.
+namespace P { void q(int); }
+void q(long);
+void useQ() { q(1); }
+namespace P { void q(int, int); }
+
+// CHECK: lazy-function-bodies-position.cpp:11:3: CallExpr=f:7:6
+// CHECK: lazy-function-bodies-position.cpp:12:3: CallExpr=g:8:33
+// CHECK: lazy-function-bodies-position.cpp:19:20: CallExpr=n:20:7
+// CHECK: lazy-function-bodies-position.cpp:28:19: CallExpr=h:27:6
+// CHECK: lazy-function-bodies-position.cpp:34:15: CallExpr=q:33:6
@@ -0,0 +1,9 @@
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source local %s > %t.out 2> %t.err
+// RUN: FileCheck %s < %t.out
+// RUN: FileCheck -check-prefix=CHECK-DIAGS %s < %t.err
+
+// CHECK: lazy-function-bodies-unterminated.c:9:3: ReturnStmt= Extent=[9:3 - 9:11]
+// CHECK-DIAGS: error: expected '}'
+
+int f(void) {
+  return 0;
@@ -0,0 +1,13 @@
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source local %s -Wunused-function > %t.out 2> %t.err
+// RUN: FileCheck %s < %t.out
+// RUN: FileCheck -check-prefix=CHECK-DIAGS %s < %t.err
+
+static void unused(void) {}
+
+// Only the body of f uses helper, and it is left lazy.
+static void helper(void) {}
+void f(void) { helper(); }
+
+// CHECK: lazy-function-bodies-unused.c:9:16: CallExpr=helper:8:13
+// CHECK-DIAGS: lazy-function-bodies-unused.c:5:13: warning: unused function 'unused'
+// CHECK-DIAGS-NOT: helper
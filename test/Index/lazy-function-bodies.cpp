@@ -0,0 +1,33 @@
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source all %s -std=c++11 | FileCheck %s
+
+// Bodies visited after being parsed on demand have the same cursors as bodies
+// parsed up front.
+// RUN: c-index-test -test-load-source all %s -std=c++11 > %t.eager
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -test-load-source all %s -std=c++11 > %t.lazy
+// RUN: diff %t.eager %t.lazy
+
+namespace N {
+  int g(int x);
+
+  struct A {
+    int f() { return g(1); }
+  };
+}
+
+int N::g(int x) {
+  A a;
+  return x + a.f();
+}
+
+constexpr int h() { return 2; }
+
+// CHECK: lazy-function-bodies.cpp:13:9: CXXMethod=f:13:9 (Definition) Extent=[13:5 - 13:29]
+// CHECK: lazy-function-bodies.cpp:13:22: CallExpr=g:10:7 Extent=[13:22 - 13:26]
+// CHECK: lazy-function-bodies.cpp:17:8: FunctionDecl=g:17:8 (Definition) Extent=[17:1 - 20:2]
+// CHECK: lazy-function-bodies.cpp:18:5: VarDecl=a:18:5 (Definition) Extent=[18:3 - 18:6]
+// CHECK: lazy-function-bodies.cpp:19:14: CallExpr=f:13:9 Extent=[19:14 - 19:19]
+// CHECK: lazy-function-bodies.cpp:22:15: FunctionDecl=h:22:15 (Definition) Extent=[22:1 - 22:32]
+
+// Saving the translation unit parses the bodies that are still lazy.
+// RUN: env CINDEXTEST_LAZY_FUNCTION_BODIES=1 c-index-test -write-pch %t.ast %s -std=c++11
+// RUN: c-index-test -test-load-tu %t.ast all | FileCheck %s
@@ -0,0 +1,40 @@
+// Only the body of h changes; f is left lazy and keeps its diagnostic.
+// RUN: env CINDEXTEST_INCREMENTAL_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 2 local "-remap-file=%S/Inputs/reparse-function-bodies-1.c;%S/Inputs/reparse-function-bodies-2.c" %S/Inputs/reparse-function-bodies-1.c -Wunused-variable > %t.out 2> %t.err
+// RUN: FileCheck -check-prefix=BODY %s < %t.out
+// RUN: FileCheck -check-prefix=BODY-DIAGS %s < %t.err
+// BODY: reparse-function-bodies-1.c:4:7: VarDecl=unused:4:7 (Definition)
+// BODY: reparse-function-bodies-1.c:5:10: CallExpr=g:1:5
+// BODY: reparse-function-bodies-1.c:9:7: VarDecl=unused2:9:7 (Definition)
+// BODY-DIAGS: reparse-function-bodies-1.c:4:7: warning: unused variable 'unused'
+// BODY-DIAGS: reparse-function-bodies-1.c:9:7: warning: unused variable 'unused2'
+// BODY-DIAGS-NOT: warning
+
+// A changed signature makes it a full reparse.
+// RUN: env CINDEXTEST_INCREMENTAL_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 2 local "-remap-file=%S/Inputs/reparse-function-bodies-1.c;%S/Inputs/reparse-function-bodies-3.c" %S/Inputs/reparse-function-bodies-1.c -Wunused-variable > %t.out 2> %t.err
+// RUN: FileCheck -check-prefix=SIGNATURE %s < %t.out
+// RUN: FileCheck -check-prefix=SIGNATURE-DIAGS %s < %t.err
+// SIGNATURE: reparse-function-bodies-1.c:4:7: VarDecl=unused:4:7 (Definition)
+// SIGNATURE: reparse-function-bodies-1.c:8:6: FunctionDecl=h:8:6 (Definition)
+// SIGNATURE-DIAGS: reparse-function-bodies-1.c:4:7: warning: unused variable 'unused'
+// SIGNATURE-DIAGS-NOT: warning
+
+// The note of a diagnostic at file scope points into f, which has to be
+// parsed again to report it again. g is left lazy but still uses helper.
+// RUN: env CINDEXTEST_INCREMENTAL_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 2 local "-remap-file=%S/Inputs/reparse-function-bodies-4.c;%S/Inputs/reparse-function-bodies-5.c" %S/Inputs/reparse-function-bodies-4.c -Wunused-variable -Wunused-function > %t.out 2> %t.err
+// RUN: FileCheck -check-prefix=NOTE %s < %t.out
+// RUN: FileCheck -check-prefix=NOTE-DIAGS %s < %t.err
+// NOTE: reparse-function-bodies-4.c:5:3: CallExpr=undefined:1:13
+// NOTE-DIAGS-NOT: unused function
+// NOTE-DIAGS: reparse-function-bodies-4.c:1:13: warning: function 'undefined' has internal linkage but is not defined
+// NOTE-DIAGS: reparse-function-bodies-4.c:5:3: note: used here
+// NOTE-DIAGS-NOT: unused function
+
+// f instantiates twice<int>, which is what uses helper. A parse that left f
+// lazy wouldn't instantiate it, so f is parsed again.
+// RUN: env CINDEXTEST_INCREMENTAL_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 2 local "-remap-file=%S/Inputs/reparse-function-bodies-6.cpp;%S/Inputs/reparse-function-bodies-7.cpp" %S/Inputs/reparse-function-bodies-6.cpp -Wunused-variable -Wunused-function > %t.out 2> %t.err
+// RUN: FileCheck -check-prefix=INSTANTIATION %s < %t.out
+// RUN: FileCheck -check-prefix=INSTANTIATION-DIAGS %s < %t.err
+// INSTANTIATION: reparse-function-bodies-6.cpp:5:10: CallExpr=twice:2:25
+// INSTANTIATION-DIAGS-NOT: unused function
+// INSTANTIATION-DIAGS: reparse-function-bodies-6.cpp:9:7: warning: unused variable 'unused2'
+// INSTANTIATION-DIAGS-NOT: unused function
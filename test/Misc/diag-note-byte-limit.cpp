@@ -0,0 +1,18 @@
+// RUN: not %clang_cc1 -fsyntax-only -ftemplate-depth 5 -fdiagnostics-note-byte-limit 1 %s 2>&1 | FileCheck %s
+// RUN: not %clang_cc1 -fsyntax-only -ftemplate-depth 5 %s 2>&1 | FileCheck -check-prefix=ALL %s
+
+template<typename T> struct X : X<T*> { };
+
+void test() {
+  (void)sizeof(X<int>);
+}
+
+// CHECK: error: recursive template instantiation exceeded maximum depth of 5
+// CHECK-NEXT: template<typename T> struct X : X<T*> { };
+// CHECK-NEXT: ^
+// CHECK-NEXT: note: (dropping remaining notes; use -fdiagnostics-note-byte-limit=0 to see all)
+// CHECK-NOT: note:
+
+// ALL: error: recursive template instantiation exceeded maximum depth of 5
+// ALL: note: in instantiation of template class
+// ALL: note: use -ftemplate-depth=N to increase recursive template instantiation depth
@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -fsyntax-only -Wunused-function -verify %s
+// RUN: %clang_cc1 -fsyntax-only -Wunused-function -print-stats %s 2>&1 | FileCheck %s
+
+// -Wunused-function is diagnosed at the end of the translation unit, so each
+// query below looks up the diagnostic state of a location in an earlier
+// pragma region.
+
+static void f0(void) {} // expected-warning {{unused function 'f0'}}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+static void f1(void) {}
+static void f2(void) {}
+#pragma clang diagnostic pop
+
+static void f3(void) {} // expected-warning {{unused function 'f3'}}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+static void f4(void) {}
+#pragma clang diagnostic pop
+
+static void f5(void) {} // expected-warning {{unused function 'f5'}}
+static void f6(void) {} // expected-warning {{unused function 'f6'}}
+
+// CHECK: *** Diagnostic Stats:
+// CHECK: diagnostic state points
+// CHECK: diagnostics with location-dependent mappings.
+// CHECK: diagnostic level queries, {{[0-9]+}} state point lookups, {{[0-9]+}} state range cache hits.
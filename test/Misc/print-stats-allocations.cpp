@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+template<typename T> struct X {
+  T get() { return T(); }
+};
+
+int f() {
+  X<int> x;
+  return x.get();
+}
+
+// CHECK: *** AST Allocation Stats:
+// CHECK: bytes in {{[0-9]+}} allocations by parse
+// CHECK: bytes in {{[0-9]+}} decl allocations
+// CHECK: bytes in {{[0-9]+}} allocations by template instantiation
+// CHECK: bytes total for stmt/expr allocations
+// CHECK: Total bytes = {{[0-9]+}} in {{[0-9]+}} allocations
@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -o /dev/null -print-stats %s 2>&1 | FileCheck %s
+
+struct A { virtual void f(); int a; };
+struct B { virtual void f(); int b; };
+struct C : A, B { virtual void f(); };
+
+void C::f() {}
+
+void use(C *c) {
+  c->f();
+}
+
+// The thunk for C::f in B's part of C's vtable is named once when the thunk
+// is emitted and found in the cache when the vtable refers to it. Only C's
+// type name is emitted; A's and B's RTTI is external.
+
+// CHECK: *** IR Generation Stats:
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} mangled name lookups hit the cache
+// CHECK: {{^}}  1/2 thunk name lookups hit the cache
+// CHECK: {{^}}  0/1 RTTI name lookups hit the cache
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} non-record type conversions hit the cache
+// CHECK: {{[0-9]+}}/{{[0-9]+}} record type conversions needed no layout
+// CHECK: {{[0-9]+}}/{{[0-9]+}} CGRecordLayout lookups hit the cache
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} function info arrangements hit the cache
@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+namespace N {
+  template<typename T> struct Many { };
+  template<typename T> struct Few { };
+}
+
+template<typename T> void f(T) { }
+
+N::Many<int> m1;
+N::Many<float> m2;
+N::Many<double> m3;
+N::Many<int> m4;
+N::Few<char> f1;
+
+void g() {
+  f(1);
+  f('a');
+}
+
+// CHECK: *** Template Specialization Stats:
+// CHECK: specialization lookups found an existing specialization
+// CHECK: 6 specializations of 3 templates
+// CHECK-NEXT: 3 N::Many
+// CHECK-NEXT: 2 f
+// CHECK-NEXT: 1 N::Few
@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -Wall -fsyntax-only %s -serialize-diagnostic-file %t
+// RUN: c-index-test -read-diagnostics %t 2>&1 | FileCheck %s
+// RUN: llvm-bcanalyzer -dump %t | FileCheck -check-prefix=RECORDS %s
+// RUN: rm -f %t
+
+// Diagnostics are streamed out one at a time, and each file name is written
+// once no matter how many diagnostics refer to it.
+
+#line 100 "generated-a.h"
+void a1() { int x; x = x + 1; }
+#line 200 "generated-b.h"
+void b1() { int y; y = y + 1; }
+#line 300 "generated-a.h"
+void a2() { int z; z = z + 1; }
+
+// CHECK: generated-a.h:100:24: warning: variable 'x' is uninitialized when used here
+// CHECK: generated-b.h:200:24: warning: variable 'y' is uninitialized when used here
+// CHECK: generated-a.h:300:24: warning: variable 'z' is uninitialized when used here
+// CHECK: Number of diagnostics: 3
+
+// Two distinct file names, so exactly two FileName records.
+// RECORDS: <FileName
+// RECORDS: <DiagInfo
+// RECORDS: <FileName
+// RECORDS: <DiagInfo
+// RECORDS-NOT: <FileName
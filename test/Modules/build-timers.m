@@ -0,0 +1,11 @@
+// Importing diamond_bottom builds the rest of the diamond from within its
+// own build; only the outermost build is timed.
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs -fsyntax-only -ftime-report %s 2>&1 | FileCheck %s
+// FIXME: When we have a syntax for modules in C, use that.
+
+@__experimental_modules_import diamond_bottom;
+
+// CHECK: Clang module builds
+// CHECK: Building modules
+// CHECK-NOT: Building modules
@@ -0,0 +1,23 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs -fmodules-cache-stats -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-BUILD %s
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs -fmodules-cache-stats -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-CACHED %s
+
+// Make the cache look like it hasn't been pruned or used in years, then
+// check that the stale module file is removed and rebuilt.
+// RUN: touch -m -a -t 201001010000 %t/modules.timestamp
+// RUN: touch -m -a -t 201001010000 %t/*/diamond_top.pcm
+// RUN: %clang_cc1 -fmodules -fmodule-cache-path %t -I %S/Inputs -fmodules-cache-stats -fmodules-prune-interval=1 -fmodules-prune-after=1 -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-BUILD %s
+
+// REQUIRES: shell
+
+@__experimental_modules_import diamond_top;
+
+int test(int i) { return top(&i); }
+
+// CHECK-BUILD: *** Module Cache Stats:
+// CHECK-BUILD-NEXT: 0 module cache hits
+// CHECK-BUILD-NEXT: 1 module cache misses
+
+// CHECK-CACHED: *** Module Cache Stats:
+// CHECK-CACHED-NEXT: 1 module cache hits
+// CHECK-CACHED-NEXT: 0 module cache misses
@@ -4,3 +4,7 @@
 // CHECK-NO_MODULE_CACHE: {{clang.*"-fmodule-cache-path"}}
 
 // CHECK-WITH_MODULE_CACHE: {{clang.*"-fmodule-cache-path" "blarg"}}
+
+// RUN: %clang -fmodules-prune-interval=100 -fmodules-prune-after=200 -fmodules-cache-max-size=300 -fmodules-cache-stats %s -### 2>&1 | FileCheck -check-prefix PRUNE %s
+
+// CHECK-PRUNE: {{clang.*"-fmodules-prune-interval=100" "-fmodules-prune-after=200" "-fmodules-cache-max-size=300" "-fmodules-cache-stats"}}
@@ -0,0 +1,38 @@
+// Test this without pch.
+// RUN: %clang_cc1 -std=c++11 -include %s -triple x86_64-unknown-linux-gnu -emit-llvm -o - %s | FileCheck %s
+
+// Test with pch.
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-unknown-linux-gnu -emit-pch -o %t %s
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-unknown-linux-gnu -include-pch %t -emit-llvm -o - %s | FileCheck %s
+
+// The overloaded operator of a dependent CXXOperatorCallExpr is mangled into
+// the signature, so it has to survive the round trip through the PCH.
+
+#ifndef HEADER
+#define HEADER
+
+struct S { int value; };
+
+S operator+(S, int);
+S operator~(S);
+S operator->*(S, int);
+
+template<typename T> auto plus(T t) -> decltype(t + 1) { return t + 1; }
+template<typename T> auto compl_(T t) -> decltype(~t) { return ~t; }
+template<typename T> auto arrow_star(T t) -> decltype(t->*2) {
+  return t->*2;
+}
+
+#else
+
+void use(S s) {
+  plus(s);
+  compl_(s);
+  arrow_star(s);
+}
+
+// CHECK-DAG: define linkonce_odr {{.*}}@_Z4plusI1SEDTplfp_
+// CHECK-DAG: define linkonce_odr {{.*}}@_Z6compl_I1SEDTcofp_
+// CHECK-DAG: define linkonce_odr {{.*}}@_Z10arrow_starI1SEDTpmfp_
+
+#endif
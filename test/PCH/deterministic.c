@@ -0,0 +1,37 @@
+// Check that writing the same PCH twice produces identical files.
+
+// RUN: %clang_cc1 -x c-header -emit-pch -o %t.1.pch %s
+// RUN: %clang_cc1 -x c-header -emit-pch -o %t.2.pch %s
+// RUN: cmp %t.1.pch %t.2.pch
+
+// RUN: %clang_cc1 -x objective-c-header -emit-pch -o %t.1.pch %s
+// RUN: %clang_cc1 -x objective-c-header -emit-pch -o %t.2.pch %s
+// RUN: cmp %t.1.pch %t.2.pch
+
+int alpha, beta, gamma, delta, epsilon;
+struct point { int x, y, z; };
+#define SQUARE(x) ((x) * (x))
+
+void f(void) {
+  extern int local_extern1;
+  extern int local_extern2;
+  extern int local_extern3;
+}
+
+#pragma weak weak_alpha
+#pragma weak weak_beta
+#pragma weak weak_gamma
+
+#ifdef __OBJC__
+@interface Root
+- (void)first;
+- (void)second:(int)x;
++ (id)third:(int)x with:(int)y;
+@end
+
+static inline void g(void) {
+  (void)@selector(first);
+  (void)@selector(second:);
+  (void)@selector(third:with:);
+}
+#endif
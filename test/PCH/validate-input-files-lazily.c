@@ -0,0 +1,27 @@
+// RUN: mkdir -p %t.dir
+// RUN: echo '#include "header2.h"' > %t.dir/header1.h
+// RUN: echo 'int header2_decl;' > %t.dir/header2.h
+// RUN: cp %s %t.dir/t.c
+// RUN: %clang_cc1 -x c-header %t.dir/header1.h -emit-pch -o %t.pch
+// RUN: echo >> %t.dir/header2.h
+
+// By default every input file of the PCH is checked when it is loaded.
+// RUN: not %clang_cc1 %t.dir/t.c -include-pch %t.pch -fsyntax-only 2>&1 | FileCheck %s
+
+// With lazy validation, the modified header is never looked at.
+// RUN: %clang_cc1 %t.dir/t.c -include-pch %t.pch -fsyntax-only \
+// RUN:   -fpch-validate-input-files-lazily
+
+// It is still caught as soon as something from it is used, here by the note
+// pointing at the previous declaration.
+// RUN: not %clang_cc1 %t.dir/t.c -include-pch %t.pch -fsyntax-only \
+// RUN:   -fpch-validate-input-files-lazily -DREDECLARE 2>&1 | FileCheck %s
+
+int main() { return 0; }
+
+#ifdef REDECLARE
+float header2_decl;
+#endif
+
+// CHECK: fatal error: file {{.*}}header2.h{{.*}} has been modified since the precompiled header was built
+// REQUIRES: shell
@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -E -trigraphs %s -o - | FileCheck -strict-whitespace %s
+
+// Punctuators are printed as spelled in the source. Digraphs are kept, while
+// trigraphs and escaped newlines are cleaned.
+
+A: a += b; c <<= d; e->f; g ... h
+// CHECK: A: a += b; c <<= d; e->f; g ... h
+
+B: <: :> <% %> %: %:%:
+// CHECK: B: <: :> <% %> %: %:%:
+
+C: ??= ??( ??)
+// CHECK: C: # [ ]
+
+D: x +\
+= y
+// CHECK: D: x += y
+
+#define PLUS_EQ +=
+E: z PLUS_EQ w
+// CHECK: E: z += w
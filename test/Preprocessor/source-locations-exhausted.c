@@ -0,0 +1,53 @@
+// RUN: not %clang_cc1 -Eonly -source-location-limit 100000 %s 2>&1 \
+// RUN:   | FileCheck %s
+
+// Expanding BIG a thousand times needs more source locations than the limit
+// allows, since each expansion takes as many as the definition is long.
+
+// CHECK: fatal error: ran out of source locations
+// CHECK-NOT: error:
+
+#define BIG a /*
+  The comment only makes the definition of BIG long enough.  00
+  The comment only makes the definition of BIG long enough.  01
+  The comment only makes the definition of BIG long enough.  02
+  The comment only makes the definition of BIG long enough.  03
+  The comment only makes the definition of BIG long enough.  04
+  The comment only makes the definition of BIG long enough.  05
+  The comment only makes the definition of BIG long enough.  06
+  The comment only makes the definition of BIG long enough.  07
+  The comment only makes the definition of BIG long enough.  08
+  The comment only makes the definition of BIG long enough.  09
+  The comment only makes the definition of BIG long enough.  10
+  The comment only makes the definition of BIG long enough.  11
+  The comment only makes the definition of BIG long enough.  12
+  The comment only makes the definition of BIG long enough.  13
+  The comment only makes the definition of BIG long enough.  14
+  The comment only makes the definition of BIG long enough.  15
+  The comment only makes the definition of BIG long enough.  16
+  The comment only makes the definition of BIG long enough.  17
+  The comment only makes the definition of BIG long enough.  18
+  The comment only makes the definition of BIG long enough.  19
+  The comment only makes the definition of BIG long enough.  20
+  The comment only makes the definition of BIG long enough.  21
+  The comment only makes the definition of BIG long enough.  22
+  The comment only makes the definition of BIG long enough.  23
+  The comment only makes the definition of BIG long enough.  24
+  The comment only makes the definition of BIG long enough.  25
+  The comment only makes the definition of BIG long enough.  26
+  The comment only makes the definition of BIG long enough.  27
+  The comment only makes the definition of BIG long enough.  28
+  The comment only makes the definition of BIG long enough.  29
+  The comment only makes the definition of BIG long enough.  30
+  The comment only makes the definition of BIG long enough.  31
+  The comment only makes the definition of BIG long enough.  32
+  The comment only makes the definition of BIG long enough.  33
+  The comment only makes the definition of BIG long enough.  34
+  */ b
+#define X1 BIG BIG BIG BIG
+#define X2 X1 X1 X1 X1
+#define X3 X2 X2 X2 X2
+#define X4 X3 X3 X3 X3
+#define X5 X4 X4 X4 X4
+
+X5
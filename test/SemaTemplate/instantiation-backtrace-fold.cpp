@@ -0,0 +1,14 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -ftemplate-depth 10 -ftemplate-backtrace-fold %s
+// RUN: %clang -fsyntax-only -Xclang -verify -ftemplate-depth=10 -ftemplate-backtrace-fold %s
+
+// Recursive instantiation produces a run of contexts with the same point of
+// instantiation; they are folded into a single note.
+template<typename T> struct X : X<T*> { }; \
+// expected-error{{recursive template instantiation exceeded maximum depth of 10}} \
+// expected-note {{instantiation of template class}} \
+// expected-note {{folding 9 more contexts instantiated at this point}} \
+// expected-note {{use -ftemplate-depth=N to increase recursive template instantiation depth}}
+
+void test() {
+  (void)sizeof(X<int>); // expected-note {{instantiation of template class}}
+}
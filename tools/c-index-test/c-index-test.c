@@ -9,6 +9,11 @@
 #include <string.h>
 #include <assert.h>
 
+#if ENABLE_THREADS && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#define CINDEXTEST_HAVE_THREADS 1
+#endif
+
 #ifdef CLANG_HAVE_LIBXML
 #include <libxml/parser.h>
 #include <libxml/relaxng.h>
@@ -66,6 +71,12 @@ static unsigned getDefaultParsingOptions() {
     options &= ~CXTranslationUnit_CacheCompletionResults;
   if (getenv("CINDEXTEST_SKIP_FUNCTION_BODIES"))
     options |= CXTranslationUnit_SkipFunctionBodies;
+  if (getenv("CINDEXTEST_LAZY_FUNCTION_BODIES"))
+    options |= CXTranslationUnit_LazyFunctionBodies;
+  if (getenv("CINDEXTEST_INCREMENTAL_FUNCTION_BODIES"))
+    options |= CXTranslationUnit_IncrementalFunctionBodies;
+  if (getenv("CINDEXTEST_CONCURRENT_QUERIES"))
+    options |= CXTranslationUnit_ConcurrentQueries;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     options |= CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
   
@@ -1731,11 +1742,15 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   CXTranslationUnit TU = 0;
   unsigned I, Repeats = 1;
   unsigned completionOptions = clang_defaultCodeCompleteOptions();
+  const char *completionFilter = getenv("CINDEXTEST_COMPLETION_FILTER");
+  unsigned filterOptions = 0;
   
   if (getenv("CINDEXTEST_CODE_COMPLETE_PATTERNS"))
     completionOptions |= CXCodeComplete_IncludeCodePatterns;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     completionOptions |= CXCodeComplete_IncludeBriefComments;
+  if (getenv("CINDEXTEST_COMPLETION_FILTER_FUZZY"))
+    filterOptions |= CXCodeCompleteFilter_Fuzzy;
   
   if (timing_only)
     input += strlen("-code-completion-timing=");
@@ -1790,6 +1805,25 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
       /* Sort the code-completion results based on the typed text. */
       clang_sortCodeCompletionResults(results->Results, results->NumResults);
 
+      /* Filter them as if each of the comma-separated filters was typed
+         one character at a time. */
+      if (completionFilter) {
+        char *typed = (char *)malloc(strlen(completionFilter) + 1);
+        const char *c;
+        unsigned len = 0;
+        for (c = completionFilter; *c; ++c) {
+          if (*c == ',') {
+            len = 0;
+            continue;
+          }
+          typed[len++] = *c;
+          typed[len] = 0;
+          clang_codeCompleteFilterResults(results, typed, filterOptions);
+        }
+        free(typed);
+        n = results->NumResults;
+      }
+
       for (i = 0; i != n; ++i)
         print_completion_result(results->Results + i, stdout);
     }
@@ -2739,6 +2773,196 @@ int perform_token_annotation(int argc, const char **argv) {
   return errorCode;
 }
 
+/******************************************************************************/
+/* Logic for testing concurrent queries.                                      */
+/******************************************************************************/
+
+/* The results of one thread's queries, folded into a hash so that the main
+ * thread can compare them with what a serial run produced. */
+typedef struct {
+  CXTranslationUnit TU;
+  CXFile main_file;
+  unsigned num_cursors;
+  unsigned num_tokens;
+  unsigned long hash;
+} concurrent_query_info;
+
+static void hash_concurrent_query_value(concurrent_query_info *info,
+                                        unsigned value) {
+  info->hash = info->hash * 31 + value;
+}
+
+static void hash_concurrent_query_cursor(concurrent_query_info *info,
+                                         CXCursor cursor) {
+  CXFile file;
+  unsigned line, column;
+
+  clang_getSpellingLocation(clang_getCursorLocation(cursor), &file, &line,
+                            &column, 0);
+  hash_concurrent_query_value(info, cursor.kind);
+  hash_concurrent_query_value(info, file == info->main_file);
+  hash_concurrent_query_value(info, line);
+  hash_concurrent_query_value(info, column);
+}
+
+static enum CXChildVisitResult
+ConcurrentQueryVisitor(CXCursor cursor, CXCursor parent, CXClientData data) {
+  concurrent_query_info *info = (concurrent_query_info *)data;
+  ++info->num_cursors;
+  hash_concurrent_query_cursor(info, cursor);
+  return CXChildVisit_Recurse;
+}
+
+/* Visit the whole translation unit, then annotate every token of the main
+ * file and look up the cursor at each of them. */
+static void run_concurrent_queries(concurrent_query_info *info) {
+  CXCursor tu_cursor = clang_getTranslationUnitCursor(info->TU);
+  CXToken *tokens;
+  CXCursor *cursors;
+  unsigned i;
+
+  clang_visitChildren(tu_cursor, ConcurrentQueryVisitor, info);
+
+  clang_tokenize(info->TU, clang_getCursorExtent(tu_cursor), &tokens,
+                 &info->num_tokens);
+  cursors = (CXCursor *)malloc(info->num_tokens * sizeof(CXCursor));
+  clang_annotateTokens(info->TU, tokens, info->num_tokens, cursors);
+  for (i = 0; i != info->num_tokens; ++i) {
+    CXSourceLocation loc = clang_getTokenLocation(info->TU, tokens[i]);
+    hash_concurrent_query_value(info, clang_getTokenKind(tokens[i]));
+    hash_concurrent_query_cursor(info, cursors[i]);
+    hash_concurrent_query_cursor(info, clang_getCursor(info->TU, loc));
+  }
+  free(cursors);
+  clang_disposeTokens(info->TU, tokens, info->num_tokens);
+}
+
+#ifdef CINDEXTEST_HAVE_THREADS
+static void *concurrent_query_thread(void *data) {
+  run_concurrent_queries((concurrent_query_info *)data);
+  return 0;
+}
+#endif
+
+/* Run the same queries on several threads at once against one translation
+ * unit, reparse it, and do it again. Every thread must see what a serial run
+ * on the main thread sees. */
+static int perform_concurrent_queries(int argc, const char **argv) {
+  CXIndex Idx;
+  CXTranslationUnit TU;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  int num_threads;
+  int round, i;
+  int result = 0;
+  concurrent_query_info expected;
+  concurrent_query_info *infos;
+#ifdef CINDEXTEST_HAVE_THREADS
+  pthread_t *threads;
+  int num_started;
+#endif
+
+  num_threads = atoi(argv[2]);
+  if (num_threads < 1) {
+    fprintf(stderr, "invalid number of threads '%s'\n", argv[2]);
+    return -1;
+  }
+
+  if (parse_remapped_files(argc, argv, 3, &unsaved_files, &num_unsaved_files))
+    return -1;
+
+  Idx = clang_createIndex(/* excludeDeclsFromPCH */0,
+                          /* displayDiagnosics=*/0);
+  TU = clang_parseTranslationUnit(Idx, 0,
+                                  argv + num_unsaved_files + 3,
+                                  argc - num_unsaved_files - 3,
+                                  unsaved_files, num_unsaved_files,
+                                  getDefaultParsingOptions() |
+                                    CXTranslationUnit_ConcurrentQueries);
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    free_remapped_files(unsaved_files, num_unsaved_files);
+    clang_disposeIndex(Idx);
+    return 1;
+  }
+
+  infos = (concurrent_query_info *)malloc(num_threads * sizeof(*infos));
+#ifdef CINDEXTEST_HAVE_THREADS
+  threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+#endif
+
+  for (round = 0; round != 2 && result == 0; ++round) {
+    if (round != 0 &&
+        clang_reparseTranslationUnit(TU, num_unsaved_files, unsaved_files,
+                                     clang_defaultReparseOptions(TU))) {
+      fprintf(stderr, "Unable to reparse translation unit!\n");
+      result = -1;
+      break;
+    }
+
+    if (checkForErrors(TU) != 0) {
+      result = -1;
+      break;
+    }
+
+    memset(&expected, 0, sizeof(expected));
+    expected.TU = TU;
+    clang_getSpellingLocation(
+        clang_getRangeStart(
+          clang_getCursorExtent(clang_getTranslationUnitCursor(TU))),
+        &expected.main_file, 0, 0, 0);
+    run_concurrent_queries(&expected);
+
+    for (i = 0; i != num_threads; ++i) {
+      memset(&infos[i], 0, sizeof(infos[i]));
+      infos[i].TU = TU;
+      infos[i].main_file = expected.main_file;
+    }
+
+#ifdef CINDEXTEST_HAVE_THREADS
+    for (num_started = 0; num_started != num_threads; ++num_started) {
+      if (pthread_create(&threads[num_started], 0, concurrent_query_thread,
+                         &infos[num_started]))
+        break;
+    }
+    /* If we ran out of threads, run the remaining queries on this one. */
+    for (i = num_started; i != num_threads; ++i)
+      run_concurrent_queries(&infos[i]);
+    for (i = 0; i != num_started; ++i)
+      pthread_join(threads[i], 0);
+#else
+    for (i = 0; i != num_threads; ++i)
+      run_concurrent_queries(&infos[i]);
+#endif
+
+    for (i = 0; i != num_threads; ++i) {
+      if (infos[i].num_cursors != expected.num_cursors ||
+          infos[i].num_tokens != expected.num_tokens ||
+          infos[i].hash != expected.hash) {
+        printf("round %d: thread %d saw %u cursors and %u tokens, "
+               "expected %u cursors and %u tokens%s\n", round, i,
+               infos[i].num_cursors, infos[i].num_tokens,
+               expected.num_cursors, expected.num_tokens,
+               infos[i].hash != expected.hash ? " (results differ)" : "");
+        result = -1;
+      }
+    }
+    if (result == 0)
+      printf("round %d: %d threads agree on %u cursors and %u tokens\n",
+             round, num_threads, expected.num_cursors, expected.num_tokens);
+  }
+
+#ifdef CINDEXTEST_HAVE_THREADS
+  free(threads);
+#endif
+  free(infos);
+  PrintDiagnostics(TU);
+  clang_disposeTranslationUnit(TU);
+  clang_disposeIndex(Idx);
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  return result;
+}
+
 static int
 perform_test_compilation_db(const char *database, int argc, const char **argv) {
   CXCompilationDatabase db;
@@ -3002,6 +3226,7 @@ int write_pch_file(const char *filename, int argc, const char *argv[]) {
   struct CXUnsavedFile *unsaved_files = 0;
   int num_unsaved_files = 0;
   int result = 0;
+  unsigned options = CXTranslationUnit_Incomplete;
   
   Idx = clang_createIndex(/* excludeDeclsFromPCH */1, /* displayDiagnosics=*/1);
   
@@ -3009,13 +3234,16 @@ int write_pch_file(const char *filename, int argc, const char *argv[]) {
     clang_disposeIndex(Idx);
     return -1;
   }
+
+  if (getenv("CINDEXTEST_LAZY_FUNCTION_BODIES"))
+    options |= CXTranslationUnit_LazyFunctionBodies;
   
   TU = clang_parseTranslationUnit(Idx, 0,
                                   argv + num_unsaved_files,
                                   argc - num_unsaved_files,
                                   unsaved_files,
                                   num_unsaved_files,
-                                  CXTranslationUnit_Incomplete);
+                                  options);
   if (!TU) {
     fprintf(stderr, "Unable to load translation unit!\n");
     free_remapped_files(unsaved_files, num_unsaved_files);
@@ -3253,6 +3481,7 @@ static void print_usage(void) {
     "       c-index-test -test-load-source-usrs-memory-usage "
           "<symbol filter> {<args>}*\n"
     "       c-index-test -test-annotate-tokens=<range> {<args>}*\n"
+    "       c-index-test -test-concurrent-queries <threads> {<args>}*\n"
     "       c-index-test -test-inclusion-stack-source {<args>}*\n"
     "       c-index-test -test-inclusion-stack-tu <AST file>\n");
   fprintf(stderr,
@@ -3325,6 +3554,8 @@ int cindextest_main(int argc, const char **argv) {
                              argc >= 5 ? argv[4] : 0);
   else if (argc > 2 && strstr(argv[1], "-test-annotate-tokens=") == argv[1])
     return perform_token_annotation(argc, argv);
+  else if (argc > 3 && strcmp(argv[1], "-test-concurrent-queries") == 0)
+    return perform_concurrent_queries(argc, argv);
   else if (argc > 2 && strcmp(argv[1], "-test-inclusion-stack-source") == 0)
     return perform_test_load_source(argc - 2, argv + 2, "all", NULL,
                                     PrintInclusionStack);
@@ -209,7 +209,12 @@ static bool visitPreprocessedEntitiesInRange(SourceRange R,
   }
 
   std::pair<PreprocessingRecord::iterator, PreprocessingRecord::iterator>
+    Entities;
+  {
+    // The preprocessing record caches the last range it was asked about.
+    ASTUnit::LazyStateGuard Guard(*Visitor.getASTUnit());
     Entities = PPRec.getPreprocessedEntitiesInRange(R);
+  }
   return Visitor.visitPreprocessedEntities(Entities.first, Entities.second,
                                            PPRec, FID);
 }
@@ -753,8 +758,12 @@ bool CursorVisitor::VisitFunctionDecl(FunctionDecl *ND) {
     
     // FIXME: Attributes?
   }
-  
-  if (ND->doesThisDeclarationHaveABody() && !ND->isLateTemplateParsed()) {
+
+  // A body skipped by CXTranslationUnit_LazyFunctionBodies is parsed by the
+  // entry point before the traversal starts; the traversal itself never
+  // changes the AST, so a body that is still lazy here is not visited.
+  if (ND->doesThisDeclarationHaveABody() && !ND->isLateTemplateParsed() &&
+      !ND->hasUnparsedCachedBody()) {
     if (CXXConstructorDecl *Constructor = dyn_cast<CXXConstructorDecl>(ND)) {
       // Find the initializers that were written in the source.
       SmallVector<CXXCtorInitializer *, 4> WrittenInits;
@@ -2551,6 +2560,10 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
   bool IncludeBriefCommentsInCodeCompletion
     = options & CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
   bool SkipFunctionBodies = options & CXTranslationUnit_SkipFunctionBodies;
+  bool LazyFunctionBodies = options & CXTranslationUnit_LazyFunctionBodies;
+  bool IncrementalFunctionBodies
+    = options & CXTranslationUnit_IncrementalFunctionBodies;
+  bool ConcurrentQueries = options & CXTranslationUnit_ConcurrentQueries;
 
   // Configure the diagnostics.
   DiagnosticOptions DiagOpts;
@@ -2637,6 +2650,9 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
                                  IncludeBriefCommentsInCodeCompletion,
                                  /*AllowPCHWithCompilerErrors=*/true,
                                  SkipFunctionBodies,
+                                 LazyFunctionBodies,
+                                 IncrementalFunctionBodies,
+                                 ConcurrentQueries,
                                  /*UserFilesAreVolatile=*/true,
                                  &ErrUnit));
 
@@ -2764,6 +2780,8 @@ void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
     if (static_cast<ASTUnit *>(CTUnit->TUData)->isUnsafeToFree())
       return;
 
+    // The locks for concurrent queries live in the ASTUnit, so they can't
+    // keep other threads out while it is destroyed; the client has to.
     delete static_cast<ASTUnit *>(CTUnit->TUData);
     disposeCXStringPool(CTUnit->StringPool);
     delete static_cast<CXDiagnosticSetImpl *>(CTUnit->Diagnostics);
@@ -2989,7 +3007,14 @@ extern "C" {
 unsigned clang_visitChildren(CXCursor parent,
                              CXCursorVisitor visitor,
                              CXClientData client_data) {
-  CursorVisitor CursorVis(getCursorTU(parent), visitor, client_data,
+  CXTranslationUnit TU = getCursorTU(parent);
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
+  if (clang_isTranslationUnit(parent.kind))
+    CXXUnit->parseLazyFunctionBodies();
+  else if (clang_isDeclaration(parent.kind))
+    CXXUnit->parseLazyFunctionBodies(getCursorDecl(parent));
+  ASTUnit::ReadOnlyCheck Check(*CXXUnit);
+  CursorVisitor CursorVis(TU, visitor, client_data,
                           /*VisitPreprocessorLast=*/false);
   return CursorVis.VisitChildren(parent);
 }
@@ -3757,9 +3782,11 @@ CXCursor clang_getCursor(CXTranslationUnit TU, CXSourceLocation Loc) {
     return clang_getNullCursor();
 
   ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU->TUData);
-  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
-
   SourceLocation SLoc = cxloc::translateSourceLocation(Loc);
+  if (SLoc.isValid())
+    CXXUnit->parseLazyFunctionBodies(SourceRange(SLoc));
+  ASTUnit::ReadOnlyCheck Check(*CXXUnit);
+
   CXCursor Result = cxcursor::getCursor(TU, SLoc);
 
   bool Logging = getenv("LIBCLANG_LOGGING");  
@@ -4764,9 +4791,13 @@ static void getTokens(ASTUnit *CXXUnit, SourceRange Range,
       CXTok.int_data[0] = CXToken_Literal;
       CXTok.ptr_data = (void *)Tok.getLiteralData();
     } else if (Tok.is(tok::raw_identifier)) {
-      // Lookup the identifier to determine whether we have a keyword.
-      IdentifierInfo *II
-        = CXXUnit->getPreprocessor().LookUpIdentifierInfo(Tok);
+      // Lookup the identifier to determine whether we have a keyword. This
+      // adds identifiers that the parser never saw to the table.
+      IdentifierInfo *II;
+      {
+        ASTUnit::LazyStateGuard Guard(*CXXUnit);
+        II = CXXUnit->getPreprocessor().LookUpIdentifierInfo(Tok);
+      }
 
       if ((II->getObjCKeywordID() != tok::objc_not_keyword) && previousWasAt) {
         CXTok.int_data[0] = CXToken_Keyword;
@@ -4800,7 +4831,7 @@ void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
   if (!CXXUnit || !Tokens || !NumTokens)
     return;
 
-  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  ASTUnit::ReadOnlyCheck Check(*CXXUnit);
   
   SourceRange R = cxloc::translateCXSourceRange(Range);
   if (R.isInvalid())
@@ -5486,7 +5517,14 @@ void clang_annotateTokens(CXTranslationUnit TU,
   if (!CXXUnit)
     return;
 
-  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  // Parse the lazy bodies among the tokens before reading the AST.
+  CXXUnit->parseLazyFunctionBodies(
+    SourceRange(cxloc::translateSourceLocation(
+                  clang_getTokenLocation(TU, Tokens[0])),
+                cxloc::translateSourceLocation(
+                  clang_getTokenLocation(TU, Tokens[NumTokens-1]))));
+
+  ASTUnit::ReadOnlyCheck Check(*CXXUnit);
   
   clang_annotateTokens_Data data = { TU, CXXUnit, Tokens, NumTokens, Cursors };
   llvm::CrashRecoveryContext CRC;
@@ -296,6 +296,27 @@ struct AllocatedCXCodeCompleteResults : public CXCodeCompleteResults {
   /// \brief A string containing the Objective-C selector entered thus far for a
   /// message send.
   std::string Selector;
+
+  /// \brief Whether the results have been filtered, in which case the
+  /// members below have been set up.
+  bool Filtering;
+
+  /// \brief All of the code-completion results, in order of priority.
+  std::vector<CXCompletionResult> AllResults;
+
+  /// \brief The lowercased typed text of each of \c AllResults.
+  std::vector<std::string> TypedTexts;
+
+  /// \brief The indices of \c AllResults, in order of their typed text.
+  std::vector<unsigned> TypedTextIndex;
+
+  /// \brief The indices of the results that matched the last filter, in order
+  /// of priority.
+  std::vector<unsigned> FilteredResults;
+
+  /// \brief The last filter, lowercased, and the options it was applied with.
+  std::string Filter;
+  unsigned FilterOptions;
 };
 
 /// \brief Tracks the number of code-completion result objects that are 
@@ -316,7 +337,9 @@ AllocatedCXCodeCompleteResults::AllocatedCXCodeCompleteResults(
     Contexts(CXCompletionContext_Unknown),
     ContainerKind(CXCursor_InvalidCode),
     ContainerUSR(createCXString("")),
-    ContainerIsIncomplete(1)
+    ContainerIsIncomplete(1),
+    Filtering(false),
+    FilterOptions(0)
 { 
   if (getenv("LIBCLANG_OBJTRACKING")) {
     llvm::sys::AtomicIncrement(&CodeCompletionResultObjects);
@@ -990,3 +1013,135 @@ extern "C" {
     std::stable_sort(Results, Results + NumResults, OrderCompletionResults());
   }
 }
+
+namespace {
+  /// \brief Orders code-completion results by priority alone.
+  struct OrderCompletionResultsByPriority {
+    bool operator()(const CXCompletionResult &XR,
+                    const CXCompletionResult &YR) const {
+      CodeCompletionString *X
+        = (CodeCompletionString *)XR.CompletionString;
+      CodeCompletionString *Y
+        = (CodeCompletionString *)YR.CompletionString;
+      return X->getPriority() < Y->getPriority();
+    }
+  };
+
+  /// \brief Orders indices of code-completion results, and lookup keys, by
+  /// the typed text of the results.
+  class OrderByTypedText {
+    const std::vector<std::string> &TypedTexts;
+
+  public:
+    explicit OrderByTypedText(const std::vector<std::string> &TypedTexts)
+      : TypedTexts(TypedTexts) { }
+
+    bool operator()(unsigned X, unsigned Y) const {
+      return TypedTexts[X] < TypedTexts[Y];
+    }
+    bool operator()(unsigned X, const std::string &Y) const {
+      return TypedTexts[X] < Y;
+    }
+    bool operator()(const std::string &X, unsigned Y) const {
+      return X < TypedTexts[Y];
+    }
+  };
+}
+
+/// \brief Determine whether the typed text of a code-completion result
+/// matches the given filter.
+///
+/// The filter matches if it is a prefix of the text or, for a fuzzy match,
+/// if its characters appear in the text in order, starting with the first.
+static bool matchesCompletionFilter(StringRef Text, StringRef Filter,
+                                    bool Fuzzy) {
+  if (!Fuzzy || Filter.empty())
+    return Text.startswith(Filter);
+
+  if (Text.empty() || Text[0] != Filter[0])
+    return false;
+
+  size_t Pos = 1;
+  for (unsigned I = 1, N = Filter.size(); I != N; ++I) {
+    Pos = Text.find(Filter[I], Pos);
+    if (Pos == StringRef::npos)
+      return false;
+    ++Pos;
+  }
+  return true;
+}
+
+extern "C" {
+  void clang_codeCompleteFilterResults(CXCodeCompleteResults *ResultsIn,
+                                       const char *FilterText,
+                                       unsigned options) {
+    AllocatedCXCodeCompleteResults *Results
+      = static_cast<AllocatedCXCodeCompleteResults*>(ResultsIn);
+    if (!Results)
+      return;
+
+    // The first time around, keep the complete set of results, sort it by
+    // priority once, and index it by typed text.
+    if (!Results->Filtering) {
+      unsigned N = Results->NumResults;
+      Results->AllResults.assign(Results->Results, Results->Results + N);
+      std::stable_sort(Results->AllResults.begin(), Results->AllResults.end(),
+                       OrderCompletionResultsByPriority());
+
+      Results->TypedTexts.reserve(N);
+      for (unsigned I = 0; I != N; ++I) {
+        SmallString<256> Buffer;
+        CodeCompletionString *CCStr
+          = (CodeCompletionString *)Results->AllResults[I].CompletionString;
+        Results->TypedTexts.push_back(GetTypedName(CCStr, Buffer).lower());
+        Results->TypedTextIndex.push_back(I);
+        Results->FilteredResults.push_back(I);
+      }
+      std::sort(Results->TypedTextIndex.begin(), Results->TypedTextIndex.end(),
+                OrderByTypedText(Results->TypedTexts));
+      Results->Filtering = true;
+    }
+
+    std::string Filter = StringRef(FilterText ? FilterText : "").lower();
+    bool Fuzzy = options & CXCodeCompleteFilter_Fuzzy;
+    const std::vector<std::string> &TypedTexts = Results->TypedTexts;
+    std::vector<unsigned> Matches;
+    if (options == Results->FilterOptions &&
+        StringRef(Filter).startswith(Results->Filter)) {
+      // More characters were typed, so only the results that matched before
+      // can still match; they are already in order.
+      for (std::vector<unsigned>::iterator
+             I = Results->FilteredResults.begin(),
+             IEnd = Results->FilteredResults.end();
+           I != IEnd; ++I) {
+        if (matchesCompletionFilter(TypedTexts[*I], Filter, Fuzzy))
+          Matches.push_back(*I);
+      }
+    } else if (!Fuzzy) {
+      // Look the prefix up in the index and put the matches back in order of
+      // priority.
+      std::vector<unsigned>::iterator
+        I = std::lower_bound(Results->TypedTextIndex.begin(),
+                             Results->TypedTextIndex.end(), Filter,
+                             OrderByTypedText(TypedTexts));
+      for (; I != Results->TypedTextIndex.end() &&
+             StringRef(TypedTexts[*I]).startswith(Filter); ++I)
+        Matches.push_back(*I);
+      std::sort(Matches.begin(), Matches.end());
+    } else {
+      for (unsigned I = 0, N = TypedTexts.size(); I != N; ++I) {
+        if (matchesCompletionFilter(TypedTexts[I], Filter, Fuzzy))
+          Matches.push_back(I);
+      }
+    }
+
+    Results->FilteredResults.swap(Matches);
+    Results->Filter = Filter;
+    Results->FilterOptions = options;
+
+    // The Results array holds all of the results, so the matches fit.
+    Results->NumResults = Results->FilteredResults.size();
+    for (unsigned I = 0, N = Results->NumResults; I != N; ++I)
+      Results->Results[I] = Results->AllResults[Results->FilteredResults[I]];
+  }
+}
@@ -369,7 +369,18 @@ void clang_findReferencesInFile(CXCursor cursor, CXFile file,
   if (!CXXUnit)
     return;
 
-  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  // Parse the lazy bodies of the file before reading the AST. A cursor on a
+  // local declaration comes from a body that was parsed already.
+  if (cursor.kind != CXCursor_MacroDefinition &&
+      cursor.kind != CXCursor_MacroExpansion) {
+    SourceManager &SM = CXXUnit->getSourceManager();
+    FileID FID = SM.translateFile(static_cast<const FileEntry *>(file));
+    if (!FID.isInvalid())
+      CXXUnit->parseLazyFunctionBodies(
+        SourceRange(SM.getLocForStartOfFile(FID), SM.getLocForEndOfFile(FID)));
+  }
+
+  ASTUnit::ReadOnlyCheck Check(*CXXUnit);
 
   if (cursor.kind == CXCursor_MacroDefinition ||
       cursor.kind == CXCursor_MacroExpansion) {
@@ -851,6 +851,7 @@ CXString clang_getCursorUSR(CXCursor C) {
     if (!TU)
       return createCXString("");
 
+    ASTUnit::ReadOnlyCheck Check(*static_cast<ASTUnit *>(TU->TUData));
     CXStringBuf *buf = cxstring::getCXStringBuf(TU);
     if (!buf)
       return createCXString("");
@@ -872,6 +873,7 @@ CXString clang_getCursorUSR(CXCursor C) {
     if (!TU)
       return createCXString("");
 
+    ASTUnit::ReadOnlyCheck Check(*static_cast<ASTUnit *>(TU->TUData));
     CXStringBuf *buf = cxstring::getCXStringBuf(TU);
     if (!buf)
       return createCXString("");
@@ -23,6 +23,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
 #include <assert.h>
 
 using namespace clang;
@@ -41,6 +42,10 @@ public:
   virtual ~CXLoadedDiagnosticSetImpl() {}  
 
   llvm::StringRef makeString(const char *blob, unsigned blobLen);
+
+  /// \brief The (typically memory-mapped) contents of the diagnostics file,
+  /// which strings that are already null-terminated in it refer to.
+  OwningPtr<llvm::MemoryBuffer> Buffer;
   
   llvm::BumpPtrAllocator Alloc;
   Strings Categories;
@@ -55,6 +60,13 @@ public:
 
 llvm::StringRef CXLoadedDiagnosticSetImpl::makeString(const char *blob,
                                                       unsigned bloblen) {
+  // Blobs are padded with zeros to a 32-bit boundary, so unless a blob
+  // happens to end on one it is already null-terminated in the file and
+  // doesn't need to be copied.
+  if (Buffer && blob + bloblen < Buffer->getBufferEnd() &&
+      blob[bloblen] == '\0')
+    return llvm::StringRef(blob, bloblen);
+
   char *mem = Alloc.Allocate<char>(bloblen + 1);
   memcpy(mem, blob, bloblen);
   // Add a null terminator for those clients accessing the buffer
@@ -256,16 +268,14 @@ public:
 }
 
 CXDiagnosticSet DiagLoader::load(const char *file) {
-  // Open the diagnostics file.
-  std::string ErrStr;
-  FileSystemOptions FO;
-  FileManager FileMgr(FO);
-
+  // Open the diagnostics file. The bitstream doesn't need a null terminator,
+  // which lets large files be mapped rather than read into memory.
   OwningPtr<llvm::MemoryBuffer> Buffer;
-  Buffer.reset(FileMgr.getBufferForFile(file));
-
-  if (!Buffer) {
-    reportBad(CXLoadDiag_CannotLoad, ErrStr);
+  llvm::error_code ec =
+    llvm::MemoryBuffer::getFile(file, Buffer, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
+  if (ec) {
+    reportBad(CXLoadDiag_CannotLoad, ec.message());
     return 0;
   }
 
@@ -288,6 +298,8 @@ CXDiagnosticSet DiagLoader::load(const char *file) {
 
   OwningPtr<CXLoadedDiagnosticSetImpl>
     Diags(new CXLoadedDiagnosticSetImpl());
+  // The diagnostics refer to strings in the file; keep it alive with them.
+  Diags->Buffer.reset(Buffer.take());
 
   while (true) {
     unsigned BlockID = 0;
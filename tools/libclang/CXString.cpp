@@ -88,6 +88,7 @@ void cxstring::disposeCXStringPool(void *p) {
 
 CXStringBuf *cxstring::getCXStringBuf(CXTranslationUnit TU) {
   CXStringPool *pool = static_cast<CXStringPool*>(TU->StringPool);
+  ASTUnit::LazyStateGuard Guard(*static_cast<ASTUnit *>(TU->TUData));
   if (pool->empty())
     return new CXStringBuf(TU);
   CXStringBuf *buf = pool->back();
@@ -97,8 +98,10 @@ CXStringBuf *cxstring::getCXStringBuf(CXTranslationUnit TU) {
 }
 
 void cxstring::disposeCXStringBuf(CXStringBuf *buf) {
-  if (buf)
+  if (buf) {
+    ASTUnit::LazyStateGuard Guard(*static_cast<ASTUnit *>(buf->TU->TUData));
     static_cast<CXStringPool*>(buf->TU->StringPool)->push_back(buf);
+  }
 }
 
 bool cxstring::isManagedByPool(CXString str) {
@@ -2874,5 +2874,25 @@ TEST(NNS, MatchesNestedNameSpecifierPrefixes) {
           specifiesType(asString("struct A")))))));
 }
 
+TEST(MatchFinder, ProfilesEachMatcher) {
+  bool FoundFunction = false;
+  bool FoundCall = false;
+  MatchFinder Finder;
+  Finder.enableProfiling();
+  Finder.addMatcher(functionDecl(hasName("g")),
+                    new VerifyMatch(0, &FoundFunction));
+  Finder.addMatcher(callExpr(hasDescendant(declRefExpr())),
+                    new VerifyMatch(0, &FoundCall));
+  OwningPtr<FrontendActionFactory> Factory(newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(Factory->create(),
+                                     "int f(int); int g(int a) { return f(a); }"));
+  EXPECT_TRUE(FoundFunction);
+  EXPECT_TRUE(FoundCall);
+  EXPECT_EQ(1u, Finder.getProfile(0).NumMatches);
+  EXPECT_EQ(0u, Finder.getProfile(0).NumMemoizationMisses);
+  EXPECT_EQ(1u, Finder.getProfile(1).NumMatches);
+  EXPECT_EQ(1u, Finder.getProfile(1).NumMemoizationMisses);
+}
+
 } // end namespace ast_matchers
 } // end namespace clang
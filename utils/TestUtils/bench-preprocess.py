@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+
+"""
+Time 'clang -cc1 -E' over the inputs in INPUTS/ (or the files given on the
+command line). Run from the clang source directory with the clang to measure
+in your path, or pass --clang.
+"""
+
+import glob
+import optparse
+import os
+import subprocess
+import sys
+import time
+
+def main():
+    parser = optparse.OptionParser("usage: %prog [options] [files...]")
+    parser.add_option("--clang", dest="clang", default="clang",
+                      help="clang executable to run [%default]")
+    parser.add_option("-n", dest="runs", type="int", default=5,
+                      help="number of runs per file; the fastest is reported "
+                           "[%default]")
+    parser.add_option("--extra-arg", dest="extra_args", action="append",
+                      default=[], help="additional argument to pass to -cc1")
+    opts, files = parser.parse_args()
+
+    if not files:
+        files = sorted(glob.glob(os.path.join('INPUTS', '*')))
+
+    devnull = open(os.devnull, 'w')
+    total = 0.0
+    for file in files:
+        cmd = [opts.clang, '-cc1', '-E', '-o', os.devnull] + \
+              opts.extra_args + [file]
+        best = None
+        for i in range(opts.runs):
+            start = time.time()
+            code = subprocess.call(cmd, stdout=devnull, stderr=devnull)
+            elapsed = time.time() - start
+            if code != 0:
+                break
+            if best is None or elapsed < best:
+                best = elapsed
+        if best is None:
+            print '%-40s    failed' % file
+            continue
+        total += best
+        print '%-40s %8.4fs' % (file, best)
+
+    print '%-40s %8.4fs' % ('total', total)
+
+if __name__ == '__main__':
+    main()